@@ -47,5 +47,22 @@ if {[lsearch [get_instances] timer_status_pio] == -1} {
     send_message info "timer_status_pio already exists."
 }
 
+# ---------------------------------------------------------
+# Status change interrupts: any edge on either status PIO is
+# captured and raises f2h_irq0 bit 3 (fsm) / bit 4 (timer), which
+# lcd_msg_app waits on through UIO (--irq) instead of polling
+# ---------------------------------------------------------
+foreach {pio irq} {fsm_status_pio 3 timer_status_pio 4} {
+    set_instance_parameter_value $pio captureEdge true
+    set_instance_parameter_value $pio edgeType ANY
+    set_instance_parameter_value $pio generateIRQ true
+    set_instance_parameter_value $pio irqType EDGE
+    if {[lsearch [get_connections] hps_0.f2h_irq0/$pio.irq] == -1} {
+        send_message info "Connecting $pio.irq to hps_0.f2h_irq0 ($irq)..."
+        add_connection hps_0.f2h_irq0 $pio.irq
+        set_connection_parameter_value hps_0.f2h_irq0/$pio.irq irqNumber $irq
+    }
+}
+
 # Save and exit
 save_system soc_system.qsys
@@ -1,7 +1,11 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "LCD_Driver.h"
 #include "LCD_Hw.h"
+#include "log.h"
 
 #define CMD_DISPLAY_OFF         0xAE
 #define CMD_DISPLAY_ON          0xAF
@@ -13,12 +17,74 @@
 #define CMD_OUTPUT_REVERSE      0xC8
 #define CMD_POWER_CONTROL       0x28
 
+#define DLIST_RUN_MAX           256
+
+static LCDDRV_DLIST *gpRecord = NULL;
+static bool gRecordFailed;
+
+static bool DList_Grow(void **ppBuf, uint32_t *pMax, uint32_t Need, size_t Size) {
+    uint32_t Max = *pMax ? *pMax : 64;
+    void *pNew;
+
+    if (Need <= *pMax) return true;
+    while (Max < Need) Max *= 2;
+    pNew = realloc(*ppBuf, (size_t)Max * Size);
+    if (!pNew) return false;
+    *ppBuf = pNew;
+    *pMax = Max;
+    return true;
+}
+
+// Append to the list being recorded, extending the last run while D/C
+// stays the same and it still fits one FIFO.
+static void DList_Append(uint8_t bIsData, const uint8_t *pData, uint32_t Len) {
+    LCDDRV_DLIST *pList = gpRecord;
+
+    if (gRecordFailed) return;
+    if (!DList_Grow((void **)&pList->pBytes, &pList->nBytesMax, pList->nBytes + Len, 1)) {
+        gRecordFailed = true;
+        return;
+    }
+    while (Len > 0) {
+        LCDDRV_DLIST_RUN *pRun = pList->nRuns ? &pList->pRuns[pList->nRuns - 1] : NULL;
+        uint32_t n;
+
+        if (!pRun || pRun->bIsData != bIsData || pRun->Len == DLIST_RUN_MAX) {
+            if (!DList_Grow((void **)&pList->pRuns, &pList->nRunsMax, pList->nRuns + 1,
+                            sizeof(LCDDRV_DLIST_RUN))) {
+                gRecordFailed = true;
+                return;
+            }
+            pRun = &pList->pRuns[pList->nRuns++];
+            pRun->bIsData = bIsData;
+            pRun->Len = 0;
+            pRun->Offset = pList->nBytes;
+        }
+        n = DLIST_RUN_MAX - pRun->Len;
+        if (n > Len) n = Len;
+        memcpy(pList->pBytes + pList->nBytes, pData, n);
+        pList->nBytes += n;
+        pRun->Len += n;
+        pData += n;
+        Len -= n;
+    }
+}
+
+static void LCD_Send(uint8_t bIsData, const uint8_t *pData, uint32_t Len) {
+    if (gpRecord)
+        DList_Append(bIsData, pData, Len);
+    else if (Len == 1)
+        LCDHW_Write8(bIsData, *pData);
+    else
+        LCDHW_WriteBurst(bIsData, pData, Len);
+}
+
 static void LCD_WriteCmd(uint8_t cmd) {
-    LCDHW_Write8(0, cmd);
+    LCD_Send(0, &cmd, 1);
 }
 
 static void LCD_WriteData(uint8_t data) {
-    LCDHW_Write8(1, data);
+    LCD_Send(1, &data, 1);
 }
 
 void LCDDrv_Display(bool bOn) {
@@ -38,14 +104,26 @@ void LCDDrv_SetColAddr(uint8_t ColAddr) {
     LCD_WriteCmd(CMD_SET_COL_HIGH | ((ColAddr >> 4) & 0x0F));
 }
 
+// Page + column select as three command bytes, for callers that queue
+// them (DMA descriptors) instead of sending them straight away.
+void LCDDrv_EncodeAddr(uint8_t *pCmd, uint8_t PageAddr, uint8_t ColAddr) {
+    pCmd[0] = CMD_SET_PAGE | (PageAddr & 0x0F);
+    pCmd[1] = CMD_SET_COL_LOW | (ColAddr & 0x0F);
+    pCmd[2] = CMD_SET_COL_HIGH | ((ColAddr >> 4) & 0x0F);
+}
+
+void LCDDrv_SetAddr(uint8_t PageAddr, uint8_t ColAddr) {
+    uint8_t cmd[3];
+    LCDDrv_EncodeAddr(cmd, PageAddr, ColAddr);
+    LCD_Send(0, cmd, sizeof(cmd));
+}
+
 void LCDDrv_WriteData(uint8_t Data) {
     LCD_WriteData(Data);
 }
 
 void LCDDrv_WriteMultiData(uint8_t *Data, uint16_t num) {
-    for (uint16_t i = 0; i < num; i++) {
-        LCD_WriteData(Data[i]);
-    }
+    LCD_Send(1, Data, num);
 }
 
 void LCDDrv_SetOuputStatusSelect(bool bNormal) {
@@ -64,4 +142,45 @@ void LCDDrv_ReadModifyWrite_End(void) {}
 void LCDDrv_Reset(void) {}
 void LCDDrv_SetOsc(bool bDefault) {}
 void LCDDrv_SetResistorRatio(uint8_t Value) {}
-void LCDDrv_SetOuputResistorRatio(uint8_t Value) {}
\ No newline at end of file
+void LCDDrv_SetOuputResistorRatio(uint8_t Value) {}
+
+void LCDDrv_DListBegin(LCDDRV_DLIST *pList) {
+    gpRecord = pList;
+    gRecordFailed = false;
+    LCDDrv_DListRewind();
+}
+
+void LCDDrv_DListEnd(void) {
+    if (gpRecord && gRecordFailed) {
+        LOG_Limited(LOG_LEVEL_WARN, "LCD display list: out of memory, list dropped");
+        gpRecord->nBytes = 0;
+        gpRecord->nRuns = 0;
+    }
+    gpRecord = NULL;
+}
+
+// Drop what has been recorded so far, e.g. when a full frame supersedes it
+void LCDDrv_DListRewind(void) {
+    if (gpRecord) {
+        gpRecord->nBytes = 0;
+        gpRecord->nRuns = 0;
+    }
+}
+
+bool LCDDrv_DListRecording(void) {
+    return gpRecord != NULL;
+}
+
+void LCDDrv_DListReplay(const LCDDRV_DLIST *pList) {
+    for (uint32_t i = 0; i < pList->nRuns; i++) {
+        const LCDDRV_DLIST_RUN *pRun = &pList->pRuns[i];
+        LCD_Send(pRun->bIsData, pList->pBytes + pRun->Offset, pRun->Len);
+    }
+}
+
+void LCDDrv_DListFree(LCDDRV_DLIST *pList) {
+    free(pList->pBytes);
+    free(pList->pRuns);
+    free(pList->pFrame);
+    memset(pList, 0, sizeof(*pList));
+}
@@ -8,6 +8,8 @@ void LCDDrv_Display(bool bOn);
 void LCDDrv_SetStartLine(uint8_t StartLine);
 void LCDDrv_SetPageAddr(uint8_t PageAddr);
 void LCDDrv_SetColAddr(uint8_t ColAddr);
+void LCDDrv_SetAddr(uint8_t PageAddr, uint8_t ColAddr);
+void LCDDrv_EncodeAddr(uint8_t *pCmd, uint8_t PageAddr, uint8_t ColAddr);
 void LCDDrv_WriteData(uint8_t Data);
 void LCDDrv_WriteMultiData(uint8_t *Data, uint16_t num);
 void LCDDrv_SetADC(bool bNormal);
@@ -22,4 +24,29 @@ void LCDDrv_SetResistorRatio(uint8_t Value);
 void LCDDrv_SetOuputResistorRatio(uint8_t Value);
 void LCDDrv_SetOuputStatusSelect(bool bNormal);
 
+// Display list: the exact command/data stream for a screen, recorded once
+// with its D/C runs already split (at most 256 bytes each, one SPIM0 TX
+// FIFO) so replaying it is one burst per run with no rasterizing.
+typedef struct {
+    uint8_t  bIsData;
+    uint16_t Len;
+    uint32_t Offset;        // into pBytes
+} LCDDRV_DLIST_RUN;
+
+typedef struct {
+    uint8_t          *pBytes;
+    uint32_t          nBytes, nBytesMax;
+    LCDDRV_DLIST_RUN *pRuns;
+    uint32_t          nRuns, nRunsMax;
+    uint8_t          *pFrame;   // set by LCD_Lib when the list is one full frame
+} LCDDRV_DLIST;
+
+// While a list is being recorded, nothing goes to the panel.
+void LCDDrv_DListBegin(LCDDRV_DLIST *pList);
+void LCDDrv_DListEnd(void);
+void LCDDrv_DListRewind(void);
+bool LCDDrv_DListRecording(void);
+void LCDDrv_DListReplay(const LCDDRV_DLIST *pList);
+void LCDDrv_DListFree(LCDDRV_DLIST *pList);
+
 #endif // _LCD_DRIVER_H_
\ No newline at end of file
@@ -1,13 +1,16 @@
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
+#include <pthread.h>
 #include <fcntl.h>
 #include <sys/mman.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "LCD_Hw.h"
-
-#define HW_REGS_SPAN           0x04000000
-#define HW_REGS_MASK           (HW_REGS_SPAN - 1)
+#include "LCD_HwSpidev.h"
+#include "hps_regs.h"
+#include "trace.h"
+#include "log.h"
 
 #define GPIO1_BASE_OFFSET      0x03709000
 #define GPIO_SWPORTA_DR        0x00
@@ -23,18 +26,93 @@
 
 #define RSTMGR_BASE_OFFSET     0x03D05000
 #define RSTMGR_PERMODRST       0x14
+#define RSTMGR_PERMODRST_DMA   0x10000000
 
 #define HPS_LCM_D_C_BIT        (0x00001000)
 #define HPS_LCM_RESETn_BIT     (0x00008000)
 #define HPS_LCM_BACKLIGHT_BIT  (0x00000100)
 
-#define alt_read_word(addr)        (*(volatile uint32_t *)(addr))
-#define alt_write_word(addr, val)  (*(volatile uint32_t *)(addr) = (val))
-#define alt_setbits_word(addr, bits) (*(volatile uint32_t *)(addr) |= (bits))
-#define alt_clrbits_word(addr, bits) (*(volatile uint32_t *)(addr) &= ~(bits))
+#define SPIM_TXFLR             0x20
+#define SPIM_RXFLR             0x24
+#define SPIM_DMACR             0x4C
+#define SPIM_DMARDLR           0x54
+#define SPIM_SR_BUSY           0x01
+#define SPIM_SR_TFNF           0x02
+#define SPIM_SR_TFE            0x04
+#define SPIM_TX_FIFO_DEPTH     256
+#define LCD_SPI_HZ             3125000   // 200 MHz spi_m_clk / BAUDR 64, as LCDHW_Init
 
-static void *lcd_virtual_base = NULL;
+// HPS DMA-330 (secure view at 0xFFE01000). The channel program and the
+// byte staging area live in on-chip RAM, which the DMAC can address
+// without needing physical pages from Linux.
+#define DMA_BASE_OFFSET        0x03E01000
+#define DMA_FSRC               0x034
+#define DMA_FTR(ch)            (0x040 + (ch) * 4)
+#define DMA_CS(ch)             (0x100 + (ch) * 8)
+#define DMA_CPC(ch)            (0x104 + (ch) * 8)
+#define DMA_DBGSTATUS          0xD00
+#define DMA_DBGCMD             0xD04
+#define DMA_DBGINST0           0xD08
+#define DMA_DBGINST1           0xD0C
+#define DMA_CS_STOPPED         0x0
+#define DMA_CS_FAULTING        0xF
+#define DMA_CS_STATE_MASK      0xF
+
+#define LCD_DMA_CHANNEL        7      // top channel, least likely to be claimed by the kernel pl330 driver
+#define LCD_DMA_PERIPH_SPIM0_RX 17
+
+#define OCRAM_BASE_OFFSET      0x03FF0000
+#define LCD_DMA_OCRAM_OFS      0x8000 // second half of the 64 KB OCRAM
+#define LCD_DMA_DC_CMD_OFS     0x0000 // GPIO1 DR image with D/C low
+#define LCD_DMA_DC_DATA_OFS    0x0004 // GPIO1 DR image with D/C high
+#define LCD_DMA_RX_SINK_OFS    0x0008
+#define LCD_DMA_PROG_OFS       0x0100
+#define LCD_DMA_PROG_MAX       0x0F00
+#define LCD_DMA_STAGE_OFS      0x1000
+#define LCD_DMA_STAGE_MAX      0x1000
+
+// DMA-330 instruction encodings used by the channel program
+#define DMA_OP_END             0x00
+#define DMA_OP_KILL            0x01
+#define DMA_OP_LD              0x04
+#define DMA_OP_ST              0x08
+#define DMA_OP_RMB             0x12
+#define DMA_OP_WMB             0x13
+#define DMA_OP_LP0             0x20
+#define DMA_OP_LDPS            0x25
+#define DMA_OP_WFPS            0x30
+#define DMA_OP_FLUSHP          0x35
+#define DMA_OP_LPEND0          0x38
+#define DMA_OP_GO              0xA0
+#define DMA_OP_MOV             0xBC
+#define DMA_MOV_SAR            0
+#define DMA_MOV_CCR            1
+#define DMA_MOV_DAR            2
+
+#define DMA_CCR_SRC_INC        0x00000001
+#define DMA_CCR_WORD           ((2u << 1) | (2u << 15))   // 4-byte source and destination beats
+
+static bool gHwInit = false;
 static const uint32_t SPIM_WAIT_MAX_ITER = 1000000u;
+static uint8_t bPreIsData = 0xFF;
+static bool gUseSpidev = false;
+static uint32_t gPanelEpoch;     // bumped whenever the panel contents become unknown
+
+static bool gDmaReady = false;
+static bool gDmaBusy = false;
+static bool gTxBusy = false;       // a transmit-thread transfer not yet retired
+static uint64_t gTxBytes;          // every byte handed to a transmit path
+static uint8_t gDmaEndIsData;
+static LCDHW_DMA_DONE gpfnDmaDone;
+static void *gDmaDoneContext;
+
+static void TxStop(void);
+
+// Addresses below are offsets into the HPS register window (hps_regs.h)
+#define alt_read_word(addr)        HPSREG_Read32(addr)
+#define alt_write_word(addr, val)  HPSREG_Write32((addr), (val))
+#define alt_setbits_word(addr, bits) alt_write_word(addr, alt_read_word(addr) | (bits))
+#define alt_clrbits_word(addr, bits) alt_write_word(addr, alt_read_word(addr) & ~(bits))
 
 static bool SPIM_WaitStatusBits(uint32_t spim0_addr, uint32_t mask, bool wait_set) {
     for (uint32_t i = 0; i < SPIM_WAIT_MAX_ITER; i++) {
@@ -48,14 +126,12 @@ static bool SPIM_WaitStatusBits(uint32_t spim0_addr, uint32_t mask, bool wait_se
     return false;
 }
 
-void LCDHW_Init(void *virtual_base) {
-    lcd_virtual_base = virtual_base;
-    
-    uint32_t gpio1_addr = (uint32_t)virtual_base + GPIO1_BASE_OFFSET;
-    uint32_t spim0_addr = (uint32_t)virtual_base + SPIM0_BASE_OFFSET;
-    uint32_t rstmgr_addr = (uint32_t)virtual_base + RSTMGR_BASE_OFFSET;
+void LCDHW_Init(void) {
+    uint32_t gpio1_addr = GPIO1_BASE_OFFSET;
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
+    uint32_t rstmgr_addr = RSTMGR_BASE_OFFSET;
 
-    printf("LCDHW_Init: Base=%p\n", virtual_base);
+    LOG_Info("LCDHW_Init: registers via %s", gpHpsRegOps->pName);
 
     alt_setbits_word(gpio1_addr + GPIO_SWPORTA_DDR, HPS_LCM_RESETn_BIT);
     alt_clrbits_word(gpio1_addr + GPIO_SWPORTA_DR, HPS_LCM_RESETn_BIT);
@@ -83,12 +159,40 @@ void LCDHW_Init(void *virtual_base) {
     alt_write_word(spim0_addr + SPIM_SER, 1);
     alt_setbits_word(spim0_addr + SPIM_SSIENR, 1);
 
-    printf("LCD Hardware Initialized.\n");
+    bPreIsData = 0xFF;
+    gPanelEpoch++;
+    gHwInit = true;
+    LOG_Info("LCD Hardware Initialized.");
+}
+
+// Alternative to LCDHW_Init: hand the panel to the kernel spidev driver.
+bool LCDHW_InitSpidev(const char *pSpiDev, const char *pGpioChip) {
+    if (!LCDSPI_Open(pSpiDev, pGpioChip, LCD_SPI_HZ))
+        return false;
+    gUseSpidev = true;
+    gPanelEpoch++;
+    LOG_Info("LCD Hardware Initialized (spidev).");
+    return true;
+}
+
+void LCDHW_Close(void) {
+    TxStop();
+    if (gUseSpidev) {
+        LCDSPI_Close();
+        gUseSpidev = false;
+    }
 }
 
 void LCDHW_BackLight(bool bON) {
-    if (!lcd_virtual_base) return;
-    uint32_t gpio1_addr = (uint32_t)lcd_virtual_base + GPIO1_BASE_OFFSET;
+    if (gTxBusy) LCDHW_TxWait();
+    if (gUseSpidev) {
+        LCDSPI_BackLight(bON);
+        return;
+    }
+    if (!gHwInit) return;
+    // A running channel program rewrites the whole DR to move D/C
+    if (gDmaBusy) LCDHW_DmaWait();
+    uint32_t gpio1_addr = GPIO1_BASE_OFFSET;
 
     if (bON)
         alt_setbits_word(gpio1_addr + GPIO_SWPORTA_DR, HPS_LCM_BACKLIGHT_BIT);
@@ -96,30 +200,35 @@ void LCDHW_BackLight(bool bON) {
         alt_clrbits_word(gpio1_addr + GPIO_SWPORTA_DR, HPS_LCM_BACKLIGHT_BIT);
 }
 
+// A wedged SPIM times out on every byte of every frame, hence the rate
+// limit on these messages
 static void SPIM_WriteTxData(uint8_t Data) {
-    uint32_t spim0_addr = (uint32_t)lcd_virtual_base + SPIM0_BASE_OFFSET;
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
 
     if (!SPIM_WaitStatusBits(spim0_addr, 0x4, true)) {
-        printf("LCD SPI timeout before TX (SR=0x%08X)\n", alt_read_word(spim0_addr + SPIM_SR));
+        TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_TX, alt_read_word(spim0_addr + SPIM_SR));
+        LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout before TX (SR=0x%08X)", alt_read_word(spim0_addr + SPIM_SR));
         return;
     }
 
     alt_write_word(spim0_addr + SPIM_DR, Data);
 
     if (!SPIM_WaitStatusBits(spim0_addr, 0x4, true)) {
-        printf("LCD SPI timeout after TX-ready check (SR=0x%08X, Data=0x%02X)\n",
-               alt_read_word(spim0_addr + SPIM_SR), Data);
+        TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_TX_READY, alt_read_word(spim0_addr + SPIM_SR));
+        LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout after TX-ready check (SR=0x%08X, Data=0x%02X)",
+                    alt_read_word(spim0_addr + SPIM_SR), Data);
         return;
     }
 
     if (!SPIM_WaitStatusBits(spim0_addr, 0x1, false)) {
-        printf("LCD SPI timeout waiting BUSY clear (SR=0x%08X, Data=0x%02X)\n",
-               alt_read_word(spim0_addr + SPIM_SR), Data);
+        TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_BUSY, alt_read_word(spim0_addr + SPIM_SR));
+        LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout waiting BUSY clear (SR=0x%08X, Data=0x%02X)",
+                    alt_read_word(spim0_addr + SPIM_SR), Data);
     }
 }
 
 static void PIO_DC_Set(bool bIsData) {
-    uint32_t gpio1_addr = (uint32_t)lcd_virtual_base + GPIO1_BASE_OFFSET;
+    uint32_t gpio1_addr = GPIO1_BASE_OFFSET;
 
     if (bIsData)
         alt_setbits_word(gpio1_addr + GPIO_SWPORTA_DR, HPS_LCM_D_C_BIT);
@@ -128,10 +237,445 @@ static void PIO_DC_Set(bool bIsData) {
 }
 
 void LCDHW_Write8(uint8_t bIsData, uint8_t Data) {
-    static uint8_t bPreIsData = 0xFF;
+    if (gTxBusy) LCDHW_TxWait();
+    gTxBytes++;
+    if (gUseSpidev) {
+        LCDSPI_Write(bIsData, &Data, 1);
+        return;
+    }
+    if (gDmaBusy) LCDHW_DmaWait();
     if (bPreIsData != bIsData) {
         PIO_DC_Set(bIsData);
         bPreIsData = bIsData;
     }
     SPIM_WriteTxData(Data);
 }
+
+static bool SPIM_WaitIdle(uint32_t spim0_addr) {
+    return SPIM_WaitStatusBits(spim0_addr, SPIM_SR_TFE, true) &&
+           SPIM_WaitStatusBits(spim0_addr, SPIM_SR_BUSY, false);
+}
+
+// Streams Len bytes with one D/C level, keeping the TX FIFO full instead of
+// waiting for each byte to leave the shifter. The panel samples D/C on the
+// last SCLK edge of every byte, so the line is only moved once the FIFO has
+// drained, and the call returns with SPIM0 idle.
+static void WriteBurst(uint8_t bIsData, const uint8_t *pData, uint32_t Len) {
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
+    uint32_t room = 0;
+
+    if (gUseSpidev) {
+        LCDSPI_Write(bIsData, pData, Len);
+        return;
+    }
+
+    if (bPreIsData != bIsData) {
+        if (!SPIM_WaitIdle(spim0_addr)) {
+            TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_DC, alt_read_word(spim0_addr + SPIM_SR));
+            LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout before D/C change (SR=0x%08X)",
+                        alt_read_word(spim0_addr + SPIM_SR));
+            return;
+        }
+        PIO_DC_Set(bIsData);
+        bPreIsData = bIsData;
+    }
+
+    while (Len > 0) {
+        if (room == 0) {
+            if (!SPIM_WaitStatusBits(spim0_addr, SPIM_SR_TFNF, true)) {
+                TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_FIFO, alt_read_word(spim0_addr + SPIM_SR));
+                LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout waiting TX FIFO space (SR=0x%08X)",
+                            alt_read_word(spim0_addr + SPIM_SR));
+                return;
+            }
+            // TXFLR only falls behind our back, so this is a safe lower bound
+            room = SPIM_TX_FIFO_DEPTH - alt_read_word(spim0_addr + SPIM_TXFLR);
+            if (room == 0) room = 1;
+        }
+        alt_write_word(spim0_addr + SPIM_DR, *pData++);
+        room--;
+        Len--;
+    }
+
+    if (!SPIM_WaitIdle(spim0_addr)) {
+        TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_DRAIN, alt_read_word(spim0_addr + SPIM_SR));
+        LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout draining burst (SR=0x%08X)", alt_read_word(spim0_addr + SPIM_SR));
+    }
+}
+
+void LCDHW_WriteBurst(uint8_t bIsData, const uint8_t *pData, uint32_t Len) {
+    if (Len == 0) return;
+    if (gTxBusy) LCDHW_TxWait();
+    if (gDmaBusy) LCDHW_DmaWait();
+    gTxBytes += Len;
+    WriteBurst(bIsData, pData, Len);
+}
+
+// ---------------------------------------------------------------------------
+// DMA frame transfer
+//
+// The whole descriptor list becomes one DMA-330 channel program. For each
+// descriptor it stores the bytes into the SPIM0 TX FIFO (at most one FIFO's
+// worth, so no flow control is needed), then collects the same number of RX
+// entries through the SPIM0 RX handshake. SPIM0 runs in TX+RX mode for this,
+// and an RX entry only appears once its byte has fully left the shifter,
+// so after the last one the program can safely rewrite GPIO1 DR to move
+// D/C for the next descriptor. The CPU only starts the channel and later
+// checks that it stopped.
+
+static uint8_t gDmaProg[LCD_DMA_PROG_MAX];
+static int gDmaProgLen;
+
+static uint32_t DMA_Ocram(uint32_t Ofs) {
+    return OCRAM_BASE_OFFSET + LCD_DMA_OCRAM_OFS + Ofs;
+}
+
+static uint32_t DMA_Phys(uint32_t Ofs) {
+    return HW_REGS_BASE + OCRAM_BASE_OFFSET + LCD_DMA_OCRAM_OFS + Ofs;
+}
+
+static void DMA_Emit(uint8_t b) {
+    if (gDmaProgLen < LCD_DMA_PROG_MAX)
+        gDmaProg[gDmaProgLen] = b;
+    gDmaProgLen++;
+}
+
+static void DMA_EmitMov(uint8_t Reg, uint32_t Value) {
+    DMA_Emit(DMA_OP_MOV);
+    DMA_Emit(Reg);
+    for (int i = 0; i < 4; i++)
+        DMA_Emit((uint8_t)(Value >> (8 * i)));
+}
+
+// DMALP lc0, Count; Body; DMALPEND lc0
+static void DMA_EmitLoop(uint16_t Count, const uint8_t *pBody, int BodyLen) {
+    DMA_Emit(DMA_OP_LP0);
+    DMA_Emit((uint8_t)(Count - 1));
+    for (int i = 0; i < BodyLen; i++)
+        DMA_Emit(pBody[i]);
+    DMA_Emit(DMA_OP_LPEND0);
+    DMA_Emit((uint8_t)BodyLen);
+}
+
+// Copy to OCRAM as whole words; the bridge mapping is uncached.
+static void DMA_CopyToOcram(uint32_t Ofs, const uint8_t *pSrc, int Len) {
+    for (int i = 0; i < Len; i += 4) {
+        uint32_t word = 0;
+        for (int b = 0; b < 4 && i + b < Len; b++)
+            word |= (uint32_t)pSrc[i + b] << (8 * b);
+        alt_write_word(DMA_Ocram(Ofs + i), word);
+    }
+}
+
+bool LCDHW_DmaInit(void) {
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
+    uint32_t rstmgr_addr = RSTMGR_BASE_OFFSET;
+
+    if (!gHwInit || gUseSpidev) return false;
+    if (gTxBusy) LCDHW_TxWait();
+
+    alt_clrbits_word(rstmgr_addr + RSTMGR_PERMODRST, RSTMGR_PERMODRST_DMA);
+
+    // TMOD = transmit and receive, so completed bytes show up in the RX FIFO
+    alt_clrbits_word(spim0_addr + SPIM_SSIENR, 1);
+    alt_clrbits_word(spim0_addr + SPIM_CTLR0, 0x3 << 8);
+    alt_write_word(spim0_addr + SPIM_DMARDLR, 0);
+    alt_write_word(spim0_addr + SPIM_DMACR, 0x1);   // RDMAE
+    alt_setbits_word(spim0_addr + SPIM_SSIENR, 1);
+
+    gDmaReady = true;
+    LOG_Info("LCD DMA ready (DMA-330 channel %d, OCRAM +0x%04X).",
+             LCD_DMA_CHANNEL, LCD_DMA_OCRAM_OFS);
+    return true;
+}
+
+// Back to the transmit-only setup LCDHW_Init programs
+void LCDHW_DmaRelease(void) {
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
+
+    if (!gDmaReady) return;
+    LCDHW_DmaWait();
+    SPIM_WaitIdle(spim0_addr);
+    alt_clrbits_word(spim0_addr + SPIM_SSIENR, 1);
+    alt_write_word(spim0_addr + SPIM_DMACR, 0);
+    alt_setbits_word(spim0_addr + SPIM_CTLR0, 1 << 8);
+    alt_setbits_word(spim0_addr + SPIM_SSIENR, 1);
+    gDmaReady = false;
+}
+
+static bool DMA_BuildProgram(const LCDHW_DMA_DESC *pDesc, int nDesc, uint8_t bIsData) {
+    static const uint8_t tx_body[] = { DMA_OP_LD, DMA_OP_ST };
+    static const uint8_t rx_body[] = {
+        DMA_OP_WFPS, LCD_DMA_PERIPH_SPIM0_RX << 3,
+        DMA_OP_LDPS, LCD_DMA_PERIPH_SPIM0_RX << 3,
+        DMA_OP_ST
+    };
+    const uint32_t spim_dr = HW_REGS_BASE + SPIM0_BASE_OFFSET + SPIM_DR;
+    const uint32_t gpio_dr = HW_REGS_BASE + GPIO1_BASE_OFFSET + GPIO_SWPORTA_DR;
+    uint32_t stage = 0;
+
+    gDmaProgLen = 0;
+    DMA_Emit(DMA_OP_FLUSHP);
+    DMA_Emit(LCD_DMA_PERIPH_SPIM0_RX << 3);
+
+    for (int d = 0; d < nDesc; d++) {
+        if (pDesc[d].Len == 0 || pDesc[d].Len > SPIM_TX_FIFO_DEPTH)
+            return false;
+
+        if (pDesc[d].bIsData != bIsData) {
+            bIsData = pDesc[d].bIsData;
+            DMA_Emit(DMA_OP_RMB);
+            DMA_EmitMov(DMA_MOV_CCR, DMA_CCR_WORD);
+            DMA_EmitMov(DMA_MOV_SAR, DMA_Phys(bIsData ? LCD_DMA_DC_DATA_OFS : LCD_DMA_DC_CMD_OFS));
+            DMA_EmitMov(DMA_MOV_DAR, gpio_dr);
+            DMA_Emit(DMA_OP_LD);
+            DMA_Emit(DMA_OP_ST);
+            DMA_Emit(DMA_OP_WMB);
+        }
+
+        DMA_EmitMov(DMA_MOV_CCR, DMA_CCR_SRC_INC);
+        DMA_EmitMov(DMA_MOV_SAR, DMA_Phys(LCD_DMA_STAGE_OFS + stage));
+        DMA_EmitMov(DMA_MOV_DAR, spim_dr);
+        DMA_EmitLoop(pDesc[d].Len, tx_body, sizeof(tx_body));
+
+        DMA_EmitMov(DMA_MOV_CCR, 0);
+        DMA_EmitMov(DMA_MOV_SAR, spim_dr);
+        DMA_EmitMov(DMA_MOV_DAR, DMA_Phys(LCD_DMA_RX_SINK_OFS));
+        DMA_EmitLoop(pDesc[d].Len, rx_body, sizeof(rx_body));
+
+        stage += pDesc[d].Len;
+    }
+    DMA_Emit(DMA_OP_WMB);
+    DMA_Emit(DMA_OP_END);
+
+    return gDmaProgLen <= LCD_DMA_PROG_MAX && stage <= LCD_DMA_STAGE_MAX;
+}
+
+bool LCDHW_DmaSubmit(const LCDHW_DMA_DESC *pDesc, int nDesc, LCDHW_DMA_DONE pfnDone, void *pContext) {
+    uint32_t spim0_addr = SPIM0_BASE_OFFSET;
+    uint32_t gpio1_addr = GPIO1_BASE_OFFSET;
+    uint32_t dma_addr = DMA_BASE_OFFSET;
+    uint32_t stage = 0, dr, go_addr;
+
+    if (!gDmaReady || nDesc <= 0) return false;
+    if (gDmaBusy) LCDHW_DmaWait();
+
+    // Anything still queued by the PIO paths must be out before the program
+    // starts counting RX entries, and their RX leftovers must be discarded.
+    if (!SPIM_WaitIdle(spim0_addr)) {
+        TRACE_Record(TRACE_SPI_TIMEOUT, TRACE_AT_DMA, alt_read_word(spim0_addr + SPIM_SR));
+        LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout before DMA submit (SR=0x%08X)", alt_read_word(spim0_addr + SPIM_SR));
+        return false;
+    }
+    for (uint32_t n = alt_read_word(spim0_addr + SPIM_RXFLR); n > 0; n--)
+        (void)alt_read_word(spim0_addr + SPIM_DR);
+
+    if (bPreIsData > 1) {
+        PIO_DC_Set(pDesc[0].bIsData);
+        bPreIsData = pDesc[0].bIsData;
+    }
+    if (!DMA_BuildProgram(pDesc, nDesc, bPreIsData)) {
+        LOG_Limited(LOG_LEVEL_WARN, "LCD DMA descriptor list does not fit (prog=%d bytes)", gDmaProgLen);
+        return false;
+    }
+
+    dr = alt_read_word(gpio1_addr + GPIO_SWPORTA_DR);
+    alt_write_word(DMA_Ocram(LCD_DMA_DC_CMD_OFS), dr & ~HPS_LCM_D_C_BIT);
+    alt_write_word(DMA_Ocram(LCD_DMA_DC_DATA_OFS), dr | HPS_LCM_D_C_BIT);
+    DMA_CopyToOcram(LCD_DMA_PROG_OFS, gDmaProg, gDmaProgLen);
+    for (int d = 0; d < nDesc; d++) {
+        DMA_CopyToOcram(LCD_DMA_STAGE_OFS + stage, pDesc[d].pData, pDesc[d].Len);
+        stage += pDesc[d].Len;
+    }
+
+    for (uint32_t i = 0; alt_read_word(dma_addr + DMA_DBGSTATUS) & 0x1; i++) {
+        if (i == SPIM_WAIT_MAX_ITER) {
+            LOG_Limited(LOG_LEVEL_WARN, "LCD DMA debug interface busy");
+            return false;
+        }
+    }
+    // DMAGO issued through the manager thread's debug instruction registers
+    go_addr = DMA_Phys(LCD_DMA_PROG_OFS);
+    alt_write_word(dma_addr + DMA_DBGINST0, ((uint32_t)LCD_DMA_CHANNEL << 24) | ((uint32_t)DMA_OP_GO << 16));
+    alt_write_word(dma_addr + DMA_DBGINST1, go_addr);
+
+    gpfnDmaDone = pfnDone;
+    gDmaDoneContext = pContext;
+    gDmaEndIsData = pDesc[nDesc - 1].bIsData;
+    gDmaBusy = true;
+    gTxBytes += stage;
+    TRACE_Record(TRACE_DMA_SUBMIT, (uint16_t)nDesc, stage);
+    alt_write_word(dma_addr + DMA_DBGCMD, 0);
+    return true;
+}
+
+// DMAKILL on the channel thread returns it to Stopped
+static void DMA_Kill(void) {
+    uint32_t dma_addr = DMA_BASE_OFFSET;
+
+    alt_write_word(dma_addr + DMA_DBGINST0,
+                   ((uint32_t)DMA_OP_KILL << 16) | (LCD_DMA_CHANNEL << 8) | 0x1);
+    alt_write_word(dma_addr + DMA_DBGCMD, 0);
+    bPreIsData = 0xFF;   // D/C level unknown, force a rewrite
+    gPanelEpoch++;       // and so is how much of the transfer got out
+}
+
+// The channel is stopped: the transfer is over, done (bOk) or not
+static void DMA_Retire(bool bOk) {
+    LCDHW_DMA_DONE pfnDone = gpfnDmaDone;
+
+    gDmaBusy = false;
+    TRACE_Record(TRACE_DMA_DONE, 0, 0);
+    gpfnDmaDone = NULL;
+    if (pfnDone) pfnDone(gDmaDoneContext, bOk);
+}
+
+bool LCDHW_DmaBusy(void) {
+    uint32_t dma_addr = DMA_BASE_OFFSET;
+    uint32_t state;
+
+    if (!gDmaBusy) return false;
+    state = alt_read_word(dma_addr + DMA_CS(LCD_DMA_CHANNEL)) & DMA_CS_STATE_MASK;
+    if (state != DMA_CS_STOPPED && state != DMA_CS_FAULTING)
+        return true;
+
+    if (alt_read_word(dma_addr + DMA_FSRC) & (1u << LCD_DMA_CHANNEL)) {
+        LOG_Limited(LOG_LEVEL_ERROR, "LCD DMA channel fault (FTR=0x%08X, CPC=0x%08X)",
+                    alt_read_word(dma_addr + DMA_FTR(LCD_DMA_CHANNEL)),
+                    alt_read_word(dma_addr + DMA_CPC(LCD_DMA_CHANNEL)));
+        DMA_Kill();
+        DMA_Retire(false);
+        return false;
+    }
+    bPreIsData = gDmaEndIsData;
+    DMA_Retire(true);
+    return false;
+}
+
+void LCDHW_DmaWait(void) {
+    for (uint32_t i = 0; i < SPIM_WAIT_MAX_ITER; i++) {
+        if (!LCDHW_DmaBusy()) return;
+    }
+    // Stop the channel rather than leave it owning the SPI with gDmaBusy
+    // set, which would send every later write here again
+    DMA_Kill();
+    DMA_Retire(false);
+    LOG_Limited(LOG_LEVEL_WARN, "LCD DMA timeout waiting for channel stop, channel killed");
+}
+
+// ---------------------------------------------------------------------------
+// Transmit thread
+//
+// Without the DMA engine (PIO and spidev) the same descriptor list is
+// written by a thread through the burst path, so the caller can draw the
+// next frame meanwhile. Nothing is staged: the thread reads every pData
+// in place until the transfer retires. The descriptors themselves are
+// copied. Every other entry point that touches the bus waits for the
+// thread first, as it does for the DMA channel. Completion is reported
+// from LCDHW_TxBusy/LCDHW_TxWait, on the caller's thread.
+
+static pthread_t gTxThread;
+static pthread_mutex_t gTxLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gTxCond = PTHREAD_COND_INITIALIZER;
+static bool gTxStarted;
+static bool gTxQueued, gTxQuit;         // under gTxLock
+static LCDHW_DMA_DESC gTxDesc[LCDHW_TX_DESC_MAX];
+static int gTxDescCount;
+static LCDHW_DMA_DONE gpfnTxDone;
+static void *gTxDoneContext;
+
+static void *TxThread(void *pArg) {
+    (void)pArg;
+    pthread_mutex_lock(&gTxLock);
+    for (;;) {
+        while (!gTxQueued && !gTxQuit)
+            pthread_cond_wait(&gTxCond, &gTxLock);
+        if (!gTxQueued) break;
+        pthread_mutex_unlock(&gTxLock);
+        for (int d = 0; d < gTxDescCount; d++)
+            WriteBurst(gTxDesc[d].bIsData, gTxDesc[d].pData, gTxDesc[d].Len);
+        pthread_mutex_lock(&gTxLock);
+        gTxQueued = false;
+        pthread_cond_broadcast(&gTxCond);
+    }
+    pthread_mutex_unlock(&gTxLock);
+    return NULL;
+}
+
+bool LCDHW_TxSubmit(const LCDHW_DMA_DESC *pDesc, int nDesc, LCDHW_DMA_DONE pfnDone, void *pContext) {
+    uint32_t stage = 0;
+
+    if ((!gHwInit && !gUseSpidev) || gDmaReady || nDesc <= 0 || nDesc > LCDHW_TX_DESC_MAX)
+        return false;
+    if (gTxBusy) LCDHW_TxWait();
+    if (!gTxStarted) {
+        if (pthread_create(&gTxThread, NULL, TxThread, NULL) != 0) {
+            LOG_Limited(LOG_LEVEL_WARN, "LCD transmit thread unavailable, sending frames inline");
+            return false;
+        }
+        gTxStarted = true;
+    }
+    for (int d = 0; d < nDesc; d++)
+        stage += pDesc[d].Len;
+
+    gpfnTxDone = pfnDone;
+    gTxDoneContext = pContext;
+    gTxBusy = true;
+    gTxBytes += stage;
+    pthread_mutex_lock(&gTxLock);
+    memcpy(gTxDesc, pDesc, nDesc * sizeof(*pDesc));
+    gTxDescCount = nDesc;
+    gTxQueued = true;
+    pthread_cond_broadcast(&gTxCond);
+    pthread_mutex_unlock(&gTxLock);
+    return true;
+}
+
+static void TxRetire(void) {
+    LCDHW_DMA_DONE pfnDone = gpfnTxDone;
+
+    gTxBusy = false;
+    gpfnTxDone = NULL;
+    if (pfnDone) pfnDone(gTxDoneContext, true);
+}
+
+bool LCDHW_TxBusy(void) {
+    bool bQueued;
+
+    if (!gTxBusy) return false;
+    pthread_mutex_lock(&gTxLock);
+    bQueued = gTxQueued;
+    pthread_mutex_unlock(&gTxLock);
+    if (bQueued) return true;
+    TxRetire();
+    return false;
+}
+
+void LCDHW_TxWait(void) {
+    if (!gTxBusy) return;
+    pthread_mutex_lock(&gTxLock);
+    while (gTxQueued)
+        pthread_cond_wait(&gTxCond, &gTxLock);
+    pthread_mutex_unlock(&gTxLock);
+    TxRetire();
+}
+
+static void TxStop(void) {
+    if (!gTxStarted) return;
+    LCDHW_TxWait();
+    pthread_mutex_lock(&gTxLock);
+    gTxQuit = true;
+    pthread_cond_broadcast(&gTxCond);
+    pthread_mutex_unlock(&gTxLock);
+    pthread_join(gTxThread, NULL);
+    gTxStarted = false;
+    gTxQuit = false;
+}
+
+uint64_t LCDHW_TxBytes(void) {
+    return gTxBytes;
+}
+
+uint32_t LCDHW_PanelEpoch(void) {
+    return gPanelEpoch;
+}
@@ -4,8 +4,47 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-void LCDHW_Init(void *virtual_base);
+void LCDHW_Init(void);
+bool LCDHW_InitSpidev(const char *pSpiDev, const char *pGpioChip);
+void LCDHW_Close(void);
 void LCDHW_BackLight(bool bON);
 void LCDHW_Write8(uint8_t bIsData, uint8_t Data);
+void LCDHW_WriteBurst(uint8_t bIsData, const uint8_t *pData, uint32_t Len);
+uint64_t LCDHW_TxBytes(void);      // running count of bytes sent to the panel
+
+// Changes whenever the panel contents become unknown: after the reset in
+// LCDHW_Init/LCDHW_InitSpidev and after a DMA transfer is killed. Anything
+// that mirrors display RAM is stale once this moves.
+uint32_t LCDHW_PanelEpoch(void);
+
+// One D/C run for the DMA engine; Len is 1..256 (one SPIM0 TX FIFO).
+typedef struct {
+    uint8_t        bIsData;
+    uint16_t       Len;
+    const uint8_t *pData;
+} LCDHW_DMA_DESC;
+
+// bOk is false when the channel faulted or was killed after a timeout:
+// the panel then holds an unknown part of the transfer.
+typedef void (*LCDHW_DMA_DONE)(void *pContext, bool bOk);
+
+// The descriptor bytes are copied out before LCDHW_DmaSubmit returns.
+// LCDHW_DmaBusy polls the channel and runs the completion callback once.
+bool LCDHW_DmaInit(void);
+void LCDHW_DmaRelease(void);
+bool LCDHW_DmaSubmit(const LCDHW_DMA_DESC *pDesc, int nDesc, LCDHW_DMA_DONE pfnDone, void *pContext);
+bool LCDHW_DmaBusy(void);
+void LCDHW_DmaWait(void);
+
+// Transmit thread for PIO and spidev: the same descriptors, written by a
+// thread through the burst path. Unlike the DMA engine it does not copy
+// the bytes: every pData must stay unchanged until the completion
+// callback, which LCDHW_TxBusy/LCDHW_TxWait run on the caller's thread.
+// Any other write waits for the thread. Refused while DMA is set up.
+#define LCDHW_TX_DESC_MAX   32
+
+bool LCDHW_TxSubmit(const LCDHW_DMA_DESC *pDesc, int nDesc, LCDHW_DMA_DONE pfnDone, void *pContext);
+bool LCDHW_TxBusy(void);
+void LCDHW_TxWait(void);
 
 #endif // _LCD_HW_H_
\ No newline at end of file
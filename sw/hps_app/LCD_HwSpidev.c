@@ -0,0 +1,183 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include <linux/gpio.h>
+#include "LCD_HwSpidev.h"
+#include "log.h"
+
+// GPIO1 line offsets, the same bits LCD_Hw.c drives through SWPORTA_DR
+#define LCM_LINE_BACKLIGHT     8
+#define LCM_LINE_D_C           12
+#define LCM_LINE_RESETn        15
+
+enum { LINE_D_C, LINE_RESETn, LINE_BACKLIGHT, LINE_COUNT };
+
+static int gSpiFd = -1;
+static int gLineFd = -1;
+static bool gStreamOnly;           // target is not a spidev node
+static uint32_t gSpeedHz;
+static uint8_t gLineValues[LINE_COUNT];
+static uint8_t gPreIsData = 0xFF;
+static LCDSPI_STATS gStats;
+
+static bool SetLines(void) {
+    struct gpiohandle_data data;
+
+    if (gLineFd < 0) return true;
+    memset(&data, 0, sizeof(data));
+    memcpy(data.values, gLineValues, LINE_COUNT);
+    if (ioctl(gLineFd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data) < 0) {
+        perror("LCDSPI: GPIOHANDLE_SET_LINE_VALUES");
+        return false;
+    }
+    return true;
+}
+
+static bool OpenLines(const char *pGpioChip) {
+    struct gpiohandle_request req;
+    int chip_fd = open(pGpioChip, O_RDWR | O_CLOEXEC);
+
+    if (chip_fd < 0) {
+        perror("LCDSPI: cannot open GPIO chip");
+        return false;
+    }
+    memset(&req, 0, sizeof(req));
+    req.lineoffsets[LINE_D_C] = LCM_LINE_D_C;
+    req.lineoffsets[LINE_RESETn] = LCM_LINE_RESETn;
+    req.lineoffsets[LINE_BACKLIGHT] = LCM_LINE_BACKLIGHT;
+    req.lines = LINE_COUNT;
+    req.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    req.default_values[LINE_D_C] = 0;
+    req.default_values[LINE_RESETn] = 1;
+    req.default_values[LINE_BACKLIGHT] = 0;
+    strncpy(req.consumer_label, "lcd_msg_app", sizeof(req.consumer_label) - 1);
+
+    if (ioctl(chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &req) < 0) {
+        perror("LCDSPI: GPIO_GET_LINEHANDLE");
+        close(chip_fd);
+        return false;
+    }
+    close(chip_fd);
+    gLineFd = req.fd;
+    memcpy(gLineValues, req.default_values, LINE_COUNT);
+    return true;
+}
+
+bool LCDSPI_Open(const char *pSpiDev, const char *pGpioChip, uint32_t SpeedHz) {
+    uint8_t mode = SPI_MODE_0, bits = 8;
+
+    LCDSPI_Close();
+    gSpiFd = open(pSpiDev, O_WRONLY | O_CLOEXEC);
+    if (gSpiFd < 0) {
+        perror("LCDSPI: cannot open SPI device");
+        return false;
+    }
+
+    gStreamOnly = false;
+    if (ioctl(gSpiFd, SPI_IOC_WR_MODE, &mode) < 0) {
+        if (errno != ENOTTY && errno != EINVAL) {
+            perror("LCDSPI: SPI_IOC_WR_MODE");
+            LCDSPI_Close();
+            return false;
+        }
+        gStreamOnly = true;
+        printf("LCDSPI: %s is not a spidev node, streaming with write()\n", pSpiDev);
+    } else if (ioctl(gSpiFd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+               ioctl(gSpiFd, SPI_IOC_WR_MAX_SPEED_HZ, &SpeedHz) < 0) {
+        perror("LCDSPI: spidev setup");
+        LCDSPI_Close();
+        return false;
+    }
+    gSpeedHz = SpeedHz;
+
+    if (pGpioChip && !OpenLines(pGpioChip)) {
+        LCDSPI_Close();
+        return false;
+    }
+
+    // Same reset pulse LCDHW_Init gives the panel
+    gLineValues[LINE_RESETn] = 0;
+    SetLines();
+    usleep(10000);
+    gLineValues[LINE_RESETn] = 1;
+    SetLines();
+    usleep(10000);
+
+    gPreIsData = 0xFF;
+    memset(&gStats, 0, sizeof(gStats));
+    printf("LCDSPI: %s at %u Hz, GPIO %s\n", pSpiDev, SpeedHz, pGpioChip ? pGpioChip : "(none)");
+    return true;
+}
+
+void LCDSPI_Close(void) {
+    if (gLineFd >= 0) {
+        close(gLineFd);
+        gLineFd = -1;
+    }
+    if (gSpiFd >= 0) {
+        close(gSpiFd);
+        gSpiFd = -1;
+    }
+}
+
+bool LCDSPI_IsOpen(void) {
+    return gSpiFd >= 0;
+}
+
+// One D/C run = one transfer. The spidev call blocks in the kernel while
+// its interrupt-driven driver empties the FIFO, so D/C can move as soon
+// as it returns.
+void LCDSPI_Write(uint8_t bIsData, const uint8_t *pData, uint32_t Len) {
+    ssize_t done;
+
+    if (gSpiFd < 0 || Len == 0) return;
+
+    if (gPreIsData != bIsData) {
+        gLineValues[LINE_D_C] = bIsData ? 1 : 0;
+        SetLines();
+        gPreIsData = bIsData;
+        gStats.DcToggles++;
+    }
+
+    if (gStreamOnly) {
+        while (Len > 0) {
+            done = write(gSpiFd, pData, Len);
+            if (done < 0) {
+                if (errno == EINTR) continue;
+                LOG_Limited(LOG_LEVEL_ERROR, "LCDSPI: write: %s", strerror(errno));
+                return;
+            }
+            pData += done;
+            Len -= (uint32_t)done;
+            gStats.Bytes += (uint64_t)done;
+        }
+    } else {
+        struct spi_ioc_transfer xfer;
+        memset(&xfer, 0, sizeof(xfer));
+        xfer.tx_buf = (uintptr_t)pData;
+        xfer.len = Len;
+        xfer.speed_hz = gSpeedHz;
+        xfer.bits_per_word = 8;
+        if (ioctl(gSpiFd, SPI_IOC_MESSAGE(1), &xfer) < 0) {
+            LOG_Limited(LOG_LEVEL_ERROR, "LCDSPI: SPI_IOC_MESSAGE: %s", strerror(errno));
+            return;
+        }
+        gStats.Bytes += Len;
+    }
+    gStats.Transfers++;
+}
+
+void LCDSPI_BackLight(bool bON) {
+    gLineValues[LINE_BACKLIGHT] = bON ? 1 : 0;
+    SetLines();
+}
+
+void LCDSPI_GetStats(LCDSPI_STATS *pStats) {
+    *pStats = gStats;
+}
@@ -0,0 +1,27 @@
+#ifndef _LCD_HW_SPIDEV_H_
+#define _LCD_HW_SPIDEV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Kernel-driver backend for LCD_Hw.c: bytes go out through spidev, one
+// transfer per D/C run, and D/C, RESETn and the backlight are GPIO1 lines
+// requested through the GPIO character device. A path that does not
+// accept spidev ioctls (a FIFO or plain file) is written to with write(),
+// which is how the host check captures the byte stream. pGpioChip may be
+// NULL when no GPIO control is wanted.
+
+typedef struct {
+    uint64_t Transfers;     // write()/SPI_IOC_MESSAGE calls
+    uint64_t Bytes;
+    uint64_t DcToggles;
+} LCDSPI_STATS;
+
+bool LCDSPI_Open(const char *pSpiDev, const char *pGpioChip, uint32_t SpeedHz);
+void LCDSPI_Close(void);
+bool LCDSPI_IsOpen(void);
+void LCDSPI_Write(uint8_t bIsData, const uint8_t *pData, uint32_t Len);
+void LCDSPI_BackLight(bool bON);
+void LCDSPI_GetStats(LCDSPI_STATS *pStats);
+
+#endif // _LCD_HW_SPIDEV_H_
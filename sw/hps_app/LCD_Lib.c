@@ -1,9 +1,57 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include "LCD_Lib.h"
 #include "LCD_Driver.h"
+#include "LCD_Hw.h"
+#include "trace.h"
+#include "log.h"
+
+#define DLIST_DMA_DESC_MAX  32
+#define LCD_WIDTH           128
+#define LCD_PAGES           8
+#define FRAME_BYTES         (LCD_WIDTH * LCD_PAGES)
+#define DIFF_RUN_MAX        (FRAME_BYTES / 2)   // gap 0, every other column changed
+
+typedef struct {
+    uint8_t Page;
+    uint8_t Col;
+    uint8_t Len;        // 1..128
+} DIFF_RUN;
+
+static bool gDmaMode = false;
+static uint32_t gFenceIssued, gFenceDone;
+static LCD_FRAME_DONE gpfnFrameDone;
+static void *gFrameDoneContext;
+
+// What the panel shows, as far as the frame copies know
+static uint8_t gShadow[FRAME_BYTES];
+static bool gShadowValid = false;
+static uint32_t gShadowEpoch;       // LCDHW_PanelEpoch when the shadow was last written
+static int gDiffGap = LCD_DIFF_GAP_DEFAULT;
+
+static LCDDRV_DLIST *gpRecList;
+static uint32_t gRecFrameEnd;       // list length right after its last frame copy
+static bool gRecHasFrame;
+static uint8_t gRecFrame[FRAME_BYTES];
+
+// Hardware scroll: display row y shows RAM line (y + gStartLine) % 64.
+// The shadow always mirrors display RAM, so scrolled frames are rotated
+// into gRamFrame before they are diffed and sent.
+static int gStartLine;
+static uint8_t gRamFrame[FRAME_BYTES];
+
+// Address commands of the frame in flight; the transmit thread reads them
+// in place, and they are only rewritten after it is done
+static uint8_t gRunCmd[DLIST_DMA_DESC_MAX / 2][3];
+
+static uint32_t FrameCopyAsyncRam(uint8_t *Data, LCD_FRAME_DONE pfnDone, void *pContext);
 
 void LCD_Init(void) {
+    gShadowValid = false;
+    gStartLine = 0;
     LCDDrv_SetOuputStatusSelect(false);
     LCDDrv_SetPowerControl(0x07);
     LCDDrv_SetStartLine(0);
@@ -17,8 +65,19 @@ void LCD_SetStartAddr(uint8_t x, uint8_t y) {
     LCDDrv_SetColAddr(x);
 }
 
+// Only one command byte, but the engine may still be shifting a frame
+// that was laid out for the old start line
+static void ApplyStartLine(int Line) {
+    if (Line == gStartLine || LCDDrv_DListRecording()) return;
+    LCDHW_DmaWait();
+    LCDDrv_SetStartLine(Line);
+    gStartLine = Line;
+}
+
 void LCD_Clear(void) {
     int Page, i;
+
+    ApplyStartLine(0);
     for (Page = 0; Page < 8; Page++) {
         LCDDrv_SetPageAddr(Page);
         LCDDrv_SetColAddr(0);
@@ -26,15 +85,315 @@ void LCD_Clear(void) {
             LCDDrv_WriteData(0x00);
         }
     }
+    if (!LCDDrv_DListRecording()) {
+        memset(gShadow, 0x00, sizeof(gShadow));
+        gShadowValid = true;
+        gShadowEpoch = LCDHW_PanelEpoch();
+    }
 }
 
-void LCD_FrameCopy(uint8_t *Data) {
+void LCD_SetDiffGap(int MaxGap) {
+    gDiffGap = MaxGap;
+}
+
+void LCD_InvalidateShadow(void) {
+    gShadowValid = false;
+}
+
+// Changed column runs against the shadow, page by page. Runs separated by
+// at most gDiffGap unchanged columns are merged: resending a few equal
+// bytes is cheaper than a new address command and another D/C turnaround.
+// Without a valid shadow (or with diffing off) every page is one run.
+// A panel reset or a killed transfer since the shadow was written makes
+// it invalid as well, whoever caused it.
+static int FrameDiff(const uint8_t *Data, DIFF_RUN *pRuns) {
+    int n = 0;
+
+    if (gShadowValid && gShadowEpoch != LCDHW_PanelEpoch())
+        gShadowValid = false;
+    for (int Page = 0; Page < LCD_PAGES; Page++) {
+        const uint8_t *pNew = Data + Page * LCD_WIDTH;
+        const uint8_t *pOld = gShadow + Page * LCD_WIDTH;
+        int Col = 0;
+
+        if (!gShadowValid || gDiffGap < 0) {
+            pRuns[n].Page = Page;
+            pRuns[n].Col = 0;
+            pRuns[n].Len = LCD_WIDTH;
+            n++;
+            continue;
+        }
+        while (Col < LCD_WIDTH) {
+            int End, Scan;
+
+            if (pNew[Col] == pOld[Col]) {
+                Col++;
+                continue;
+            }
+            End = Col + 1;
+            for (Scan = End; Scan < LCD_WIDTH && Scan - End <= gDiffGap; Scan++) {
+                if (pNew[Scan] != pOld[Scan]) End = Scan + 1;
+            }
+            pRuns[n].Page = Page;
+            pRuns[n].Col = Col;
+            pRuns[n].Len = End - Col;
+            n++;
+            Col = Scan;
+        }
+    }
+    return n;
+}
+
+static void ShadowUpdate(const uint8_t *Data) {
+    memcpy(gShadow, Data, FRAME_BYTES);
+    gShadowValid = true;
+    gShadowEpoch = LCDHW_PanelEpoch();
+}
+
+static void SendRunsPio(uint8_t *Data, const DIFF_RUN *pRuns, int nRuns) {
+    for (int i = 0; i < nRuns; i++) {
+        TRACE_Record(TRACE_SPI_PAGE_BEGIN, pRuns[i].Page, (uint32_t)pRuns[i].Col << 16 | pRuns[i].Len);
+        LCDDrv_SetAddr(pRuns[i].Page, pRuns[i].Col);
+        LCDDrv_WriteMultiData(Data + pRuns[i].Page * LCD_WIDTH + pRuns[i].Col, pRuns[i].Len);
+        TRACE_Record(TRACE_SPI_PAGE_END, pRuns[i].Page, 0);
+    }
+}
+
+static void FrameCopyPio(uint8_t *Data) {
     int Page;
     uint8_t *pPageData = Data;
     
     for (Page = 0; Page < 8; Page++) {
-        LCD_SetStartAddr(0, Page * 8);
+        TRACE_Record(TRACE_SPI_PAGE_BEGIN, Page, 128);
+        LCDDrv_SetAddr(Page, 0);
         LCDDrv_WriteMultiData(pPageData, 128);
         pPageData += 128;
+        TRACE_Record(TRACE_SPI_PAGE_END, Page, 0);
     }
-}
\ No newline at end of file
+}
+
+static void FrameCopyDiffPio(uint8_t *Data) {
+    DIFF_RUN Runs[DIFF_RUN_MAX];
+
+    SendRunsPio(Data, Runs, FrameDiff(Data, Runs));
+    ShadowUpdate(Data);
+}
+
+// While recording, a whole frame makes everything before it redundant.
+// Lists are replayed onto whatever the panel shows, so they always hold
+// the full frame, never a diff.
+static void FrameCopyRecord(uint8_t *Data) {
+    LCDDrv_DListRewind();
+    FrameCopyPio(Data);
+    if (gpRecList) {
+        memcpy(gRecFrame, Data, FRAME_BYTES);
+        gRecFrameEnd = gpRecList->nBytes;
+        gRecHasFrame = true;
+    }
+}
+
+// Data is laid out as display RAM (start line already accounted for)
+static void FrameCopyRam(uint8_t *Data) {
+    if (LCDDrv_DListRecording())
+        FrameCopyRecord(Data);
+    else if (gDmaMode)
+        FrameCopyAsyncRam(Data, NULL, NULL);
+    else
+        FrameCopyDiffPio(Data);
+}
+
+void LCD_FrameCopy(uint8_t *Data) {
+    ApplyStartLine(0);
+    FrameCopyRam(Data);
+}
+
+// Display row y goes to RAM line (y + Line) % 64: each column, read as
+// one 64-bit word with page 0 in the low byte, is rotated left by Line.
+static void RotateFrame(uint8_t *pRam, const uint8_t *Data, int Line) {
+    for (int x = 0; x < LCD_WIDTH; x++) {
+        uint64_t Col = 0;
+
+        for (int Page = 0; Page < LCD_PAGES; Page++)
+            Col |= (uint64_t)Data[Page * LCD_WIDTH + x] << (Page * 8);
+        if (Line)
+            Col = (Col << Line) | (Col >> (64 - Line));
+        for (int Page = 0; Page < LCD_PAGES; Page++)
+            pRam[Page * LCD_WIDTH + x] = (uint8_t)(Col >> (Page * 8));
+    }
+}
+
+void LCD_FrameCopyScrolled(uint8_t *Data, int StartLine) {
+    int Line = StartLine & 63;
+
+    if (Line == 0 || LCDDrv_DListRecording()) {
+        LCD_FrameCopy(Data);
+        return;
+    }
+    RotateFrame(gRamFrame, Data, Line);     // the DMA engine sends from its OCRAM copy
+    ApplyStartLine(Line);
+    FrameCopyRam(gRamFrame);
+}
+
+int LCD_GetStartLine(void) {
+    return gStartLine;
+}
+
+bool LCD_SetDmaMode(bool bEnable) {
+    if (bEnable && !gDmaMode && !LCDHW_DmaInit())
+        return false;
+    if (!bEnable && gDmaMode) LCDHW_DmaRelease();
+    gDmaMode = bEnable;
+    return true;
+}
+
+// A transfer cut short leaves the panel matching neither the old shadow
+// nor the new one, so the next frame goes out whole
+static void FrameDmaDone(void *pContext, bool bOk) {
+    LCD_FRAME_DONE pfnDone = gpfnFrameDone;
+    (void)pContext;
+    if (!bOk) gShadowValid = false;
+    gFenceDone++;
+    gpfnFrameDone = NULL;
+    if (pfnDone) pfnDone(gFrameDoneContext);
+}
+
+uint32_t LCD_FrameCopyAsync(uint8_t *Data, LCD_FRAME_DONE pfnDone, void *pContext) {
+    ApplyStartLine(0);
+    return FrameCopyAsyncRam(Data, pfnDone, pContext);
+}
+
+static uint32_t FrameCopyAsyncRam(uint8_t *Data, LCD_FRAME_DONE pfnDone, void *pContext) {
+    DIFF_RUN Runs[DIFF_RUN_MAX];
+    LCDHW_DMA_DESC Desc[DLIST_DMA_DESC_MAX];
+    int nRuns, i;
+    bool bQueued;
+
+    if (LCDDrv_DListRecording()) {
+        FrameCopyRecord(Data);
+        gFenceDone = ++gFenceIssued;
+        if (pfnDone) pfnDone(pContext);
+        return gFenceIssued;
+    }
+
+    // Either engine holds one frame; waiting here also retires the previous fence.
+    LCDHW_DmaWait();
+    LCDHW_TxWait();
+    nRuns = FrameDiff(Data, Runs);
+    if (nRuns == 0) {
+        gFenceDone = ++gFenceIssued;
+        if (pfnDone) pfnDone(pContext);
+        return gFenceIssued;
+    }
+    // Too fragmented for one channel program: send each touched page whole
+    if (nRuns > DLIST_DMA_DESC_MAX / 2) {
+        int nPages = 0;
+        for (i = 0; i < nRuns; i++) {
+            if (nPages > 0 && Runs[nPages - 1].Page == Runs[i].Page) continue;
+            Runs[nPages].Page = Runs[i].Page;
+            Runs[nPages].Col = 0;
+            Runs[nPages].Len = LCD_WIDTH;
+            nPages++;
+        }
+        nRuns = nPages;
+    }
+
+    for (i = 0; i < nRuns; i++) {
+        LCDDrv_EncodeAddr(gRunCmd[i], Runs[i].Page, Runs[i].Col);
+        Desc[i * 2].bIsData = 0;
+        Desc[i * 2].Len = 3;
+        Desc[i * 2].pData = gRunCmd[i];
+        Desc[i * 2 + 1].bIsData = 1;
+        Desc[i * 2 + 1].Len = Runs[i].Len;
+        Desc[i * 2 + 1].pData = Data + Runs[i].Page * LCD_WIDTH + Runs[i].Col;
+    }
+
+    gpfnFrameDone = pfnDone;
+    gFrameDoneContext = pContext;
+    gFenceIssued++;
+    // The DMA engine works from its OCRAM copy; the transmit thread reads
+    // Data itself until the fence retires
+    if (gDmaMode) {
+        bQueued = LCDHW_DmaSubmit(Desc, nRuns * 2, FrameDmaDone, NULL);
+        if (!bQueued) LOG_Limited(LOG_LEVEL_WARN, "LCD DMA submit failed, sending frame by PIO");
+    } else {
+        bQueued = LCDHW_TxSubmit(Desc, nRuns * 2, FrameDmaDone, NULL);
+    }
+    if (!bQueued) {
+        SendRunsPio(Data, Runs, nRuns);
+        FrameDmaDone(NULL, true);
+    }
+    ShadowUpdate(Data);
+    return gFenceIssued;
+}
+
+bool LCD_FrameDone(uint32_t Fence) {
+    LCDHW_DmaBusy();
+    LCDHW_TxBusy();
+    return (int32_t)(gFenceDone - Fence) >= 0;
+}
+
+void LCD_FrameSync(void) {
+    LCDHW_DmaWait();
+    LCDHW_TxWait();
+}
+
+void LCD_RecordBegin(LCDDRV_DLIST *pList) {
+    LCDDrv_DListBegin(pList);
+    gpRecList = pList;
+    gRecHasFrame = false;
+}
+
+// A list that is exactly one frame copy keeps that frame, so replaying it
+// leaves the shadow valid.
+void LCD_RecordEnd(void) {
+    LCDDRV_DLIST *pList = gpRecList;
+
+    LCDDrv_DListEnd();
+    gpRecList = NULL;
+    if (!pList) return;
+    if (gRecHasFrame && pList->nBytes == gRecFrameEnd && pList->nBytes > 0) {
+        if (!pList->pFrame) pList->pFrame = malloc(FRAME_BYTES);
+        if (pList->pFrame) memcpy(pList->pFrame, gRecFrame, FRAME_BYTES);
+    } else {
+        free(pList->pFrame);
+        pList->pFrame = NULL;
+    }
+}
+
+static void ReplayRaw(const LCDDRV_DLIST *pList) {
+    LCDHW_DMA_DESC Desc[DLIST_DMA_DESC_MAX];
+    uint32_t i;
+
+    ApplyStartLine(0);
+
+    if (!gDmaMode || LCDDrv_DListRecording() || pList->nRuns == 0 ||
+        pList->nRuns > DLIST_DMA_DESC_MAX) {
+        LCDDrv_DListReplay(pList);
+        return;
+    }
+
+    // Runs are already FIFO-sized, so each one is a descriptor
+    for (i = 0; i < pList->nRuns; i++) {
+        Desc[i].bIsData = pList->pRuns[i].bIsData;
+        Desc[i].Len = pList->pRuns[i].Len;
+        Desc[i].pData = pList->pBytes + pList->pRuns[i].Offset;
+    }
+    LCDHW_DmaWait();
+    gpfnFrameDone = NULL;
+    gFenceIssued++;
+    if (!LCDHW_DmaSubmit(Desc, (int)pList->nRuns, FrameDmaDone, NULL)) {
+        LCDDrv_DListReplay(pList);
+        FrameDmaDone(NULL, true);
+    }
+}
+
+// The recorded stream goes out as it is, one burst or descriptor per run,
+// with no rasterizing and no diff
+void LCD_Replay(const LCDDRV_DLIST *pList) {
+    ReplayRaw(pList);
+    if (LCDDrv_DListRecording()) return;
+    if (pList->pFrame)
+        ShadowUpdate(pList->pFrame);
+    else
+        gShadowValid = false;
+}
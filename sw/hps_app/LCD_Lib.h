@@ -3,10 +3,62 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "LCD_Driver.h"
 
 void LCD_Init(void);
 void LCD_Clear(void);
 void LCD_SetStartAddr(uint8_t x, uint8_t y);
 void LCD_FrameCopy(uint8_t *Data);
 
+// Frame copies are differential: the library keeps a shadow of what the
+// panel shows and only sends changed column runs, with unchanged gaps of
+// up to MaxGap columns merged into a run. A negative gap sends every
+// frame whole. LCD_InvalidateShadow forces the next frame out in full,
+// e.g. after writing to display RAM behind the library's back.
+#define LCD_DIFF_GAP_DEFAULT  4
+#define LCD_DIFF_OFF          (-1)
+
+void LCD_SetDiffGap(int MaxGap);
+void LCD_InvalidateShadow(void);
+
+// Hardware vertical scroll through the controller's start-line register:
+// display row y shows RAM line (y + StartLine) % 64. LCD_FrameCopyScrolled
+// takes a normal frame (row 0 at the top) and stores it rotated so it
+// shows unchanged at that start line, sending the start-line command and
+// the diff against display RAM. Stepping a frame that scrolls up by one
+// row with StartLine + 1 changes only the RAM line that wrapped around:
+// at most one page of data plus one command byte. Every other transfer
+// resets the start line to 0 first.
+void LCD_FrameCopyScrolled(uint8_t *Data, int StartLine);
+int  LCD_GetStartLine(void);
+
+// DMA transfer mode: LCD_FrameCopy queues the frame and returns at once.
+// Fences count submitted frames; LCD_FrameDone polls the engine, so the
+// caller's loop drives completion callbacks.
+//
+// LCD_FrameCopyAsync queues in every mode. In DMA mode the engine copies
+// the frame to OCRAM first. In PIO and spidev modes the LCD_Hw transmit
+// thread sends it straight from Data, so Data must stay unchanged until
+// its fence is done. lcd_graphic.c draws into its other buffer meanwhile.
+typedef void (*LCD_FRAME_DONE)(void *pContext);
+
+bool     LCD_SetDmaMode(bool bEnable);
+uint32_t LCD_FrameCopyAsync(uint8_t *Data, LCD_FRAME_DONE pfnDone, void *pContext);
+bool     LCD_FrameDone(uint32_t Fence);
+void     LCD_FrameSync(void);
+
+// Display lists: LCD_RecordBegin captures everything the LCD stack would
+// send until LCD_RecordEnd. A full frame copy replaces whatever was
+// recorded before it, so a screen drawn as clear + text lines records as
+// one frame and keeps a copy of it (pFrame). LCD_Replay sends the list
+// as recorded: a burst per run, or one DMA program in DMA mode. A
+// one-frame list leaves the shadow matching the panel, so the frame diff
+// can carry on from it; any other list invalidates the shadow.
+//
+// The app records every fixed and message screen at startup and replays
+// it on a state change; the compositor then sends only the overlay.
+void LCD_RecordBegin(LCDDRV_DLIST *pList);
+void LCD_RecordEnd(void);
+void LCD_Replay(const LCDDRV_DLIST *pList);
+
 #endif // _LCD_LIB_H_
\ No newline at end of file
@@ -1,59 +1,38 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
 
+#include "hps_regs.h"
 #include "LCD_Hw.h"
 #include "LCD_Lib.h"
 #include "lcd_graphic.h"
 #include "font.h"
 
-#define HW_REGS_BASE          0xFC000000
-#define HW_REGS_SPAN          0x04000000
-#define HW_REGS_MASK          (HW_REGS_SPAN - 1)
-#define ALT_LWFPGASLVS_OFST   0xFF200000
-#define BUTTON_PIO_BASE       0x5000
 #define BUTTON_MASK           0x0F
 
-void *virtual_base = NULL;
-volatile uint32_t *button_addr = NULL;
+uint32_t button_offset = LWFPGA_OFFSET(BUTTON_PIO_BASE);
 
 int main() {
-    int fd;
-    
-    // === STEP 1: Open /dev/mem ===
-    printf("Step 1: Opening /dev/mem...\n");
-    fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (fd < 0) {
-        printf("ERROR: Cannot open /dev/mem\n");
+    // === STEP 1+2: Open /dev/mem and map the register window ===
+    printf("Step 1: Mapping HPS registers...\n");
+    if (!HPSREG_Open(&HPSREG_DevMem)) {
+        printf("ERROR: Cannot map /dev/mem\n");
         return 1;
     }
     printf("  OK\n");
     
-    // === STEP 2: Memory map ===
-    printf("Step 2: Memory mapping...\n");
-    virtual_base = mmap(NULL, HW_REGS_SPAN, PROT_READ | PROT_WRITE, MAP_SHARED, fd, HW_REGS_BASE);
-    if (virtual_base == MAP_FAILED) {
-        printf("ERROR: mmap failed\n");
-        close(fd);
-        return 1;
-    }
-    printf("  virtual_base = %p\n", virtual_base);
-    
     // === STEP 3: Calculate button address ===
     printf("Step 3: Setting up button address...\n");
-    button_addr = (uint32_t *)(virtual_base + ((ALT_LWFPGASLVS_OFST + BUTTON_PIO_BASE) & HW_REGS_MASK));
-    printf("  button_addr = %p\n", (void*)button_addr);
+    printf("  button_offset = 0x%08X\n", button_offset);
     
     // === STEP 4: Test buttons BEFORE LCD init ===
     printf("Step 4: Testing buttons BEFORE LCD init...\n");
     printf("  Press KEY0 now (you have 3 seconds)...\n");
     for (int i = 0; i < 30; i++) {
-        uint32_t raw = *button_addr;
+        uint32_t raw = HPSREG_Read32(button_offset);
         uint32_t btn = (~raw) & BUTTON_MASK;
         if (btn != 0) {
             printf("  BUTTON DETECTED: raw=0x%X, btn=0x%X\n", raw, btn);
@@ -64,7 +43,7 @@ int main() {
     
     // === STEP 5: Initialize LCD ===
     printf("Step 5: Initializing LCD hardware...\n");
-    LCDHW_Init(virtual_base);
+    LCDHW_Init();
     LCD_Init();
     LCD_GraphicClear();
     LCDHW_BackLight(true);
@@ -74,7 +53,7 @@ int main() {
     printf("Step 6: Testing buttons AFTER LCD init...\n");
     printf("  Press KEY0 now (you have 3 seconds)...\n");
     for (int i = 0; i < 30; i++) {
-        uint32_t raw = *button_addr;
+        uint32_t raw = HPSREG_Read32(button_offset);
         uint32_t btn = (~raw) & BUTTON_MASK;
         if (btn != 0) {
             printf("  BUTTON DETECTED: raw=0x%X, btn=0x%X\n", raw, btn);
@@ -100,7 +79,7 @@ int main() {
     char line[32];
     
     while (1) {
-        uint32_t raw = *button_addr;
+        uint32_t raw = HPSREG_Read32(button_offset);
         int btn = (~raw) & BUTTON_MASK;
         
         // Detect button press (transition from 0 to non-0)
@@ -130,6 +109,6 @@ int main() {
         usleep(50000);
     }
     
-    close(fd);
+    HPSREG_Close();
     return 0;
 }
\ No newline at end of file
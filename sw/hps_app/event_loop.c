@@ -0,0 +1,299 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+
+#include "event_loop.h"
+
+#define SRC_FREE        0
+#define SRC_FD          1
+#define SRC_TIMER       2
+#define SRC_SIGNAL      3
+#define MAX_SIGNAL      64
+
+typedef struct {
+    int           Type;
+    uint32_t      Gen;              // epoll events carry it, so a slot reused mid-batch is ignored
+    int           Fd;
+    EVLOOP_FN     pfnTimer;
+    EVLOOP_FD_FN  pfnFd;
+    void         *pContext;
+    uint64_t      PeriodNs;         // 0: one-shot
+    uint64_t      NextNs;           // when the next expiry is due
+    int           Stats;            // gTimerStats index
+} SOURCE;
+
+static SOURCE gSources[EVLOOP_MAX_SOURCES];
+static EVLOOP_TIMER_STATS gTimerStats[EVLOOP_MAX_SOURCES];
+static int gnTimerStats;
+static int gEpoll = -1;
+static int gSignalFd = -1;
+static sigset_t gSignals;
+static struct {
+    EVLOOP_SIGNAL_FN pfn;
+    void *pContext;
+} gSignalHandlers[MAX_SIGNAL + 1];
+static EVLOOP_FN gpfnIdle;
+static void *gIdleContext;
+static volatile bool gStop;
+static uint64_t gWakeups;
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool EVLOOP_Init(void) {
+    memset(gSources, 0, sizeof(gSources));
+    memset(gTimerStats, 0, sizeof(gTimerStats));
+    memset(gSignalHandlers, 0, sizeof(gSignalHandlers));
+    gnTimerStats = 0;
+    gWakeups = 0;
+    gStop = false;
+    gpfnIdle = NULL;
+    sigemptyset(&gSignals);
+    gEpoll = epoll_create1(EPOLL_CLOEXEC);
+    if (gEpoll < 0) {
+        perror("EVLOOP: epoll_create1");
+        return false;
+    }
+    return true;
+}
+
+// The slot for a new source, registered with epoll for Events on Fd
+static int AddSource(int Type, int Fd, uint32_t Events) {
+    struct epoll_event ev;
+
+    for (int i = 0; i < EVLOOP_MAX_SOURCES; i++) {
+        SOURCE *pSrc = &gSources[i];
+
+        if (pSrc->Type != SRC_FREE) continue;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = Events;
+        ev.data.u64 = ((uint64_t)(pSrc->Gen + 1) << 32) | (uint32_t)i;
+        if (epoll_ctl(gEpoll, EPOLL_CTL_ADD, Fd, &ev) < 0) {
+            perror("EVLOOP: epoll_ctl");
+            return -1;
+        }
+        pSrc->Gen++;
+        pSrc->Type = Type;
+        pSrc->Fd = Fd;
+        return i;
+    }
+    printf("EVLOOP: more than %d sources\n", EVLOOP_MAX_SOURCES);
+    return -1;
+}
+
+static void FreeSource(int Id) {
+    SOURCE *pSrc = &gSources[Id];
+
+    epoll_ctl(gEpoll, EPOLL_CTL_DEL, pSrc->Fd, NULL);
+    if (pSrc->Type == SRC_TIMER || pSrc->Type == SRC_SIGNAL)
+        close(pSrc->Fd);
+    pSrc->Type = SRC_FREE;
+}
+
+bool EVLOOP_AddFd(int Fd, uint32_t Events, EVLOOP_FD_FN pfnHandler, void *pContext) {
+    int Id = AddSource(SRC_FD, Fd, Events);
+
+    if (Id < 0) return false;
+    gSources[Id].pfnFd = pfnHandler;
+    gSources[Id].pContext = pContext;
+    return true;
+}
+
+void EVLOOP_RemoveFd(int Fd) {
+    for (int i = 0; i < EVLOOP_MAX_SOURCES; i++)
+        if (gSources[i].Type == SRC_FD && gSources[i].Fd == Fd)
+            FreeSource(i);
+}
+
+// Timers of the same name share their stats, so repeated deadlines add up
+static int TimerStats(const char *pName, uint32_t PeriodUs) {
+    for (int i = 0; i < gnTimerStats; i++)
+        if (strcmp(gTimerStats[i].pName, pName) == 0)
+            return i;
+    if (gnTimerStats == EVLOOP_MAX_SOURCES)
+        return EVLOOP_MAX_SOURCES - 1;
+    gTimerStats[gnTimerStats].pName = pName;
+    gTimerStats[gnTimerStats].PeriodUs = PeriodUs;
+    return gnTimerStats++;
+}
+
+static int AddTimer(const char *pName, uint32_t DelayUs, bool bPeriodic, EVLOOP_FN pfnHandler, void *pContext) {
+    struct itimerspec its;
+    SOURCE *pSrc;
+    int fd, Id;
+
+    fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        perror("EVLOOP: timerfd_create");
+        return -1;
+    }
+    Id = AddSource(SRC_TIMER, fd, EPOLLIN);
+    if (Id < 0) {
+        close(fd);
+        return -1;
+    }
+    pSrc = &gSources[Id];
+    pSrc->pfnTimer = pfnHandler;
+    pSrc->pContext = pContext;
+    pSrc->PeriodNs = bPeriodic ? DelayUs * 1000ull : 0;
+    pSrc->NextNs = NowNs() + DelayUs * 1000ull;
+    pSrc->Stats = TimerStats(pName, bPeriodic ? DelayUs : 0);
+
+    // Absolute expiries: the schedule does not drift with handling delays
+    memset(&its, 0, sizeof(its));
+    its.it_value.tv_sec = pSrc->NextNs / 1000000000ull;
+    its.it_value.tv_nsec = pSrc->NextNs % 1000000000ull;
+    its.it_interval.tv_sec = pSrc->PeriodNs / 1000000000ull;
+    its.it_interval.tv_nsec = pSrc->PeriodNs % 1000000000ull;
+    if (timerfd_settime(fd, TFD_TIMER_ABSTIME, &its, NULL) < 0) {
+        perror("EVLOOP: timerfd_settime");
+        FreeSource(Id);
+        return -1;
+    }
+    return Id;
+}
+
+int EVLOOP_AddTimer(const char *pName, uint32_t PeriodUs, EVLOOP_FN pfnHandler, void *pContext) {
+    return AddTimer(pName, PeriodUs, true, pfnHandler, pContext);
+}
+
+int EVLOOP_AddDeadline(const char *pName, uint32_t DelayUs, EVLOOP_FN pfnHandler, void *pContext) {
+    return AddTimer(pName, DelayUs, false, pfnHandler, pContext);
+}
+
+void EVLOOP_CancelTimer(int Id) {
+    if (Id >= 0 && Id < EVLOOP_MAX_SOURCES && gSources[Id].Type == SRC_TIMER)
+        FreeSource(Id);
+}
+
+bool EVLOOP_AddSignal(int Signo, EVLOOP_SIGNAL_FN pfnHandler, void *pContext) {
+    int fd;
+
+    if (Signo <= 0 || Signo > MAX_SIGNAL) return false;
+    gSignalHandlers[Signo].pfn = pfnHandler;
+    gSignalHandlers[Signo].pContext = pContext;
+    sigaddset(&gSignals, Signo);
+    pthread_sigmask(SIG_BLOCK, &gSignals, NULL);
+
+    fd = signalfd(gSignalFd, &gSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        perror("EVLOOP: signalfd");
+        return false;
+    }
+    if (gSignalFd < 0) {
+        if (AddSource(SRC_SIGNAL, fd, EPOLLIN) < 0) {
+            close(fd);
+            return false;
+        }
+        gSignalFd = fd;
+    }
+    return true;
+}
+
+void EVLOOP_SetIdle(EVLOOP_FN pfnHandler, void *pContext) {
+    gpfnIdle = pfnHandler;
+    gIdleContext = pContext;
+}
+
+static void DispatchTimer(int Id) {
+    SOURCE *pSrc = &gSources[Id];
+    EVLOOP_TIMER_STATS *pStats = &gTimerStats[pSrc->Stats];
+    EVLOOP_FN pfn = pSrc->pfnTimer;
+    void *pContext = pSrc->pContext;
+    uint64_t expirations, now, late;
+
+    if (read(pSrc->Fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+        return;                         // cancelled and re-armed in between
+    now = NowNs();
+    late = now > pSrc->NextNs ? now - pSrc->NextNs : 0;
+    pStats->Fired++;
+    pStats->Missed += expirations - 1;
+    pStats->LateSumNs += late;
+    if (late > pStats->LateMaxNs) pStats->LateMaxNs = late;
+
+    if (pSrc->PeriodNs)
+        pSrc->NextNs += expirations * pSrc->PeriodNs;
+    else
+        FreeSource(Id);
+    pfn(pContext);
+}
+
+static void DispatchSignals(void) {
+    struct signalfd_siginfo si;
+
+    while (read(gSignalFd, &si, sizeof(si)) == sizeof(si)) {
+        int Signo = si.ssi_signo;
+
+        if (Signo > 0 && Signo <= MAX_SIGNAL && gSignalHandlers[Signo].pfn)
+            gSignalHandlers[Signo].pfn(Signo, gSignalHandlers[Signo].pContext);
+    }
+}
+
+void EVLOOP_Run(void) {
+    struct epoll_event events[EVLOOP_MAX_SOURCES];
+
+    gStop = false;
+    while (!gStop) {
+        int n;
+
+        if (gpfnIdle) {
+            gpfnIdle(gIdleContext);
+            if (gStop) break;
+        }
+        n = epoll_wait(gEpoll, events, EVLOOP_MAX_SOURCES, gpfnIdle ? 0 : -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("EVLOOP: epoll_wait");
+            break;
+        }
+        if (n > 0) gWakeups++;
+        for (int i = 0; i < n; i++) {
+            uint32_t Id = (uint32_t)events[i].data.u64;
+            uint32_t Gen = (uint32_t)(events[i].data.u64 >> 32);
+            SOURCE *pSrc = &gSources[Id];
+
+            if (pSrc->Type == SRC_FREE || pSrc->Gen != Gen) continue;
+            switch (pSrc->Type) {
+            case SRC_TIMER:  DispatchTimer(Id); break;
+            case SRC_SIGNAL: DispatchSignals(); break;
+            default:         pSrc->pfnFd(pSrc->Fd, events[i].events, pSrc->pContext); break;
+            }
+        }
+    }
+}
+
+void EVLOOP_Stop(void) {
+    gStop = true;
+}
+
+int EVLOOP_GetTimerStats(EVLOOP_TIMER_STATS *pStats, int Max) {
+    int n = gnTimerStats < Max ? gnTimerStats : Max;
+
+    memcpy(pStats, gTimerStats, n * sizeof(*pStats));
+    return n;
+}
+
+uint64_t EVLOOP_Wakeups(void) {
+    return gWakeups;
+}
+
+void EVLOOP_Close(void) {
+    for (int i = 0; i < EVLOOP_MAX_SOURCES; i++)
+        if (gSources[i].Type != SRC_FREE)
+            FreeSource(i);
+    gSignalFd = -1;
+    if (gEpoll >= 0) close(gEpoll);
+    gEpoll = -1;
+}
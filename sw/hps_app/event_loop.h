@@ -0,0 +1,58 @@
+#ifndef _EVENT_LOOP_H_
+#define _EVENT_LOOP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/epoll.h>       // EPOLLIN etc. for EVLOOP_AddFd
+
+// Single-threaded event loop on epoll. Every wake source is a descriptor:
+// timers are timerfds (periodic, or one-shot deadlines), signals come
+// through one signalfd, and anything else (the status PIO interrupts, an
+// eventfd) is added as a plain fd. The loop blocks until one of them is
+// ready, so with nothing due it does not run at all.
+//
+// Each timer keeps its own jitter: how late each expiry was handled
+// against its schedule, and how many expiries were missed outright.
+
+#define EVLOOP_MAX_SOURCES    16
+
+typedef void (*EVLOOP_FN)(void *pContext);
+typedef void (*EVLOOP_FD_FN)(int Fd, uint32_t Events, void *pContext);
+typedef void (*EVLOOP_SIGNAL_FN)(int Signo, void *pContext);
+
+typedef struct {
+    const char *pName;
+    uint32_t PeriodUs;          // 0: one-shot
+    uint64_t Fired;
+    uint64_t Missed;            // periods that expired more than once before being handled
+    uint64_t LateSumNs;
+    uint64_t LateMaxNs;
+} EVLOOP_TIMER_STATS;
+
+bool EVLOOP_Init(void);
+void EVLOOP_Close(void);
+
+bool EVLOOP_AddFd(int Fd, uint32_t Events, EVLOOP_FD_FN pfnHandler, void *pContext);
+void EVLOOP_RemoveFd(int Fd);
+
+// Ids are >= 0. A one-shot timer goes away after it fires.
+int  EVLOOP_AddTimer(const char *pName, uint32_t PeriodUs, EVLOOP_FN pfnHandler, void *pContext);
+int  EVLOOP_AddDeadline(const char *pName, uint32_t DelayUs, EVLOOP_FN pfnHandler, void *pContext);
+void EVLOOP_CancelTimer(int Id);
+
+// Blocks Signo for the whole process (call before starting threads) and
+// delivers it to pfnHandler from the loop instead
+bool EVLOOP_AddSignal(int Signo, EVLOOP_SIGNAL_FN pfnHandler, void *pContext);
+
+// Runs before every wait, which then does not block: for sources that
+// are not descriptors (the emulator's virtual clock)
+void EVLOOP_SetIdle(EVLOOP_FN pfnHandler, void *pContext);
+
+void EVLOOP_Run(void);          // until EVLOOP_Stop
+void EVLOOP_Stop(void);
+
+// Timers, including ones that have fired and gone; returns how many
+int  EVLOOP_GetTimerStats(EVLOOP_TIMER_STATS *pStats, int Max);
+uint64_t EVLOOP_Wakeups(void);
+
+#endif // _EVENT_LOOP_H_
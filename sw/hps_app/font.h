@@ -22,6 +22,15 @@
 
 typedef unsigned char FONT_BITMAP[LCD_CELL_SIZE_Y][LCD_CELL_SIZE_X];
 
+// Compact fonts (font_file.c) describe each code in CodeStart..CodeEnd
+#define FONT_GLYPH_EMPTY    0x01    // nothing to draw, no bitmap stored
+
+typedef struct{
+    unsigned char  Advance;         // columns to the next glyph
+    unsigned char  Flags;
+    unsigned short Index;           // bitmap number in pPacked
+}FONT_GLYPH;
+
 typedef struct{
     int FontWidth;
     int FontHeight;
@@ -30,10 +39,35 @@ typedef struct{
     int CodeStart;
     int CodeEnd;
     int BitPerPixel;
-    FONT_BITMAP *pBitmap;
+    FONT_BITMAP *pBitmap;           // full table: one cell per code from CodeStart
+    const FONT_GLYPH *pGlyphs;      // compact font: NULL for a full table
+    const unsigned char *pPacked;   // compact font: 2 pages x CellWidth bytes per bitmap
+    int BitmapCount;
 }FONT_TABLE;
 
 // hint: unsigned char font_table[ascii_code][lcd_cell_height/8][lcd_cell_width]
 extern FONT_TABLE  font_16x16;
 
+// Page-format bitmap of a code (two pages of CellWidth bytes), or NULL if
+// the code is empty or outside the font.
+static inline const unsigned char *FONT_Glyph(const FONT_TABLE *pFont, unsigned char Code){
+    int i = Code - pFont->CodeStart;
+
+    if (i < 0 || Code > pFont->CodeEnd)
+        return 0;
+    if (!pFont->pGlyphs)
+        return pFont->pBitmap[i][0];
+    if (pFont->pGlyphs[i].Flags & FONT_GLYPH_EMPTY)
+        return 0;
+    return pFont->pPacked + pFont->pGlyphs[i].Index * 2 * pFont->CellWidth;
+}
+
+static inline int FONT_Advance(const FONT_TABLE *pFont, unsigned char Code){
+    int i = Code - pFont->CodeStart;
+
+    if (!pFont->pGlyphs || i < 0 || Code > pFont->CodeEnd)
+        return pFont->FontWidth;
+    return pFont->pGlyphs[i].Advance;
+}
+
 #endif // __FONT_H__
\ No newline at end of file
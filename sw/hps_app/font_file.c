@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "font_file.h"
+
+typedef struct {
+    FONT_TABLE Table;       // first, so the table pointer is the allocation
+    void      *pMap;        // NULL: FONT_Map over memory someone else owns
+    size_t     MapSize;
+} FONT_MAPPED;
+
+FONT_TABLE *FONT_Map(const void *pData, size_t Size, const char *pName) {
+    const FONT_FILE_HEADER *pHdr = pData;
+    FONT_MAPPED *pFont;
+    size_t nCodes, glyph_bytes, bitmap_bytes;
+
+    if (Size < sizeof(FONT_FILE_HEADER)) {
+        printf("FONT: %s is too short\n", pName);
+        return NULL;
+    }
+    nCodes = (size_t)pHdr->CodeEnd - pHdr->CodeStart + 1;
+    glyph_bytes = nCodes * sizeof(FONT_GLYPH);
+    bitmap_bytes = (size_t)pHdr->BitmapCount * 2 * pHdr->CellWidth;
+    if (memcmp(pHdr->Magic, FONT_FILE_MAGIC, 4) != 0 || pHdr->Version != FONT_FILE_VERSION ||
+        pHdr->CodeEnd < pHdr->CodeStart || pHdr->CellHeight != 16 ||
+        pHdr->CellWidth == 0 || pHdr->CellWidth > LCD_CELL_SIZE_X ||
+        (pHdr->GlyphOffset % sizeof(uint16_t)) != 0 ||
+        pHdr->GlyphOffset > Size || glyph_bytes > Size - pHdr->GlyphOffset ||
+        pHdr->BitmapOffset > Size || bitmap_bytes > Size - pHdr->BitmapOffset) {
+        printf("FONT: %s is not a valid font file\n", pName);
+        return NULL;
+    }
+
+    const FONT_GLYPH *pGlyphs = (const FONT_GLYPH *)((const uint8_t *)pData + pHdr->GlyphOffset);
+    for (size_t i = 0; i < nCodes; i++) {
+        if (!(pGlyphs[i].Flags & FONT_GLYPH_EMPTY) && pGlyphs[i].Index >= pHdr->BitmapCount) {
+            printf("FONT: %s: glyph 0x%02X has no bitmap\n", pName, (unsigned)(pHdr->CodeStart + i));
+            return NULL;
+        }
+    }
+
+    pFont = calloc(1, sizeof(*pFont));
+    if (!pFont)
+        return NULL;
+    pFont->Table.FontWidth = pHdr->FontWidth;
+    pFont->Table.FontHeight = pHdr->FontHeight;
+    pFont->Table.CellWidth = pHdr->CellWidth;
+    pFont->Table.CellHeight = pHdr->CellHeight;
+    pFont->Table.CodeStart = pHdr->CodeStart;
+    pFont->Table.CodeEnd = pHdr->CodeEnd;
+    pFont->Table.BitPerPixel = 1;
+    pFont->Table.pGlyphs = pGlyphs;
+    pFont->Table.pPacked = (const uint8_t *)pData + pHdr->BitmapOffset;
+    pFont->Table.BitmapCount = pHdr->BitmapCount;
+    return &pFont->Table;
+}
+
+FONT_TABLE *FONT_Load(const char *pPath) {
+    FONT_MAPPED *pFont;
+    struct stat st;
+    void *pMap;
+    int fd;
+
+    fd = open(pPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("FONT: cannot open font file");
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(FONT_FILE_HEADER)) {
+        printf("FONT: %s is too short\n", pPath);
+        close(fd);
+        return NULL;
+    }
+    pMap = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMap == MAP_FAILED) {
+        perror("FONT: mmap failed");
+        return NULL;
+    }
+
+    pFont = (FONT_MAPPED *)FONT_Map(pMap, st.st_size, pPath);
+    if (!pFont) {
+        munmap(pMap, st.st_size);
+        return NULL;
+    }
+    pFont->pMap = pMap;
+    pFont->MapSize = st.st_size;
+    printf("FONT: %s, codes 0x%02X-0x%02X, %d bitmaps, %zu bytes\n", pPath,
+           pFont->Table.CodeStart, pFont->Table.CodeEnd, pFont->Table.BitmapCount, (size_t)st.st_size);
+    return &pFont->Table;
+}
+
+void FONT_Unload(FONT_TABLE *pFont) {
+    FONT_MAPPED *pMapped = (FONT_MAPPED *)pFont;
+
+    if (!pFont || !pFont->pGlyphs) return;     // built-in tables are not ours
+    if (pMapped->pMap)
+        munmap(pMapped->pMap, pMapped->MapSize);
+    free(pMapped);
+}
+
+static bool GlyphEmpty(const unsigned char *pBits, int CellWidth) {
+    for (int i = 0; i < 2 * CellWidth; i++)
+        if (pBits[i]) return false;
+    return true;
+}
+
+// Columns up to and including the last one with ink
+static int GlyphInkWidth(const unsigned char *pBits, int CellWidth) {
+    for (int x = CellWidth - 1; x >= 0; x--)
+        if (pBits[x] | pBits[CellWidth + x]) return x + 1;
+    return 0;
+}
+
+bool FONT_Write(const FONT_TABLE *pSrc, FILE *fp, bool bProportional) {
+    FONT_FILE_HEADER hdr;
+    FONT_GLYPH glyphs[256];
+    int first = -1, last = -1, width = 1, nBitmaps = 0;
+
+    for (int c = pSrc->CodeStart; c <= pSrc->CodeEnd; c++) {
+        const unsigned char *pBits = FONT_Glyph(pSrc, (unsigned char)c);
+        if (!pBits || GlyphEmpty(pBits, pSrc->CellWidth)) continue;
+        if (first < 0) first = c;
+        last = c;
+        if (GlyphInkWidth(pBits, pSrc->CellWidth) > width)
+            width = GlyphInkWidth(pBits, pSrc->CellWidth);
+    }
+    if (first < 0) {
+        printf("FONT: nothing to save\n");
+        return false;
+    }
+
+    for (int c = first; c <= last; c++) {
+        const unsigned char *pBits = FONT_Glyph(pSrc, (unsigned char)c);
+        FONT_GLYPH *pGlyph = &glyphs[c - first];
+
+        pGlyph->Advance = FONT_Advance(pSrc, (unsigned char)c);
+        if (!pBits || GlyphEmpty(pBits, pSrc->CellWidth)) {
+            pGlyph->Flags = FONT_GLYPH_EMPTY;
+            pGlyph->Index = 0;
+            continue;
+        }
+        pGlyph->Flags = 0;
+        pGlyph->Index = nBitmaps++;
+        if (bProportional)
+            pGlyph->Advance = GlyphInkWidth(pBits, pSrc->CellWidth) + 1;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.Magic, FONT_FILE_MAGIC, 4);
+    hdr.Version = FONT_FILE_VERSION;
+    hdr.CodeStart = first;
+    hdr.CodeEnd = last;
+    hdr.FontWidth = pSrc->FontWidth;
+    hdr.FontHeight = pSrc->FontHeight;
+    hdr.CellWidth = width;
+    hdr.CellHeight = 16;
+    hdr.BitmapCount = nBitmaps;
+    hdr.GlyphOffset = sizeof(hdr);
+    hdr.BitmapOffset = hdr.GlyphOffset + (last - first + 1) * sizeof(FONT_GLYPH);
+
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    fwrite(glyphs, sizeof(FONT_GLYPH), last - first + 1, fp);
+    for (int c = first; c <= last; c++) {
+        const unsigned char *pBits = FONT_Glyph(pSrc, (unsigned char)c);
+        if (glyphs[c - first].Flags & FONT_GLYPH_EMPTY) continue;
+        fwrite(pBits, 1, width, fp);                      // page 0
+        fwrite(pBits + pSrc->CellWidth, 1, width, fp);    // page 1
+    }
+    return !ferror(fp);
+}
+
+bool FONT_Save(const FONT_TABLE *pSrc, const char *pPath, bool bProportional) {
+    FILE *fp = fopen(pPath, "wb");
+    bool bOk;
+
+    if (!fp) {
+        perror("FONT: cannot create font file");
+        return false;
+    }
+    bOk = FONT_Write(pSrc, fp, bProportional);
+    if (fclose(fp) != 0 || !bOk) {
+        perror("FONT: write failed");
+        return false;
+    }
+    return true;
+}
+
+size_t FONT_DataBytes(const FONT_TABLE *pFont) {
+    if (!pFont->pGlyphs)
+        return (size_t)(pFont->CodeEnd - pFont->CodeStart + 1) * sizeof(FONT_BITMAP);
+    return (size_t)(pFont->CodeEnd - pFont->CodeStart + 1) * sizeof(FONT_GLYPH) +
+           (size_t)pFont->BitmapCount * 2 * pFont->CellWidth;
+}
@@ -0,0 +1,53 @@
+#ifndef _FONT_FILE_H_
+#define _FONT_FILE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "font.h"
+
+// Compact font container (.fnt). Only the populated code range is kept,
+// each code has an advance width and an empty flag, and empty glyphs
+// (space, control codes) store no bitmap. Bitmaps are the panel's page
+// format, two pages of CellWidth bytes, trimmed to the widest glyph.
+//
+// Layout, little endian:
+//   FONT_FILE_HEADER
+//   FONT_GLYPH[CodeEnd - CodeStart + 1]    at GlyphOffset
+//   BitmapCount bitmaps                    at BitmapOffset
+
+#define FONT_FILE_MAGIC     "LFNT"
+#define FONT_FILE_VERSION   1
+
+typedef struct {
+    char     Magic[4];
+    uint16_t Version;
+    uint8_t  CodeStart;
+    uint8_t  CodeEnd;
+    uint8_t  FontWidth;
+    uint8_t  FontHeight;
+    uint8_t  CellWidth;
+    uint8_t  CellHeight;     // 16: two pages
+    uint16_t BitmapCount;
+    uint16_t Reserved;
+    uint32_t GlyphOffset;
+    uint32_t BitmapOffset;
+} FONT_FILE_HEADER;
+
+// The returned table points into a read-only mapping of the file
+FONT_TABLE *FONT_Load(const char *pPath);
+// A table over font file contents already in memory (an asset pack
+// entry); the memory must outlive it. pName is for messages.
+FONT_TABLE *FONT_Map(const void *pData, size_t Size, const char *pName);
+void FONT_Unload(FONT_TABLE *pFont);
+
+// Writes pSrc as a compact font, keeping its advances. bProportional
+// sets each advance to the glyph's inked width plus one column instead.
+bool FONT_Save(const FONT_TABLE *pSrc, const char *pPath, bool bProportional);
+bool FONT_Write(const FONT_TABLE *pSrc, FILE *fp, bool bProportional);
+
+// Glyph data a renderer may read: metrics plus bitmaps
+size_t FONT_DataBytes(const FONT_TABLE *pFont);
+
+#endif // _FONT_FILE_H_
@@ -0,0 +1,29 @@
+#ifndef _HOST_TOOL_H_
+#define _HOST_TOOL_H_
+
+#include <stdint.h>
+#include <time.h>
+#include "lcd_graphic.h"
+
+// Helpers shared by the host benches and sims (lcd_*_bench.c,
+// lcd_*_sim.c); not part of the app.
+
+static inline uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// A canvas over a caller-owned frame in the panel's page layout
+static inline void InitCanvas(LCD_CANVAS *pCanvas, uint8_t *pFrame, int Width, int Height) {
+    pCanvas->Width = Width;
+    pCanvas->Height = Height;
+    pCanvas->FrameSize = Width * ((Height + 7) / 8);
+    pCanvas->pFrame = pFrame;
+}
+
+static inline int GetPixel(const LCD_CANVAS *pCanvas, int X, int Y) {
+    return (pCanvas->pFrame[(Y >> 3) * pCanvas->Width + X] >> (Y & 7)) & 1;
+}
+
+#endif // _HOST_TOOL_H_
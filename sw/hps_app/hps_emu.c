@@ -0,0 +1,653 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "hps_emu.h"
+#include "hps_regs.h"
+
+#define GPIO1_BASE_OFFSET      0x03709000
+#define GPIO_SWPORTA_DR        0x00
+
+#define SPIM0_BASE_OFFSET      0x03F00000
+#define SPIM_CTLR0             0x00
+#define SPIM_SSIENR            0x08
+#define SPIM_BAUDR             0x14
+#define SPIM_TXFLR             0x20
+#define SPIM_RXFLR             0x24
+#define SPIM_SR                0x28
+#define SPIM_DMACR             0x4C
+#define SPIM_DR                0x60
+
+#define SPIM_SR_BUSY           0x01
+#define SPIM_SR_TFNF           0x02
+#define SPIM_SR_TFE            0x04
+#define SPIM_SR_RFNE           0x08
+
+#define DMA_BASE_OFFSET        0x03E01000
+#define DMA_FSRC               0x034
+#define DMA_FTR(ch)            (0x040 + (ch) * 4)
+#define DMA_CS(ch)             (0x100 + (ch) * 8)
+#define DMA_CPC(ch)            (0x104 + (ch) * 8)
+#define DMA_DBGSTATUS          0xD00
+#define DMA_DBGCMD             0xD04
+#define DMA_DBGINST0           0xD08
+#define DMA_DBGINST1           0xD0C
+#define DMA_CHANNELS           8
+#define DMA_PERIPH_SPIM0_RX    17
+
+#define OCRAM_BASE_OFFSET      0x03FF0000
+#define OCRAM_SIZE             0x10000
+
+#define HPS_LCM_D_C_BIT        (0x00001000)
+#define HPS_LCM_BACKLIGHT_BIT  (0x00000100)
+
+// fpga_msg_controller.v: message_fsm states and idle_timer period
+#define FSM_INIT               0
+#define FSM_IDLE               1
+#define FSM_HOME               2
+#define FSM_MSG                3
+#define FSM_SLEEP              4
+#define FSM_MSG_COUNT          18
+#define IDLE_TIMEOUT_SEC       15
+#define KEY_HOLD_NS            100000000ull   // how long button_pio reads a press
+#define NS_PER_SEC             1000000000ull
+
+#define EMU_MAX_REGS           64
+#define DMA_INSN_NS            5      // one instruction at the 200 MHz l4_main clock
+#define DMA_BEAT_NS            40     // one AXI beat through the L3 interconnect
+
+typedef struct {
+    uint32_t Offset;
+    uint32_t Value;
+} EMU_REG;
+
+// The LCD transmit thread and the caller share the emulator, so every
+// entry point below runs under one lock
+static pthread_mutex_t gLock = PTHREAD_MUTEX_INITIALIZER;
+
+static EMU_REG  gRegs[EMU_MAX_REGS];
+static int      gRegCount;
+
+static uint32_t gSpiRefClockHz = 200000000u;   // spi_m_clk on the DE10-Standard
+static uint32_t gRegAccessNs   = 120;          // uncached L4 access through the L3
+
+static uint64_t gNowNs;
+static EMU_STATS gStats;
+static EMU_BYTE_SINK gpfnSink;
+static void *gSinkContext;
+
+// SPIM0: TX FIFO, the byte currently in the shifter, and the RX FIFO that
+// fills with one entry per completed byte when TMOD is transmit+receive.
+static uint8_t  gFifo[EMU_SPIM_FIFO_DEPTH];
+static int      gFifoHead, gFifoCount;
+static bool     gShifting;
+static uint8_t  gShiftByte;
+static uint64_t gShiftEndNs;
+static int      gRxCount;
+
+static uint8_t  gOcram[OCRAM_SIZE];
+
+// One DMA-330 channel thread, enough for the subset of the instruction set
+// that LCD_Hw.c emits. Anything else faults the channel like real silicon.
+typedef struct {
+    bool     bRunning;
+    bool     bWaitPeriph;
+    bool     bFault;
+    int      Channel;
+    uint32_t Pc, Sar, Dar, Ccr;
+    uint32_t Lc[2];
+    uint32_t Data;
+    uint64_t NextNs;
+} EMU_DMA;
+
+static EMU_DMA  gDma;
+static uint32_t gDmaFsrc;
+
+// ST7565 controller: display RAM (8 pages + icon page, 132 columns) and
+// the few registers that change what is shown.
+static uint8_t  gPanelRam[9][EMU_PANEL_RAM_COLS];
+static int      gPanelPage, gPanelCol;
+static int      gPanelStartLine;
+static bool     gPanelOn;
+static uint8_t  gPanelArgCmd;      // 0x81 / 0xF8 take a second command byte
+
+// FPGA side: message_fsm + idle_timer as seen through the status PIOs
+static int      gFsmState, gFsmIndex;
+static uint64_t gTimerStartNs;
+static bool     gTimeout;
+static uint32_t gKeysDown;
+static uint64_t gKeysUpNs;
+
+static uint32_t *Reg(uint32_t Offset) {
+    for (int i = 0; i < gRegCount; i++) {
+        if (gRegs[i].Offset == Offset)
+            return &gRegs[i].Value;
+    }
+    if (gRegCount == EMU_MAX_REGS) {
+        fprintf(stderr, "EMU: register table full at offset 0x%08X\n", Offset);
+        return &gRegs[EMU_MAX_REGS - 1].Value;
+    }
+    gRegs[gRegCount].Offset = Offset;
+    gRegs[gRegCount].Value = 0;
+    return &gRegs[gRegCount++].Value;
+}
+
+static bool DcLevel(void) {
+    return (*Reg(GPIO1_BASE_OFFSET + GPIO_SWPORTA_DR) & HPS_LCM_D_C_BIT) != 0;
+}
+
+static bool SpimRxEnabled(void) {
+    return ((*Reg(SPIM0_BASE_OFFSET + SPIM_CTLR0) >> 8) & 0x3) == 0;
+}
+
+static uint64_t ByteTimeNs(void) {
+    uint32_t baud = *Reg(SPIM0_BASE_OFFSET + SPIM_BAUDR) & 0xFFFE;
+    if (baud == 0) baud = 2;
+    return (uint64_t)8 * baud * 1000000000ull / gSpiRefClockHz;
+}
+
+static void PanelCommand(uint8_t Cmd) {
+    if (gPanelArgCmd) {
+        gPanelArgCmd = 0;               // volume / booster value, not shown
+        return;
+    }
+    if ((Cmd & 0xF0) == 0xB0)      gPanelPage = Cmd & 0x0F;
+    else if ((Cmd & 0xF0) == 0x10) gPanelCol = (gPanelCol & 0x0F) | ((Cmd & 0x0F) << 4);
+    else if ((Cmd & 0xF0) == 0x00) gPanelCol = (gPanelCol & 0xF0) | (Cmd & 0x0F);
+    else if ((Cmd & 0xC0) == 0x40) gPanelStartLine = Cmd & 0x3F;
+    else if (Cmd == 0xAE || Cmd == 0xAF) gPanelOn = (Cmd == 0xAF);
+    else if (Cmd == 0x81 || Cmd == 0xF8) gPanelArgCmd = Cmd;
+    else if (Cmd == 0xE2) {
+        gPanelPage = gPanelCol = gPanelStartLine = 0;
+        gPanelOn = false;
+    }
+    // ADC, COM direction, bias, power control, resistor ratio: no effect here
+}
+
+static void PanelData(uint8_t Data) {
+    if (gPanelPage < 9 && gPanelCol < EMU_PANEL_RAM_COLS)
+        gPanelRam[gPanelPage][gPanelCol] = Data;
+    if (gPanelCol < EMU_PANEL_RAM_COLS)
+        gPanelCol++;
+}
+
+static void CompleteByte(void) {
+    bool bIsData = DcLevel();
+    gStats.TxBytes++;
+    if (bIsData) {
+        gStats.DataBytes++;
+        PanelData(gShiftByte);
+    } else {
+        gStats.CmdBytes++;
+        PanelCommand(gShiftByte);
+    }
+    if (gpfnSink)
+        gpfnSink(gSinkContext, bIsData, gShiftByte);
+
+    if (SpimRxEnabled()) {
+        if (gRxCount < EMU_SPIM_FIFO_DEPTH) gRxCount++;
+        else gStats.RxOverflows++;
+        // an RX entry releases a channel parked in DMAWFP
+        if (gDma.bWaitPeriph)
+            gDma.NextNs = gShiftEndNs;
+    }
+}
+
+static void SpimRetire(void) {
+    CompleteByte();
+    if (gFifoCount > 0) {
+        gShiftByte = gFifo[gFifoHead];
+        gFifoHead = (gFifoHead + 1) % EMU_SPIM_FIFO_DEPTH;
+        gFifoCount--;
+        gShiftEndNs += ByteTimeNs();
+    } else {
+        gShifting = false;
+    }
+}
+
+static void SpimPush(uint8_t Data, uint64_t AtNs) {
+    if (!(*Reg(SPIM0_BASE_OFFSET + SPIM_SSIENR) & 1))
+        return;
+    if (!gShifting) {
+        gShifting = true;
+        gShiftByte = Data;
+        gShiftEndNs = AtNs + ByteTimeNs();
+    } else if (gFifoCount < EMU_SPIM_FIFO_DEPTH) {
+        gFifo[(gFifoHead + gFifoCount) % EMU_SPIM_FIFO_DEPTH] = Data;
+        gFifoCount++;
+    } else {
+        gStats.FifoOverflows++;
+    }
+}
+
+static uint32_t SpimStatus(void) {
+    uint32_t sr = 0;
+    if (gShifting || gFifoCount > 0) sr |= SPIM_SR_BUSY;
+    if (gFifoCount < EMU_SPIM_FIFO_DEPTH) sr |= SPIM_SR_TFNF;
+    if (gFifoCount == 0) sr |= SPIM_SR_TFE;
+    if (gRxCount > 0) sr |= SPIM_SR_RFNE;
+    return sr;
+}
+
+static void GpioWriteDr(uint32_t Value) {
+    uint32_t *pDr = Reg(GPIO1_BASE_OFFSET + GPIO_SWPORTA_DR);
+    if (((*pDr ^ Value) & HPS_LCM_D_C_BIT) && (gShifting || gFifoCount > 0))
+        gStats.DcRaces++;
+    *pDr = Value;
+}
+
+// Bus accesses shared by the CPU and the DMA master. Size is in bytes.
+static uint32_t BusRead(uint32_t Offset, int Size) {
+    if (Offset >= OCRAM_BASE_OFFSET && Offset + Size <= OCRAM_BASE_OFFSET + OCRAM_SIZE) {
+        uint32_t v = 0;
+        for (int i = 0; i < Size; i++)
+            v |= (uint32_t)gOcram[Offset - OCRAM_BASE_OFFSET + i] << (8 * i);
+        return v;
+    }
+    switch (Offset) {
+        case SPIM0_BASE_OFFSET + SPIM_SR:    return SpimStatus();
+        case SPIM0_BASE_OFFSET + SPIM_TXFLR: return (uint32_t)gFifoCount;
+        case SPIM0_BASE_OFFSET + SPIM_RXFLR: return (uint32_t)gRxCount;
+        case SPIM0_BASE_OFFSET + SPIM_DR:
+            if (gRxCount > 0) gRxCount--;
+            return 0xFF;   // MISO is not wired on the LCM
+        case DMA_BASE_OFFSET + DMA_FSRC:      return gDmaFsrc;
+        case LWFPGA_OFFSET(BUTTON_PIO_BASE):  return ~gKeysDown & 0x0F;
+        case LWFPGA_OFFSET(FSM_STATUS_PIO_BASE):
+            return ((uint32_t)gFsmState << 5) | (uint32_t)gFsmIndex;
+        case LWFPGA_OFFSET(TIMER_STATUS_PIO_BASE): {
+            uint32_t secs = gTimeout ? 0 : IDLE_TIMEOUT_SEC - (uint32_t)((gNowNs - gTimerStartNs) / NS_PER_SEC);
+            return ((secs & 0x0F) << 1) | (gTimeout ? 1 : 0);
+        }
+        case DMA_BASE_OFFSET + DMA_DBGSTATUS: return 0;
+        default: break;
+    }
+    if (Offset >= DMA_BASE_OFFSET + DMA_CS(0) && Offset < DMA_BASE_OFFSET + DMA_CS(DMA_CHANNELS)) {
+        int ch = (Offset - DMA_BASE_OFFSET - DMA_CS(0)) / 8;
+        bool bCpc = (Offset - DMA_BASE_OFFSET - DMA_CS(0)) % 8 != 0;
+        if (ch != gDma.Channel) return 0;
+        if (bCpc) return gDma.Pc;
+        if (gDma.bFault) return 0xF;
+        if (!gDma.bRunning) return 0x0;
+        return gDma.bWaitPeriph ? 0x7 : 0x1;
+    }
+    return *Reg(Offset);
+}
+
+static void DmaKick(void);
+
+static void BusWrite(uint32_t Offset, int Size, uint32_t Value, uint64_t AtNs) {
+    if (Offset >= OCRAM_BASE_OFFSET && Offset + Size <= OCRAM_BASE_OFFSET + OCRAM_SIZE) {
+        for (int i = 0; i < Size; i++)
+            gOcram[Offset - OCRAM_BASE_OFFSET + i] = (uint8_t)(Value >> (8 * i));
+        return;
+    }
+    switch (Offset) {
+        case SPIM0_BASE_OFFSET + SPIM_DR:
+            SpimPush((uint8_t)Value, AtNs);
+            break;
+
+        case SPIM0_BASE_OFFSET + SPIM_SSIENR:
+            *Reg(Offset) = Value;
+            if (!(Value & 1)) {
+                gFifoHead = gFifoCount = 0;
+                gRxCount = 0;
+                gShifting = false;
+            }
+            break;
+
+        case GPIO1_BASE_OFFSET + GPIO_SWPORTA_DR:
+            GpioWriteDr(Value);
+            break;
+
+        case DMA_BASE_OFFSET + DMA_DBGCMD:
+            *Reg(Offset) = Value;
+            if (Value == 0) DmaKick();
+            break;
+
+        default:
+            *Reg(Offset) = Value;
+            break;
+    }
+}
+
+static void DmaFault(uint32_t Reason) {
+    gDma.bFault = true;
+    gDma.bRunning = false;
+    gDmaFsrc |= 1u << gDma.Channel;
+    *Reg(DMA_BASE_OFFSET + DMA_FTR(gDma.Channel)) = Reason;
+    gStats.DmaFaults++;
+}
+
+// Debug instruction interface: DMAGO from the manager thread and DMAKILL
+// on a channel thread.
+static void DmaKick(void) {
+    uint32_t inst0 = *Reg(DMA_BASE_OFFSET + DMA_DBGINST0);
+    uint32_t inst1 = *Reg(DMA_BASE_OFFSET + DMA_DBGINST1);
+    uint8_t op = (uint8_t)(inst0 >> 16);
+
+    if ((inst0 & 1) && op == 0x01) {
+        if ((int)((inst0 >> 8) & 0x7) == gDma.Channel) {
+            gDma.bRunning = false;
+            gDma.bFault = false;
+            gDmaFsrc &= ~(1u << gDma.Channel);
+        }
+        return;
+    }
+    if ((inst0 & 1) || (op & 0xFD) != 0xA0) {
+        fprintf(stderr, "EMU: unsupported DMA debug instruction 0x%08X\n", inst0);
+        return;
+    }
+    memset(&gDma, 0, sizeof(gDma));
+    gDma.Channel = (inst0 >> 24) & 0x7;
+    gDma.Pc = inst1;
+    gDma.bRunning = true;
+    gDma.NextNs = gNowNs;
+    gDmaFsrc &= ~(1u << gDma.Channel);
+}
+
+static bool DmaFetch(uint32_t Pc, int Len, uint8_t *pInsn) {
+    uint32_t ofs = Pc - HW_REGS_BASE;
+    if (Pc < HW_REGS_BASE || ofs < OCRAM_BASE_OFFSET || ofs + Len > OCRAM_BASE_OFFSET + OCRAM_SIZE)
+        return false;
+    memcpy(pInsn, &gOcram[ofs - OCRAM_BASE_OFFSET], Len);
+    return true;
+}
+
+static void DmaStep(void) {
+    uint8_t insn[6];
+    uint32_t size, ofs;
+    uint64_t at = gDma.NextNs;
+
+    if (!DmaFetch(gDma.Pc, 1, insn)) { DmaFault(1u << 16); return; }
+    gDma.NextNs += DMA_INSN_NS;
+    gStats.DmaInsns++;
+
+    switch (insn[0]) {
+        case 0x00:   // DMAEND
+            gDma.bRunning = false;
+            break;
+
+        case 0x12:   // DMARMB
+        case 0x13:   // DMAWMB
+        case 0x18:   // DMANOP
+            gDma.Pc += 1;
+            break;
+
+        case 0xBC:   // DMAMOV
+            if (!DmaFetch(gDma.Pc, 6, insn)) { DmaFault(1u << 16); return; }
+            ofs = insn[2] | (insn[3] << 8) | (insn[4] << 16) | ((uint32_t)insn[5] << 24);
+            if (insn[1] == 0)      gDma.Sar = ofs;
+            else if (insn[1] == 1) gDma.Ccr = ofs;
+            else if (insn[1] == 2) gDma.Dar = ofs;
+            else { DmaFault(1u << 0); return; }
+            gDma.Pc += 6;
+            break;
+
+        case 0x20:   // DMALP lc0
+        case 0x22:   // DMALP lc1
+            DmaFetch(gDma.Pc, 2, insn);
+            gDma.Lc[(insn[0] >> 1) & 1] = insn[1];
+            gDma.Pc += 2;
+            break;
+
+        case 0x38:   // DMALPEND lc0
+        case 0x3C:   // DMALPEND lc1
+            DmaFetch(gDma.Pc, 2, insn);
+            if (gDma.Lc[(insn[0] >> 2) & 1]-- > 0)
+                gDma.Pc -= insn[1];
+            else
+                gDma.Pc += 2;
+            break;
+
+        case 0x35:   // DMAFLUSHP
+            gDma.Pc += 2;
+            break;
+
+        case 0x30:   // DMAWFP single
+            DmaFetch(gDma.Pc, 2, insn);
+            if ((insn[1] >> 3) != DMA_PERIPH_SPIM0_RX ||
+                !(*Reg(SPIM0_BASE_OFFSET + SPIM_DMACR) & 0x1)) {
+                DmaFault(1u << 1);
+                return;
+            }
+            if (gRxCount == 0) {
+                gDma.bWaitPeriph = true;
+                gDma.NextNs = UINT64_MAX;
+                return;
+            }
+            gDma.bWaitPeriph = false;
+            gDma.Pc += 2;
+            break;
+
+        case 0x04:   // DMALD
+        case 0x25:   // DMALDPS
+            size = 1u << ((gDma.Ccr >> 1) & 0x7);
+            if (gDma.Sar < HW_REGS_BASE || size > 4) { DmaFault(1u << 16); return; }
+            gDma.Data = BusRead(gDma.Sar - HW_REGS_BASE, size);
+            if (gDma.Ccr & 0x1) gDma.Sar += size;
+            gDma.NextNs += DMA_BEAT_NS;
+            gDma.Pc += (insn[0] == 0x04) ? 1 : 2;
+            break;
+
+        case 0x08:   // DMAST
+            size = 1u << ((gDma.Ccr >> 15) & 0x7);
+            if (gDma.Dar < HW_REGS_BASE || size > 4) { DmaFault(1u << 16); return; }
+            BusWrite(gDma.Dar - HW_REGS_BASE, size, gDma.Data, at);
+            if (gDma.Ccr & (1u << 14)) gDma.Dar += size;
+            gDma.NextNs += DMA_BEAT_NS;
+            gDma.Pc += 1;
+            break;
+
+        default:
+            fprintf(stderr, "EMU: DMA opcode 0x%02X at 0x%08X not modelled\n", insn[0], gDma.Pc);
+            DmaFault(1u << 0);
+            break;
+    }
+}
+
+static void FpgaAdvance(void) {
+    if (gFsmState == FSM_INIT && gNowNs > 0)
+        gFsmState = FSM_IDLE;
+    if (!gTimeout && gNowNs - gTimerStartNs >= IDLE_TIMEOUT_SEC * NS_PER_SEC) {
+        gTimeout = true;
+        if (gFsmState == FSM_HOME || gFsmState == FSM_MSG)
+            gFsmState = FSM_SLEEP;
+    }
+    if (gKeysDown && gNowNs >= gKeysUpNs)
+        gKeysDown = 0;
+}
+
+// Run the SPI shifter and the DMA channel in time order up to gNowNs.
+static void Advance(void) {
+    FpgaAdvance();
+    for (;;) {
+        uint64_t tSpi = gShifting ? gShiftEndNs : UINT64_MAX;
+        uint64_t tDma = gDma.bRunning ? gDma.NextNs : UINT64_MAX;
+
+        if (tSpi > gNowNs && tDma > gNowNs)
+            break;
+        if (tSpi <= tDma) SpimRetire();
+        else              DmaStep();
+    }
+}
+
+void EMU_Reset(void) {
+    gRegCount = 0;
+    gNowNs = 0;
+    gFifoHead = gFifoCount = 0;
+    gRxCount = 0;
+    gShifting = false;
+    gpfnSink = NULL;
+    gSinkContext = NULL;
+    memset(&gDma, 0, sizeof(gDma));
+    gDmaFsrc = 0;
+    memset(gOcram, 0, sizeof(gOcram));
+    memset(&gStats, 0, sizeof(gStats));
+
+    memset(gPanelRam, 0, sizeof(gPanelRam));
+    gPanelPage = gPanelCol = gPanelStartLine = 0;
+    gPanelOn = false;
+    gPanelArgCmd = 0;
+
+    gFsmState = FSM_INIT;
+    gFsmIndex = 0;
+    gTimerStartNs = 0;
+    gTimeout = false;
+    gKeysDown = 0;
+}
+
+// One debounced press as btn_pulse sees it: transitions per message_fsm.v
+// and an idle timer restart.
+void EMU_PressKey(int Key) {
+    uint32_t pulse = 1u << (Key & 3);
+
+    pthread_mutex_lock(&gLock);
+    Advance();
+    switch (gFsmState) {
+        case FSM_IDLE:
+        case FSM_SLEEP:
+            gFsmState = (gFsmState == FSM_IDLE) ? FSM_HOME : FSM_IDLE;
+            break;
+        case FSM_HOME:
+            if (pulse & 0x1) gFsmState = FSM_IDLE;
+            else if (pulse & 0x6) {
+                gFsmState = FSM_MSG;
+                gFsmIndex = 0;
+            }
+            break;
+        case FSM_MSG:
+            if (pulse & 0x1) gFsmState = FSM_HOME;
+            else if (pulse & 0x2) gFsmIndex = (gFsmIndex + 1) % FSM_MSG_COUNT;
+            else if (pulse & 0x4) gFsmIndex = (gFsmIndex + FSM_MSG_COUNT - 1) % FSM_MSG_COUNT;
+            break;
+        default:
+            break;
+    }
+    gTimerStartNs = gNowNs;
+    gTimeout = false;
+    gKeysDown = pulse;
+    gKeysUpNs = gNowNs + KEY_HOLD_NS;
+    pthread_mutex_unlock(&gLock);
+}
+
+// The 128x64 picture as page-format bytes, start line applied.
+void EMU_GetPanel(uint8_t *pFrame) {
+    memset(pFrame, 0, EMU_PANEL_WIDTH * EMU_PANEL_HEIGHT / 8);
+    pthread_mutex_lock(&gLock);
+    for (int y = 0; gPanelOn && y < EMU_PANEL_HEIGHT; y++) {
+        int line = (y + gPanelStartLine) % EMU_PANEL_HEIGHT;
+        for (int x = 0; x < EMU_PANEL_WIDTH; x++) {
+            if (gPanelRam[line >> 3][x] & (1 << (line & 7)))
+                pFrame[(y >> 3) * EMU_PANEL_WIDTH + x] |= 1 << (y & 7);
+        }
+    }
+    pthread_mutex_unlock(&gLock);
+}
+
+bool EMU_BackLightOn(void) {
+    bool bOn;
+
+    pthread_mutex_lock(&gLock);
+    bOn = (*Reg(GPIO1_BASE_OFFSET + GPIO_SWPORTA_DR) & HPS_LCM_BACKLIGHT_BIT) != 0;
+    pthread_mutex_unlock(&gLock);
+    return bOn;
+}
+
+// Binary PBM (P4), 1 = dark pixel
+bool EMU_DumpPbm(const char *pPath) {
+    uint8_t frame[EMU_PANEL_WIDTH * EMU_PANEL_HEIGHT / 8];
+    FILE *fp = fopen(pPath, "wb");
+
+    if (!fp) {
+        perror(pPath);
+        return false;
+    }
+    EMU_GetPanel(frame);
+    fprintf(fp, "P4\n%d %d\n", EMU_PANEL_WIDTH, EMU_PANEL_HEIGHT);
+    for (int y = 0; y < EMU_PANEL_HEIGHT; y++) {
+        uint8_t row[EMU_PANEL_WIDTH / 8] = { 0 };
+        for (int x = 0; x < EMU_PANEL_WIDTH; x++) {
+            if (frame[(y >> 3) * EMU_PANEL_WIDTH + x] & (1 << (y & 7)))
+                row[x >> 3] |= 0x80 >> (x & 7);
+        }
+        fwrite(row, 1, sizeof(row), fp);
+    }
+    return fclose(fp) == 0;
+}
+
+void EMU_SetTiming(uint32_t SpiRefClockHz, uint32_t RegAccessNs) {
+    gSpiRefClockHz = SpiRefClockHz;
+    gRegAccessNs = RegAccessNs;
+}
+
+void EMU_SetByteSink(EMU_BYTE_SINK pfnSink, void *pContext) {
+    gpfnSink = pfnSink;
+    gSinkContext = pContext;
+}
+
+uint32_t EMU_Read32(uint32_t Offset) {
+    uint32_t Value;
+
+    pthread_mutex_lock(&gLock);
+    gNowNs += gRegAccessNs;
+    gStats.RegReads++;
+    Advance();
+    Value = BusRead(Offset, 4);
+    pthread_mutex_unlock(&gLock);
+    return Value;
+}
+
+void EMU_Write32(uint32_t Offset, uint32_t Value) {
+    pthread_mutex_lock(&gLock);
+    gNowNs += gRegAccessNs;
+    gStats.RegWrites++;
+    Advance();
+    BusWrite(Offset, 4, Value, gNowNs);
+    pthread_mutex_unlock(&gLock);
+}
+
+uint64_t EMU_NowNs(void) {
+    uint64_t Now;
+
+    pthread_mutex_lock(&gLock);
+    Now = gNowNs;
+    pthread_mutex_unlock(&gLock);
+    return Now;
+}
+
+void EMU_AdvanceNs(uint64_t Ns) {
+    pthread_mutex_lock(&gLock);
+    gNowNs += Ns;
+    Advance();
+    pthread_mutex_unlock(&gLock);
+}
+
+void EMU_GetStats(EMU_STATS *pStats) {
+    pthread_mutex_lock(&gLock);
+    *pStats = gStats;
+    pthread_mutex_unlock(&gLock);
+}
+
+void EMU_ClearStats(void) {
+    pthread_mutex_lock(&gLock);
+    memset(&gStats, 0, sizeof(gStats));
+    pthread_mutex_unlock(&gLock);
+}
+
+static bool Emu_Open(void) {
+    EMU_Reset();
+    return true;
+}
+
+static void Emu_Close(void) {
+}
+
+const HPS_REG_OPS HPSREG_Emu = {
+    "emulator",
+    Emu_Open,
+    Emu_Close,
+    EMU_Read32,
+    EMU_Write32
+};
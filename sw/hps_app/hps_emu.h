@@ -0,0 +1,57 @@
+#ifndef _HPS_EMU_H_
+#define _HPS_EMU_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Host-side stand-in for the HPS register window (HW_REGS_BASE, 64 MB).
+// Offsets are relative to HW_REGS_BASE, the same offsets LCD_Hw.c adds to
+// virtual_base. SPIM0 is modelled with a 256-entry TX FIFO that drains at
+// the programmed SCLK rate on a virtual clock; every register access also
+// advances that clock, so frame times measured here track the real bus.
+// The DMA-330 runs channel programs out of the modelled 64 KB OCRAM on the
+// same clock, interleaved with the shifter. Bytes that reach the panel are
+// decoded as ST7565 commands/data into display RAM, and the FPGA status
+// PIOs follow message_fsm.v and idle_timer.v driven by EMU_PressKey.
+// Select it with HPSREG_Open(&HPSREG_Emu).
+
+#define EMU_SPIM_FIFO_DEPTH    256
+#define EMU_PANEL_WIDTH        128
+#define EMU_PANEL_HEIGHT       64
+#define EMU_PANEL_RAM_COLS     132
+
+typedef struct {
+    uint64_t RegReads;
+    uint64_t RegWrites;
+    uint64_t TxBytes;        // bytes shifted out on MOSI
+    uint64_t CmdBytes;       // ...sampled with D/C low
+    uint64_t DataBytes;      // ...sampled with D/C high
+    uint64_t DcRaces;        // D/C toggled while a byte was still in flight
+    uint64_t FifoOverflows;  // DR written with the TX FIFO full
+    uint64_t RxOverflows;    // completed byte found the RX FIFO full (TX+RX mode)
+    uint64_t DmaInsns;       // DMA-330 channel instructions executed
+    uint64_t DmaFaults;
+} EMU_STATS;
+
+// Called for every byte as it completes on the wire, with the D/C level
+// the panel sampled for it.
+typedef void (*EMU_BYTE_SINK)(void *pContext, bool bIsData, uint8_t Data);
+
+void     EMU_Reset(void);
+void     EMU_SetTiming(uint32_t SpiRefClockHz, uint32_t RegAccessNs);
+void     EMU_SetByteSink(EMU_BYTE_SINK pfnSink, void *pContext);
+
+uint32_t EMU_Read32(uint32_t Offset);
+void     EMU_Write32(uint32_t Offset, uint32_t Value);
+
+uint64_t EMU_NowNs(void);
+void     EMU_AdvanceNs(uint64_t Ns);
+void     EMU_GetStats(EMU_STATS *pStats);
+void     EMU_ClearStats(void);
+
+void     EMU_PressKey(int Key);
+void     EMU_GetPanel(uint8_t *pFrame);
+bool     EMU_BackLightOn(void);
+bool     EMU_DumpPbm(const char *pPath);
+
+#endif // _HPS_EMU_H_
@@ -0,0 +1,75 @@
+#include <stdio.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hps_regs.h"
+
+const HPS_REG_OPS *gpHpsRegOps = NULL;
+
+static int gMemFd = -1;
+static volatile uint8_t *gpRegBase = MAP_FAILED;
+
+static bool DevMem_Open(void) {
+    gMemFd = open("/dev/mem", O_RDWR | O_SYNC);
+    if (gMemFd < 0) {
+        perror("ERROR: Cannot open /dev/mem");
+        return false;
+    }
+    gpRegBase = mmap(NULL, HW_REGS_SPAN, PROT_READ | PROT_WRITE, MAP_SHARED, gMemFd, HW_REGS_BASE);
+    if (gpRegBase == MAP_FAILED) {
+        perror("ERROR: mmap failed");
+        close(gMemFd);
+        gMemFd = -1;
+        return false;
+    }
+    printf("  virtual_base = %p\n", (void *)gpRegBase);
+    return true;
+}
+
+static void DevMem_Close(void) {
+    if (gpRegBase != MAP_FAILED) {
+        munmap((void *)gpRegBase, HW_REGS_SPAN);
+        gpRegBase = MAP_FAILED;
+    }
+    if (gMemFd >= 0) {
+        close(gMemFd);
+        gMemFd = -1;
+    }
+}
+
+static uint32_t DevMem_Read32(uint32_t Offset) {
+    return *(volatile uint32_t *)(gpRegBase + Offset);
+}
+
+static void DevMem_Write32(uint32_t Offset, uint32_t Value) {
+    *(volatile uint32_t *)(gpRegBase + Offset) = Value;
+}
+
+const HPS_REG_OPS HPSREG_DevMem = {
+    "/dev/mem",
+    DevMem_Open,
+    DevMem_Close,
+    DevMem_Read32,
+    DevMem_Write32
+};
+
+bool HPSREG_Open(const HPS_REG_OPS *pOps) {
+    HPSREG_Close();
+    if (!pOps->pfnOpen())
+        return false;
+    gpHpsRegOps = pOps;
+    return true;
+}
+
+void HPSREG_Close(void) {
+    if (gpHpsRegOps) {
+        gpHpsRegOps->pfnClose();
+        gpHpsRegOps = NULL;
+    }
+}
+
+bool HPSREG_IsOpen(void) {
+    return gpHpsRegOps != NULL;
+}
@@ -0,0 +1,48 @@
+#ifndef _HPS_REGS_H_
+#define _HPS_REGS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Register access for everything above the HPS bus. Offsets are relative
+// to HW_REGS_BASE (0xFC000000), the 64 MB window that covers the HPS
+// peripherals, OCRAM and the lightweight FPGA bridge. The backend is
+// chosen at runtime: /dev/mem on the board, or the in-process emulator
+// (hps_emu.c) so the application can run and be profiled on a host.
+
+#define HW_REGS_BASE          0xFC000000
+#define HW_REGS_SPAN          0x04000000
+#define HW_REGS_MASK          (HW_REGS_SPAN - 1)
+
+// Lightweight HPS-to-FPGA bridge PIOs (see README register map)
+#define ALT_LWFPGASLVS_OFST   0xFF200000
+#define BUTTON_PIO_BASE       0x5000
+#define FSM_STATUS_PIO_BASE   0x6000
+#define TIMER_STATUS_PIO_BASE 0x7000
+#define LWFPGA_OFFSET(base)   ((ALT_LWFPGASLVS_OFST + (base)) & HW_REGS_MASK)
+
+typedef struct {
+    const char *pName;
+    bool     (*pfnOpen)(void);
+    void     (*pfnClose)(void);
+    uint32_t (*pfnRead32)(uint32_t Offset);
+    void     (*pfnWrite32)(uint32_t Offset, uint32_t Value);
+} HPS_REG_OPS;
+
+extern const HPS_REG_OPS HPSREG_DevMem;
+extern const HPS_REG_OPS HPSREG_Emu;
+extern const HPS_REG_OPS *gpHpsRegOps;
+
+bool HPSREG_Open(const HPS_REG_OPS *pOps);
+void HPSREG_Close(void);
+bool HPSREG_IsOpen(void);
+
+static inline uint32_t HPSREG_Read32(uint32_t Offset) {
+    return gpHpsRegOps->pfnRead32(Offset);
+}
+
+static inline void HPSREG_Write32(uint32_t Offset, uint32_t Value) {
+    gpHpsRegOps->pfnWrite32(Offset, Value);
+}
+
+#endif // _HPS_REGS_H_
@@ -0,0 +1,375 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "image.h"
+#include "log.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define IMAGE_NEON  1
+#endif
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define IMAGE_SSE2  1
+#endif
+#if defined(IMAGE_SSE2) && defined(__GNUC__)
+#include <immintrin.h>
+#define IMAGE_AVX2  1               // built with target("avx2"), used if the CPU has it
+#endif
+
+// Converts the whole pages 0..Pages-1 over the whole source bytes
+// 0..Cols-1 of each row; Width is the destination row length
+typedef void (*KERNEL_FN)(uint8_t *pDst, int Width, const uint8_t *pRows, int Stride, int Pages, int Cols);
+
+static int gKernel = -1;
+
+// 8x8 bit matrix transpose in a word, element (i, j) at bit 8i + j
+static inline uint64_t Transpose8(uint64_t x) {
+    uint64_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAull;
+    x = x ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCull;
+    x = x ^ t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ull;
+    return x ^ t ^ (t << 28);
+}
+
+// One source byte of eight rows to eight page bytes. Row r is byte r of
+// the word; after the transpose byte j holds pixel column 7 - j, so the
+// byte swap puts column c at byte c (little-endian store).
+static inline void Block8(uint8_t *pDst, const uint8_t *pSrc, int Stride) {
+    uint64_t x = 0;
+
+    for (int r = 0; r < 8; r++)
+        x |= (uint64_t)pSrc[r * Stride] << (8 * r);
+    x = __builtin_bswap64(Transpose8(x));
+    memcpy(pDst, &x, 8);
+}
+
+static void KernelSwar(uint8_t *pDst, int Width, const uint8_t *pRows, int Stride, int Pages, int Cols) {
+    for (int p = 0; p < Pages; p++)
+        for (int k = 0; k < Cols; k++)
+            Block8(pDst + p * Width + k * 8, pRows + p * 8 * Stride + k, Stride);
+}
+
+// Page bytes the kernels leave out: columns right of the last whole
+// source byte, and the last page when the height is not a multiple of 8.
+// With Pages = Cols = 0 this is the per-pixel reference.
+static void Tail(LCD_CANVAS *pDst, const uint8_t *pRows, int Stride, int Pages, int Cols) {
+    int nPages = (pDst->Height + 7) / 8;
+
+    for (int p = 0; p < nPages; p++) {
+        for (int x = p < Pages ? Cols * 8 : 0; x < pDst->Width; x++) {
+            uint8_t Byte = 0;
+
+            for (int r = 0; r < 8 && p * 8 + r < pDst->Height; r++)
+                if (pRows[(p * 8 + r) * Stride + (x >> 3)] & (0x80 >> (x & 7)))
+                    Byte |= 1 << r;
+            pDst->pFrame[p * pDst->Width + x] = Byte;
+        }
+    }
+}
+
+#ifdef IMAGE_SSE2
+// Byte transpose of 16 rows of 16 bytes: each unpack round rotates the
+// (row, column) index bits by one, four rounds swap them
+static inline void Transpose16x16(__m128i *v) {
+    __m128i t[16];
+
+    for (int s = 0; s < 4; s++) {
+        for (int i = 0; i < 8; i++) {
+            t[2 * i] = _mm_unpacklo_epi8(v[i], v[i + 8]);
+            t[2 * i + 1] = _mm_unpackhi_epi8(v[i], v[i + 8]);
+        }
+        memcpy(v, t, sizeof(t));
+    }
+}
+
+// Transpose8 on both 64-bit halves, then the byte swap of each half
+// (16-bit words reversed, then the bytes in each word)
+static inline __m128i Transpose8x2(__m128i x) {
+    __m128i t;
+
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 7)), _mm_set1_epi64x(0x00AA00AA00AA00AAll));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 7));
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 14)), _mm_set1_epi64x(0x0000CCCC0000CCCCll));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 14));
+    t = _mm_and_si128(_mm_xor_si128(x, _mm_srli_epi64(x, 28)), _mm_set1_epi64x(0x00000000F0F0F0F0ll));
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm_slli_epi64(t, 28));
+    x = _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0x1B), 0x1B);
+    return _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+}
+
+// Two pages at a time: after the byte transpose register j holds source
+// byte j of all 16 rows, i.e. the 8x8 blocks of both pages as 64-bit
+// halves, and one Transpose8x2 turns them into page bytes
+static void KernelSse2(uint8_t *pDst, int Width, const uint8_t *pRows, int Stride, int Pages, int Cols) {
+    int p = 0;
+
+    for (; p + 2 <= Pages; p += 2) {
+        const uint8_t *pBand = pRows + p * 8 * Stride;
+        uint8_t *pOut = pDst + p * Width;
+        int k = 0;
+
+        for (; k + 16 <= Cols; k += 16) {
+            __m128i v[16];
+
+            for (int r = 0; r < 16; r++)
+                v[r] = _mm_loadu_si128((const __m128i *)(pBand + r * Stride + k));
+            Transpose16x16(v);
+            for (int j = 0; j < 16; j++) {
+                __m128i x = Transpose8x2(v[j]);
+
+                _mm_storel_epi64((__m128i *)(pOut + (k + j) * 8), x);
+                _mm_storel_epi64((__m128i *)(pOut + Width + (k + j) * 8), _mm_unpackhi_epi64(x, x));
+            }
+        }
+        for (; k < Cols; k++) {
+            Block8(pOut + k * 8, pBand + k, Stride);
+            Block8(pOut + Width + k * 8, pBand + 8 * Stride + k, Stride);
+        }
+    }
+    KernelSwar(pDst + p * Width, Width, pRows + p * 8 * Stride, Stride, Pages - p, Cols);
+}
+#endif
+
+#ifdef IMAGE_AVX2
+// Four pages at a time: rows 0-15 in the low lane and 16-31 in the high
+// one, so after the (in-lane) byte transpose each register holds the
+// 8x8 blocks of one source byte for all four pages
+__attribute__((target("avx2")))
+static void KernelAvx2(uint8_t *pDst, int Width, const uint8_t *pRows, int Stride, int Pages, int Cols) {
+    const __m256i Swap = _mm256_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+                                         8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i K1 = _mm256_set1_epi64x(0x00AA00AA00AA00AAll);
+    const __m256i K2 = _mm256_set1_epi64x(0x0000CCCC0000CCCCll);
+    const __m256i K4 = _mm256_set1_epi64x(0x00000000F0F0F0F0ll);
+    int p = 0;
+
+    for (; p + 4 <= Pages; p += 4) {
+        const uint8_t *pBand = pRows + p * 8 * Stride;
+        uint8_t *pOut = pDst + p * Width;
+        int k = 0;
+
+        for (; k + 16 <= Cols; k += 16) {
+            __m256i v[16], t[16];
+
+            for (int r = 0; r < 16; r++)
+                v[r] = _mm256_set_m128i(_mm_loadu_si128((const __m128i *)(pBand + (r + 16) * Stride + k)),
+                                        _mm_loadu_si128((const __m128i *)(pBand + r * Stride + k)));
+            for (int s = 0; s < 4; s++) {
+                for (int i = 0; i < 8; i++) {
+                    t[2 * i] = _mm256_unpacklo_epi8(v[i], v[i + 8]);
+                    t[2 * i + 1] = _mm256_unpackhi_epi8(v[i], v[i + 8]);
+                }
+                memcpy(v, t, sizeof(t));
+            }
+            for (int j = 0; j < 16; j++) {
+                uint8_t *pCol = pOut + (k + j) * 8;
+                __m256i x = v[j], s;
+                __m128i lo, hi;
+
+                s = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 7)), K1);
+                x = _mm256_xor_si256(_mm256_xor_si256(x, s), _mm256_slli_epi64(s, 7));
+                s = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 14)), K2);
+                x = _mm256_xor_si256(_mm256_xor_si256(x, s), _mm256_slli_epi64(s, 14));
+                s = _mm256_and_si256(_mm256_xor_si256(x, _mm256_srli_epi64(x, 28)), K4);
+                x = _mm256_xor_si256(_mm256_xor_si256(x, s), _mm256_slli_epi64(s, 28));
+                x = _mm256_shuffle_epi8(x, Swap);
+                lo = _mm256_castsi256_si128(x);
+                hi = _mm256_extracti128_si256(x, 1);
+                _mm_storel_epi64((__m128i *)pCol, lo);
+                _mm_storel_epi64((__m128i *)(pCol + Width), _mm_unpackhi_epi64(lo, lo));
+                _mm_storel_epi64((__m128i *)(pCol + 2 * Width), hi);
+                _mm_storel_epi64((__m128i *)(pCol + 3 * Width), _mm_unpackhi_epi64(hi, hi));
+            }
+        }
+        for (; k < Cols; k++)
+            for (int q = 0; q < 4; q++)
+                Block8(pOut + q * Width + k * 8, pBand + q * 8 * Stride + k, Stride);
+    }
+    KernelSse2(pDst + p * Width, Width, pRows + p * 8 * Stride, Stride, Pages - p, Cols);
+}
+#endif
+
+#ifdef IMAGE_NEON
+static inline uint64x2_t Transpose8q(uint64x2_t x) {
+    uint64x2_t t;
+
+    t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 7)), vdupq_n_u64(0x00AA00AA00AA00AAull));
+    x = veorq_u64(veorq_u64(x, t), vshlq_n_u64(t, 7));
+    t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 14)), vdupq_n_u64(0x0000CCCC0000CCCCull));
+    x = veorq_u64(veorq_u64(x, t), vshlq_n_u64(t, 14));
+    t = vandq_u64(veorq_u64(x, vshrq_n_u64(x, 28)), vdupq_n_u64(0x00000000F0F0F0F0ull));
+    return veorq_u64(veorq_u64(x, t), vshlq_n_u64(t, 28));
+}
+
+// Two source bytes (already one word per byte, row r in byte r) to 16
+// page bytes: Transpose8 on both halves, then the byte swap
+static inline void Store2(uint8_t *pDst, uint32x2_t a, uint32x2_t b) {
+    uint64x2_t x = vcombine_u64(vreinterpret_u64_u32(a), vreinterpret_u64_u32(b));
+
+    vst1q_u8(pDst, vrev64q_u8(vreinterpretq_u8_u64(Transpose8q(x))));
+}
+
+// Eight rows of eight source bytes: vtrn at 8, 16 and 32 bits turns them
+// into one word per source byte
+static void KernelNeon(uint8_t *pDst, int Width, const uint8_t *pRows, int Stride, int Pages, int Cols) {
+    for (int p = 0; p < Pages; p++) {
+        const uint8_t *pBand = pRows + p * 8 * Stride;
+        uint8_t *pOut = pDst + p * Width;
+        int k = 0;
+
+        for (; k + 8 <= Cols; k += 8) {
+            uint8x8x2_t t01 = vtrn_u8(vld1_u8(pBand + k), vld1_u8(pBand + Stride + k));
+            uint8x8x2_t t23 = vtrn_u8(vld1_u8(pBand + 2 * Stride + k), vld1_u8(pBand + 3 * Stride + k));
+            uint8x8x2_t t45 = vtrn_u8(vld1_u8(pBand + 4 * Stride + k), vld1_u8(pBand + 5 * Stride + k));
+            uint8x8x2_t t67 = vtrn_u8(vld1_u8(pBand + 6 * Stride + k), vld1_u8(pBand + 7 * Stride + k));
+            uint16x4x2_t u02 = vtrn_u16(vreinterpret_u16_u8(t01.val[0]), vreinterpret_u16_u8(t23.val[0]));
+            uint16x4x2_t u13 = vtrn_u16(vreinterpret_u16_u8(t01.val[1]), vreinterpret_u16_u8(t23.val[1]));
+            uint16x4x2_t u46 = vtrn_u16(vreinterpret_u16_u8(t45.val[0]), vreinterpret_u16_u8(t67.val[0]));
+            uint16x4x2_t u57 = vtrn_u16(vreinterpret_u16_u8(t45.val[1]), vreinterpret_u16_u8(t67.val[1]));
+            // cN.val[0] is source byte N, cN.val[1] byte N + 4
+            uint32x2x2_t c0 = vtrn_u32(vreinterpret_u32_u16(u02.val[0]), vreinterpret_u32_u16(u46.val[0]));
+            uint32x2x2_t c1 = vtrn_u32(vreinterpret_u32_u16(u13.val[0]), vreinterpret_u32_u16(u57.val[0]));
+            uint32x2x2_t c2 = vtrn_u32(vreinterpret_u32_u16(u02.val[1]), vreinterpret_u32_u16(u46.val[1]));
+            uint32x2x2_t c3 = vtrn_u32(vreinterpret_u32_u16(u13.val[1]), vreinterpret_u32_u16(u57.val[1]));
+
+            Store2(pOut + k * 8, c0.val[0], c1.val[0]);
+            Store2(pOut + k * 8 + 16, c2.val[0], c3.val[0]);
+            Store2(pOut + k * 8 + 32, c0.val[1], c1.val[1]);
+            Store2(pOut + k * 8 + 48, c2.val[1], c3.val[1]);
+        }
+        for (; k < Cols; k++)
+            Block8(pOut + k * 8, pBand + k, Stride);
+    }
+}
+#endif
+
+static KERNEL_FN KernelFn(int Kernel) {
+    switch (Kernel) {
+    case IMAGE_KERNEL_SWAR: return KernelSwar;
+#ifdef IMAGE_SSE2
+    case IMAGE_KERNEL_SSE2: return KernelSse2;
+#endif
+#ifdef IMAGE_AVX2
+    case IMAGE_KERNEL_AVX2: return __builtin_cpu_supports("avx2") ? KernelAvx2 : NULL;
+#endif
+#ifdef IMAGE_NEON
+    case IMAGE_KERNEL_NEON: return KernelNeon;
+#endif
+    default: return NULL;
+    }
+}
+
+bool IMAGE_SetKernel(int Kernel) {
+    if (Kernel != IMAGE_KERNEL_REF && !KernelFn(Kernel)) return false;
+    gKernel = Kernel;
+    return true;
+}
+
+int IMAGE_GetKernel(void) {
+    static const int Best[] = { IMAGE_KERNEL_NEON, IMAGE_KERNEL_AVX2, IMAGE_KERNEL_SSE2, IMAGE_KERNEL_SWAR };
+
+    for (int i = 0; gKernel < 0; i++)
+        if (KernelFn(Best[i])) gKernel = Best[i];
+    return gKernel;
+}
+
+const char *IMAGE_KernelName(int Kernel) {
+    static const char *const Names[IMAGE_KERNELS] = { "reference", "64-bit SWAR", "SSE2", "AVX2", "NEON" };
+    return Kernel >= 0 && Kernel < IMAGE_KERNELS ? Names[Kernel] : "?";
+}
+
+void IMAGE_RowsToPages(LCD_CANVAS *pDst, const uint8_t *pRows, int Stride) {
+    int Kernel = IMAGE_GetKernel();
+    int Pages = Kernel == IMAGE_KERNEL_REF ? 0 : pDst->Height / 8;
+    int Cols = Kernel == IMAGE_KERNEL_REF ? 0 : pDst->Width / 8;
+
+    if (Pages && Cols)
+        KernelFn(Kernel)(pDst->pFrame, pDst->Width, pRows, Stride, Pages, Cols);
+    Tail(pDst, pRows, Stride, Pages, Cols);
+}
+
+// Header field of a PBM: skips whitespace and comments, reads a number
+static bool PbmNumber(const char **pp, const char *pEnd, int *pValue) {
+    const char *p = *pp;
+    long Value = 0;
+
+    for (;;) {
+        while (p < pEnd && isspace((unsigned char)*p)) p++;
+        if (p < pEnd && *p == '#') {
+            while (p < pEnd && *p != '\n') p++;
+            continue;
+        }
+        break;
+    }
+    if (p == pEnd || !isdigit((unsigned char)*p)) return false;
+    while (p < pEnd && isdigit((unsigned char)*p) && Value < 100000)
+        Value = Value * 10 + (*p++ - '0');
+    *pValue = (int)Value;
+    *pp = p;
+    return Value > 0 && Value < 100000;
+}
+
+bool IMAGE_LoadPbm(const char *pPath, LCD_CANVAS *pCanvas) {
+    const char *p, *pEnd;
+    struct stat st;
+    int fd, Width, Height, Stride;
+    void *pMap;
+    bool bOk = false;
+
+    memset(pCanvas, 0, sizeof(*pCanvas));
+    fd = open(pPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("IMAGE: cannot open image");
+        return false;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < 8) {
+        LOG_Error("IMAGE: %s is too short", pPath);
+        close(fd);
+        return false;
+    }
+    pMap = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMap == MAP_FAILED) {
+        perror("IMAGE: mmap failed");
+        return false;
+    }
+
+    p = pMap;
+    pEnd = p + st.st_size;
+    if (memcmp(p, "P4", 2) != 0) {
+        LOG_Error("IMAGE: %s is not a binary PBM", pPath);
+    } else if (p += 2, !PbmNumber(&p, pEnd, &Width) || !PbmNumber(&p, pEnd, &Height) || p == pEnd ||
+               !isspace((unsigned char)*p)) {
+        LOG_Error("IMAGE: %s has a bad PBM header", pPath);
+    } else if ((Stride = (Width + 7) / 8, (size_t)(pEnd - ++p) < (size_t)Stride * Height)) {
+        LOG_Error("IMAGE: %s is truncated", pPath);
+    } else {
+        pCanvas->Width = Width;
+        pCanvas->Height = Height;
+        pCanvas->FrameSize = Width * ((Height + 7) / 8);
+        pCanvas->pFrame = malloc(pCanvas->FrameSize);
+        if (pCanvas->pFrame) {
+            IMAGE_RowsToPages(pCanvas, (const uint8_t *)p, Stride);
+            bOk = true;
+        }
+    }
+    munmap(pMap, st.st_size);
+    return bOk;
+}
+
+void IMAGE_Free(LCD_CANVAS *pCanvas) {
+    free(pCanvas->pFrame);
+    pCanvas->pFrame = NULL;
+}
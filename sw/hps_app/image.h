@@ -0,0 +1,40 @@
+#ifndef _IMAGE_H_
+#define _IMAGE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lcd_graphic.h"
+
+// 1 bpp image import. Image formats store pixels row-major, eight
+// horizontal pixels per byte with the leftmost in bit 7 (PBM, BMP,
+// decoded PNG); the panel and LCD_CANVAS are page-major, eight vertical
+// pixels per byte with the top one in bit 0. IMAGE_RowsToPages converts
+// by transposing 8x8 bit blocks. Set bits are ink.
+//
+// Kernels: a per-pixel reference, a portable one (each 8x8 block in a
+// 64-bit word), SSE2 and AVX2 on x86 (byte transpose of 16x16 blocks,
+// then the 64-bit word transpose on two or four blocks per register) and
+// NEON on the HPS (vtrn byte transpose, then the same word transpose). The fastest one the build
+// and CPU support is used unless IMAGE_SetKernel picks another.
+
+#define IMAGE_KERNEL_REF    0
+#define IMAGE_KERNEL_SWAR   1
+#define IMAGE_KERNEL_SSE2   2
+#define IMAGE_KERNEL_AVX2   3
+#define IMAGE_KERNEL_NEON   4
+#define IMAGE_KERNELS       5
+
+bool IMAGE_SetKernel(int Kernel);       // false: not built in or not supported by the CPU
+int  IMAGE_GetKernel(void);
+const char *IMAGE_KernelName(int Kernel);
+
+// pDst gives the size; Stride is the byte distance between source rows
+// (at least (Width + 7) / 8)
+void IMAGE_RowsToPages(LCD_CANVAS *pDst, const uint8_t *pRows, int Stride);
+
+// Binary PBM (P4). The file is mapped and converted straight from the
+// mapping into a new canvas; IMAGE_Free releases it.
+bool IMAGE_LoadPbm(const char *pPath, LCD_CANVAS *pCanvas);
+void IMAGE_Free(LCD_CANVAS *pCanvas);
+
+#endif // _IMAGE_H_
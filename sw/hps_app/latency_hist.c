@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "latency_hist.h"
+
+// Bucket e * 32 + m holds [m << e, (m + 1) << e) with m in 32..63: the
+// top six bits of the value. Below 64 the value is its own bucket.
+static int BucketOf(uint64_t Ns) {
+    int e;
+
+    if (Ns < 2 * LATHIST_SUB) return (int)Ns;
+    if (Ns >> LATHIST_MAX_BITS) return LATHIST_BUCKETS - 1;
+    e = 63 - __builtin_clzll(Ns) - LATHIST_SUB_BITS;
+    return e * LATHIST_SUB + (int)(Ns >> e);
+}
+
+static uint64_t BucketTop(int Bucket) {
+    int e;
+
+    if (Bucket < 2 * LATHIST_SUB) return (uint64_t)Bucket;
+    e = Bucket / LATHIST_SUB - 1;
+    return ((uint64_t)(Bucket - e * LATHIST_SUB + 1) << e) - 1;
+}
+
+void LATHIST_Init(LATHIST *pHist, const char *pName) {
+    memset(pHist, 0, sizeof(*pHist));
+    pHist->pName = pName;
+}
+
+void LATHIST_Record(LATHIST *pHist, uint64_t Ns) {
+    uint32_t seq = atomic_load_explicit(&pHist->Seq, memory_order_relaxed);
+
+    atomic_store_explicit(&pHist->Seq, seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    pHist->Buckets[BucketOf(Ns)]++;
+    pHist->Count++;
+    pHist->SumNs += Ns;
+    if (Ns > pHist->MaxNs) pHist->MaxNs = Ns;
+    atomic_store_explicit(&pHist->Seq, seq + 2, memory_order_release);
+}
+
+void LATHIST_Snapshot(const LATHIST *pHist, LATHIST *pCopy) {
+    uint32_t before, after;
+
+    do {
+        before = atomic_load_explicit(&pHist->Seq, memory_order_acquire);
+        memcpy(pCopy, pHist, sizeof(*pCopy));
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&pHist->Seq, memory_order_relaxed);
+    } while ((before & 1) || before != after);
+}
+
+uint64_t LATHIST_Percentile(const LATHIST *pHist, double Percent) {
+    uint64_t rank, seen = 0;
+
+    if (!pHist->Count) return 0;
+    rank = (uint64_t)(Percent / 100.0 * pHist->Count + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > pHist->Count) rank = pHist->Count;
+    for (int b = 0; b < LATHIST_BUCKETS; b++) {
+        seen += pHist->Buckets[b];
+        if (seen >= rank) {
+            uint64_t top = BucketTop(b);
+            return top < pHist->MaxNs && b < LATHIST_BUCKETS - 1 ? top : pHist->MaxNs;
+        }
+    }
+    return pHist->MaxNs;
+}
+
+bool LATHIST_Format(const LATHIST *pHist, char *pText, size_t Size) {
+    if (!pHist->Count) return false;
+    snprintf(pText, Size, "  %-14s %6llu  mean %7.2f  p50 %7.2f  p99 %7.2f  p99.9 %7.2f  max %7.2f ms", pHist->pName,
+             (unsigned long long)pHist->Count, pHist->SumNs / 1e6 / pHist->Count,
+             LATHIST_Percentile(pHist, 50) / 1e6, LATHIST_Percentile(pHist, 99) / 1e6,
+             LATHIST_Percentile(pHist, 99.9) / 1e6, pHist->MaxNs / 1e6);
+    return true;
+}
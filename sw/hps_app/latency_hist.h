@@ -0,0 +1,43 @@
+#ifndef _LATENCY_HIST_H_
+#define _LATENCY_HIST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+// Log-linear latency histogram (HDR style): values below 64 ns get a
+// bucket each, above that every power of two is split into 32 linear
+// buckets, so any recorded value is known to within 1/32 (~3%). Values
+// up to 2^36 ns (68 s) fit; longer ones count in the last bucket. A
+// histogram is a fixed 4 KB with no allocation, cheap enough to record
+// from the render thread on every frame.
+//
+// One thread records; others read through LATHIST_Snapshot. Seq is a
+// seqlock: odd while a sample is being added, so a copy that saw it odd
+// or changed is taken again and never mixes two states.
+
+#define LATHIST_SUB_BITS     5
+#define LATHIST_SUB          (1 << LATHIST_SUB_BITS)
+#define LATHIST_MAX_BITS     36
+#define LATHIST_BUCKETS      ((LATHIST_MAX_BITS - LATHIST_SUB_BITS) * LATHIST_SUB + LATHIST_SUB)
+
+typedef struct {
+    const char *pName;
+    _Atomic uint32_t Seq;
+    uint64_t Count;
+    uint64_t SumNs;
+    uint64_t MaxNs;
+    uint32_t Buckets[LATHIST_BUCKETS];
+} LATHIST;
+
+void     LATHIST_Init(LATHIST *pHist, const char *pName);
+void     LATHIST_Record(LATHIST *pHist, uint64_t Ns);
+void     LATHIST_Snapshot(const LATHIST *pHist, LATHIST *pCopy);
+// The value below which Percent of the samples fall (upper bucket edge,
+// so never under the true value); 0 with no samples
+uint64_t LATHIST_Percentile(const LATHIST *pHist, double Percent);
+// "name  count  mean  p50  p99  p99.9  max" in ms; false if empty
+bool     LATHIST_Format(const LATHIST *pHist, char *pText, size_t Size);
+
+#endif // _LATENCY_HIST_H_
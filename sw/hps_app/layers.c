@@ -0,0 +1,179 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "layers.h"
+#include "LCD_Lib.h"
+#include "log.h"
+
+#define PANEL_WIDTH     128
+#define PANEL_HEIGHT    64
+#define FRAME_BYTES     (PANEL_WIDTH * PANEL_HEIGHT / 8)
+
+typedef struct {
+    int X1, Y1, X2, Y2;     // inclusive; empty when X1 > X2
+} RECT;
+
+typedef struct {
+    LCD_CANVAS Canvas;
+    int        X, Y;
+    int        Rop;
+    bool       bVisible;
+    RECT       Dirty;       // screen coordinates, what this layer changed
+} LAYER;
+
+static LAYER gLayers[LAYER_MAX];
+static int gCount;
+static uint8_t gFrame[FRAME_BYTES];
+static LAYER_STATS gStats;
+
+static bool RectEmpty(const RECT *pRect) {
+    return pRect->X1 > pRect->X2;
+}
+
+static void RectUnion(RECT *pRect, const RECT *pAdd) {
+    if (RectEmpty(pRect)) {
+        *pRect = *pAdd;
+        return;
+    }
+    if (pAdd->X1 < pRect->X1) pRect->X1 = pAdd->X1;
+    if (pAdd->Y1 < pRect->Y1) pRect->Y1 = pAdd->Y1;
+    if (pAdd->X2 > pRect->X2) pRect->X2 = pAdd->X2;
+    if (pAdd->Y2 > pRect->Y2) pRect->Y2 = pAdd->Y2;
+}
+
+static bool RectOverlap(const RECT *pA, const RECT *pB) {
+    return pA->X1 <= pB->X2 && pB->X1 <= pA->X2 && pA->Y1 <= pB->Y2 && pB->Y1 <= pA->Y2;
+}
+
+static void DirtyScreen(LAYER *pLayer, int X1, int Y1, int X2, int Y2) {
+    if (X1 < 0) X1 = 0;
+    if (Y1 < 0) Y1 = 0;
+    if (X2 >= PANEL_WIDTH) X2 = PANEL_WIDTH - 1;
+    if (Y2 >= PANEL_HEIGHT) Y2 = PANEL_HEIGHT - 1;
+    if (X1 > X2 || Y1 > Y2) return;
+    RectUnion(&pLayer->Dirty, &(RECT){ X1, Y1, X2, Y2 });
+}
+
+int LAYER_Add(int X, int Y, int Width, int Height, int Rop) {
+    LAYER *pLayer;
+
+    if (gCount == LAYER_MAX) return -1;
+    pLayer = &gLayers[gCount];
+    pLayer->Canvas.Width = Width;
+    pLayer->Canvas.Height = Height;
+    pLayer->Canvas.FrameSize = Width * ((Height + 7) / 8);
+    pLayer->Canvas.pFrame = calloc(1, pLayer->Canvas.FrameSize);
+    if (!pLayer->Canvas.pFrame) {
+        LOG_Error("LAYER: no memory for a %dx%d layer", Width, Height);
+        return -1;
+    }
+    pLayer->X = X;
+    pLayer->Y = Y;
+    pLayer->Rop = Rop;
+    pLayer->bVisible = true;
+    pLayer->Dirty = (RECT){ 0, 0, -1, -1 };
+    DirtyScreen(pLayer, X, Y, X + Width - 1, Y + Height - 1);
+    return gCount++;
+}
+
+LCD_CANVAS *LAYER_Canvas(int Id) {
+    return &gLayers[Id].Canvas;
+}
+
+void LAYER_Dirty(int Id, int X1, int Y1, int X2, int Y2) {
+    LAYER *pLayer = &gLayers[Id];
+
+    if (pLayer->bVisible)
+        DirtyScreen(pLayer, pLayer->X + X1, pLayer->Y + Y1, pLayer->X + X2, pLayer->Y + Y2);
+}
+
+void LAYER_DirtyAll(int Id) {
+    LAYER_Dirty(Id, 0, 0, gLayers[Id].Canvas.Width - 1, gLayers[Id].Canvas.Height - 1);
+}
+
+void LAYER_Move(int Id, int X, int Y) {
+    LAYER *pLayer = &gLayers[Id];
+
+    if (pLayer->X == X && pLayer->Y == Y) return;
+    LAYER_DirtyAll(Id);
+    pLayer->X = X;
+    pLayer->Y = Y;
+    LAYER_DirtyAll(Id);
+}
+
+void LAYER_Show(int Id, bool bVisible) {
+    LAYER *pLayer = &gLayers[Id];
+
+    if (pLayer->bVisible == bVisible) return;
+    pLayer->bVisible = true;
+    LAYER_DirtyAll(Id);         // the area it covered, or will cover
+    pLayer->bVisible = bVisible;
+}
+
+// Clears one dirty area and stacks every visible layer over it, bottom up
+static void ComposeRect(LCD_CANVAS *pOut, const RECT *pRect) {
+    RECT r = *pRect;
+
+    DRAW_FillRect(pOut, r.X1, r.Y1, r.X2, r.Y2, 0);
+    for (int i = 0; i < gCount; i++) {
+        const LAYER *pLayer = &gLayers[i];
+        int X1 = r.X1 > pLayer->X ? r.X1 : pLayer->X;
+        int Y1 = r.Y1 > pLayer->Y ? r.Y1 : pLayer->Y;
+        int X2 = r.X2 < pLayer->X + pLayer->Canvas.Width - 1 ? r.X2 : pLayer->X + pLayer->Canvas.Width - 1;
+        int Y2 = r.Y2 < pLayer->Y + pLayer->Canvas.Height - 1 ? r.Y2 : pLayer->Y + pLayer->Canvas.Height - 1;
+
+        if (!pLayer->bVisible || X1 > X2 || Y1 > Y2) continue;
+        DRAW_BitBlt(pOut, X1, Y1, &pLayer->Canvas, X1 - pLayer->X, Y1 - pLayer->Y,
+                    X2 - X1 + 1, Y2 - Y1 + 1, pLayer->Rop);
+    }
+    gStats.Pixels += (uint64_t)(r.X2 - r.X1 + 1) * (r.Y2 - r.Y1 + 1);
+}
+
+// Each layer's dirty area is recomposed on its own, so a strip ticking
+// at the top and a marquee row at the bottom cost their two rows rather
+// than everything between them. Areas that overlap are merged first so
+// no pixel is composed twice.
+void LAYER_Compose(void) {
+    LCD_CANVAS Out = { PANEL_WIDTH, PANEL_HEIGHT, FRAME_BYTES, gFrame };
+    RECT rects[LAYER_MAX];
+    int n = 0;
+
+    for (int i = 0; i < gCount; i++) {
+        if (RectEmpty(&gLayers[i].Dirty)) continue;
+        rects[n++] = gLayers[i].Dirty;
+        gLayers[i].Dirty = (RECT){ 0, 0, -1, -1 };
+    }
+    if (n == 0) return;
+    for (int i = 0; i < n; i++) {
+        for (int j = i + 1; j < n; j++) {
+            if (!RectOverlap(&rects[i], &rects[j])) continue;
+            RectUnion(&rects[i], &rects[j]);
+            rects[j] = rects[--n];
+            j = i;      // start over: the grown area may reach one already passed
+        }
+    }
+    for (int i = 0; i < n; i++)
+        ComposeRect(&Out, &rects[i]);
+    gStats.Composes++;
+    LCD_FrameCopy(gFrame);
+}
+
+const uint8_t *LAYER_Frame(void) {
+    return gFrame;
+}
+
+void LAYER_GetStats(LAYER_STATS *pStats) {
+    *pStats = gStats;
+}
+
+void LAYER_Free(void) {
+    for (int i = 0; i < gCount; i++) {
+        free(gLayers[i].Canvas.pFrame);
+        gLayers[i].Canvas.pFrame = NULL;
+    }
+    gCount = 0;
+    memset(&gStats, 0, sizeof(gStats));
+}
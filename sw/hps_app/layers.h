@@ -0,0 +1,36 @@
+#ifndef _LAYERS_H_
+#define _LAYERS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lcd_graphic.h"
+
+// Layered composition of the panel picture. Layers are canvases placed
+// on the screen and stacked in the order they were added; an opaque
+// layer (DRAW_ROP_COPY) replaces what is below it, a transparent one
+// (DRAW_ROP_OR) only adds its ink. Drawing into a layer is followed by
+// LAYER_Dirty for the area that changed. Each layer keeps the bounding
+// box of its own changes; LAYER_Compose rebuilds those boxes separately
+// (merging the ones that overlap) with word-wide blits and sends the
+// result through the frame diff, so a small overlay change costs only
+// the columns it touched, wherever the other layers changed.
+
+#define LAYER_MAX   4
+
+typedef struct {
+    uint64_t Composes;
+    uint64_t Pixels;          // dirty area recomposed, summed
+} LAYER_STATS;
+
+int  LAYER_Add(int X, int Y, int Width, int Height, int Rop);
+LCD_CANVAS *LAYER_Canvas(int Id);
+void LAYER_Dirty(int Id, int X1, int Y1, int X2, int Y2);   // layer coordinates, inclusive
+void LAYER_DirtyAll(int Id);
+void LAYER_Move(int Id, int X, int Y);
+void LAYER_Show(int Id, bool bVisible);
+void LAYER_Compose(void);
+const uint8_t *LAYER_Frame(void);
+void LAYER_GetStats(LAYER_STATS *pStats);
+void LAYER_Free(void);
+
+#endif // _LAYERS_H_
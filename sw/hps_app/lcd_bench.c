@@ -0,0 +1,187 @@
+// Host benchmark for the LCD transmit path.
+// Build: make lcd_bench   (LCD_Hw.c on the hps_emu.c register backend)
+//
+// Pushes full frames through the legacy byte-at-a-time path and the FIFO
+// burst path and reports SPI throughput on the emulator's virtual clock,
+// which charges every register access and shifts bytes at the real SCLK.
+// Then walks the app's screens (IDLE, HOME, every message, SLEEP) with
+// differential frame copies at several gap-merge thresholds and reports
+// bytes and time per transition.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Driver.h"
+#include "LCD_Lib.h"
+#include "lcd_graphic.h"
+#include "hps_emu.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define BENCH_FRAMES    200
+#define FRAME_BYTES     (128 * 8)
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+#define SCREEN_COUNT    (MSG_COUNT + 3)
+
+#define SPIM0_BASE_OFFSET      0x03F00000
+#define SPIM_SSIENR            0x08
+#define SPIM_BAUDR             0x14
+
+typedef void (*FRAME_FN)(uint8_t *Data);
+
+// LCD_FrameCopy as it was before the burst path: every byte is a full
+// write / wait-empty / wait-not-busy round trip.
+static void FrameCopyLegacy(uint8_t *Data) {
+    for (int Page = 0; Page < 8; Page++) {
+        LCD_SetStartAddr(0, Page * 8);
+        for (int i = 0; i < 128; i++)
+            LCDDrv_WriteData(Data[Page * 128 + i]);
+    }
+}
+
+static double RunCase(const char *pName, FRAME_FN pfnFrame, uint8_t *pFrame) {
+    EMU_STATS stats;
+    uint64_t t0, host0, host1;
+
+    EMU_ClearStats();
+    t0 = EMU_NowNs();
+    host0 = NowNs();
+    for (int i = 0; i < BENCH_FRAMES; i++)
+        pfnFrame(pFrame);
+    host1 = NowNs();
+    EMU_GetStats(&stats);
+
+    double frame_us = (double)(EMU_NowNs() - t0) / BENCH_FRAMES / 1000.0;
+    double bytes_per_s = (double)stats.TxBytes / BENCH_FRAMES / (frame_us / 1e6);
+
+    printf("%-8s frame %8.1f us  %9.0f bytes/s  %6.0f reg reads/frame  "
+           "%6.1f host us/frame\n",
+           pName, frame_us, bytes_per_s,
+           (double)stats.RegReads / BENCH_FRAMES,
+           (double)(host1 - host0) / BENCH_FRAMES / 1000.0);
+
+    if (stats.DataBytes != (uint64_t)BENCH_FRAMES * FRAME_BYTES || stats.DcRaces || stats.FifoOverflows) {
+        printf("  ERROR: data=%llu cmd=%llu dc_races=%llu overflows=%llu\n",
+               (unsigned long long)stats.DataBytes, (unsigned long long)stats.CmdBytes,
+               (unsigned long long)stats.DcRaces, (unsigned long long)stats.FifoOverflows);
+        exit(1);
+    }
+    return frame_us;
+}
+
+// Drawn as LCD_TextScreen would, without sending anything
+static void RenderScreen(uint8_t *pFrame, const char *const lines[4]) {
+    LCD_CANVAS Canvas = { 128, 64, FRAME_BYTES, pFrame };
+
+    memset(pFrame, 0x00, FRAME_BYTES);
+    for (int i = 0; i < 4; i++)
+        if (lines[i])
+            DRAW_PrintString(&Canvas, 0, i * 16, (char *)lines[i], 1, LCD_GetFont());
+}
+
+// Walks the screens in order, each sent with LCD_FrameCopy at diff gap
+// Gap, and reports bytes and time per transition
+static void WalkScreens(const char *pName, int Gap, uint8_t (*pScreens)[FRAME_BYTES],
+                        const int *pOrder, int n) {
+    static uint8_t panel[FRAME_BYTES];
+    EMU_STATS stats;
+    uint64_t t0, host0, host1;
+    int mismatches = 0;
+
+    LCD_SetDiffGap(Gap);
+    LCD_InvalidateShadow();
+    LCD_FrameCopy(pScreens[0]);
+    EMU_ClearStats();
+    t0 = EMU_NowNs();
+    host0 = NowNs();
+    for (int i = 0; i < n; i++) {
+        LCD_FrameCopy(pScreens[pOrder[i]]);
+        EMU_GetPanel(panel);            // no register traffic, off the clock
+        if (memcmp(panel, pScreens[pOrder[i]], FRAME_BYTES) != 0) mismatches++;
+    }
+    host1 = NowNs();
+    EMU_GetStats(&stats);
+
+    printf("%-8s  %6.0f bytes/transition (%4.0f cmd)  %7.1f us/transition  %5.1f host us\n", pName,
+           (double)stats.TxBytes / n, (double)stats.CmdBytes / n, (double)(EMU_NowNs() - t0) / n / 1000.0,
+           (double)(host1 - host0) / n / 1000.0);
+    if (mismatches) {
+        printf("  ERROR: panel differs from the frame after %d transitions\n", mismatches);
+        exit(1);
+    }
+}
+
+// IDLE -> HOME -> MSG 0..17 -> HOME -> SLEEP -> IDLE, as KEY presses and
+// the idle timeout would drive main.c
+static void RunTransitions(void) {
+    static const char *const idle[4] = {
+        "==================", "  DE10-Standard   ", "   LCD Message    ", "  Press Any Key   " };
+    static const char *const home[4] = {
+        "==================", "  Welcome User!   ", " KEY1/KEY2: Msgs  ", " KEY0: Back       " };
+    static const char *const blank[4] = { NULL, NULL, NULL, NULL };
+    static const int gap_list[] = { LCD_DIFF_OFF, 0, 1, 2, 4, 8, 16 };
+    static uint8_t screens[SCREEN_COUNT][FRAME_BYTES];
+    int order[SCREEN_COUNT + 2], n = 0;
+    char name[16];
+
+    RenderScreen(screens[0], idle);
+    RenderScreen(screens[1], home);
+    RenderScreen(screens[2], blank);
+    for (int i = 0; i < MSG_COUNT; i++)
+        RenderScreen(screens[3 + i], MSG_LIST[i]);
+    order[n++] = 1;
+    for (int i = 0; i < MSG_COUNT; i++)
+        order[n++] = 3 + i;
+    order[n++] = 1;
+    order[n++] = 2;
+    order[n++] = 0;
+
+    printf("\nScreen transitions (%d), SPIM0 BAUDR=64\n", n);
+    for (unsigned g = 0; g < sizeof(gap_list) / sizeof(gap_list[0]); g++) {
+        if (gap_list[g] < 0)
+            snprintf(name, sizeof(name), "full");
+        else
+            snprintf(name, sizeof(name), "gap %d", gap_list[g]);
+        WalkScreens(name, gap_list[g], screens, order, n);
+    }
+    LCD_SetDiffGap(LCD_DIFF_GAP_DEFAULT);
+}
+
+int main(void) {
+    static uint8_t frame[FRAME_BYTES];
+
+    for (int i = 0; i < FRAME_BYTES; i++)
+        frame[i] = (uint8_t)(rand() & 0xFF);
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+    LCD_SetDiffGap(LCD_DIFF_OFF);       // the same frame every time: send it all
+
+    // 64 is what LCDHW_Init programs; 16 (12.5 MHz SCLK) shows where the
+    // per-byte register round trips start to dominate.
+    static const uint32_t baud_list[] = { 64, 16 };
+    for (unsigned b = 0; b < sizeof(baud_list) / sizeof(baud_list[0]); b++) {
+        EMU_Write32(SPIM0_BASE_OFFSET + SPIM_SSIENR, 0);
+        EMU_Write32(SPIM0_BASE_OFFSET + SPIM_BAUDR, baud_list[b]);
+        EMU_Write32(SPIM0_BASE_OFFSET + SPIM_SSIENR, 1);
+
+        printf("\nLCD_FrameCopy, %d frames, SPIM0 BAUDR=%u @ 200 MHz spi_m_clk\n",
+               BENCH_FRAMES, baud_list[b]);
+        double legacy_us = RunCase("legacy", FrameCopyLegacy, frame);
+        double burst_us  = RunCase("burst", LCD_FrameCopy, frame);
+        printf("speedup  %.2fx\n", legacy_us / burst_us);
+    }
+
+    EMU_Write32(SPIM0_BASE_OFFSET + SPIM_SSIENR, 0);
+    EMU_Write32(SPIM0_BASE_OFFSET + SPIM_BAUDR, 64);
+    EMU_Write32(SPIM0_BASE_OFFSET + SPIM_SSIENR, 1);
+    RunTransitions();
+    return 0;
+}
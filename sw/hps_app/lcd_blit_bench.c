@@ -0,0 +1,143 @@
+// Host check and benchmark for DRAW_BitBlt.
+// Build: make lcd_blit_bench
+//
+// Blits random regions between canvases of assorted sizes (including
+// heights that are not whole pages), partly off either canvas, with every
+// raster op, and within one canvas with overlapping regions, and
+// requires the same result as a per-pixel reference. Then times the UI
+// cases the blitter is for against the per-pixel reference and against
+// re-rasterizing the text.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "lcd_graphic.h"
+#include "font.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define MAX_FRAME       (160 * 10)
+#define CHECK_CASES     200000
+#define BENCH_LOOPS     100000
+
+typedef void (*BLIT_FN)(LCD_CANVAS *pDst, int DstX, int DstY, const LCD_CANVAS *pSrc, int SrcX, int SrcY,
+                        int Width, int Height, int Rop);
+
+static uint8_t gFrameA[MAX_FRAME], gFrameB[MAX_FRAME], gFrameSrc[MAX_FRAME];
+
+static void RefBitBlt(LCD_CANVAS *pDst, int DstX, int DstY, const LCD_CANVAS *pSrc, int SrcX, int SrcY,
+                      int Width, int Height, int Rop) {
+    static uint8_t Snapshot[MAX_FRAME];
+    LCD_CANVAS Src = *pDst;
+
+    if (pSrc) {
+        Src = *pSrc;
+        memcpy(Snapshot, pSrc->pFrame, pSrc->FrameSize);
+        Src.pFrame = Snapshot;
+    }
+    for (int y = 0; y < Height; y++) {
+        for (int x = 0; x < Width; x++) {
+            int dx = DstX + x, dy = DstY + y, sx = SrcX + x, sy = SrcY + y, s = 0, d;
+
+            if (dx < 0 || dx >= pDst->Width || dy < 0 || dy >= pDst->Height) continue;
+            if (Rop != DRAW_ROP_INVERT) {
+                if (sx < 0 || sx >= Src.Width || sy < 0 || sy >= Src.Height) continue;
+                s = GetPixel(&Src, sx, sy);
+            }
+            d = GetPixel(pDst, dx, dy);
+            switch (Rop) {
+            case DRAW_ROP_COPY: d = s; break;
+            case DRAW_ROP_OR:   d |= s; break;
+            case DRAW_ROP_AND:  d &= s; break;
+            case DRAW_ROP_XOR:  d ^= s; break;
+            default:            d ^= 1; break;
+            }
+            DRAW_Pixel(pDst, dx, dy, d);
+        }
+    }
+}
+
+static int Check(void) {
+    static const int Sizes[][2] = { { 128, 64 }, { 40, 21 }, { 160, 80 }, { 9, 5 }, { 127, 63 } };
+    int nSizes = sizeof(Sizes) / sizeof(Sizes[0]);
+    int errors = 0;
+
+    for (int i = 0; i < CHECK_CASES; i++) {
+        LCD_CANVAS a, b, src;
+        int d = rand() % nSizes, s = rand() % nSizes;
+        int rop = rand() % 5, self = (i % 4) == 0;
+
+        InitCanvas(&a, gFrameA, Sizes[d][0], Sizes[d][1]);
+        InitCanvas(&b, gFrameB, Sizes[d][0], Sizes[d][1]);
+        InitCanvas(&src, gFrameSrc, Sizes[s][0], Sizes[s][1]);
+        for (int k = 0; k < MAX_FRAME; k++) {
+            gFrameA[k] = gFrameB[k] = (uint8_t)rand();
+            gFrameSrc[k] = (uint8_t)rand();
+        }
+
+        int w = rand() % (a.Width + 10), h = rand() % (a.Height + 10);
+        int dx = rand() % (a.Width + 20) - 10, dy = rand() % (a.Height + 20) - 10;
+        int sx = rand() % (a.Width + 20) - 10, sy = rand() % (a.Height + 20) - 10;
+
+        // Within one canvas: a and b each blit onto themselves
+        DRAW_BitBlt(&a, dx, dy, self ? &a : &src, sx, sy, w, h, rop);
+        RefBitBlt(&b, dx, dy, self ? &b : &src, sx, sy, w, h, rop);
+        if (memcmp(gFrameA, gFrameB, a.FrameSize) != 0 && errors++ < 5)
+            printf("  mismatch: %dx%d <- %dx%d%s, (%d,%d) <- (%d,%d) %dx%d rop %d\n", a.Width, a.Height,
+                   src.Width, src.Height, self ? " (self)" : "", dx, dy, sx, sy, w, h, rop);
+    }
+    printf("blits: %d cases, %d mismatches\n", CHECK_CASES, errors);
+    return errors;
+}
+
+// Microseconds per call
+static double BenchBlit(BLIT_FN pfnBlit, int DstY, int SrcY, int Width, int Height, int Rop) {
+    LCD_CANVAS dst, src;
+    uint64_t t0;
+
+    InitCanvas(&dst, gFrameA, 128, 64);
+    InitCanvas(&src, gFrameSrc, 128, 64);
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_LOOPS; i++)
+        pfnBlit(&dst, 0, DstY, &src, 0, SrcY, Width, Height, Rop);
+    return (NowNs() - t0) / 1e3 / BENCH_LOOPS;
+}
+
+// What highlighting a line costs without the blitter: draw it again
+static double BenchRedrawLine(void) {
+    LCD_CANVAS c;
+    uint64_t t0;
+
+    InitCanvas(&c, gFrameA, 128, 64);
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_LOOPS; i++) {
+        DRAW_FillRect(&c, 0, 16, 127, 31, 1);
+        DRAW_PrintString(&c, 0, 16, (char *)MSG_LIST[i % 18][1], 0, &font_16x16);
+    }
+    return (NowNs() - t0) / 1e3 / BENCH_LOOPS;
+}
+
+static void Row(const char *pName, double Ref, double Blit) {
+    printf("%-28s %10.3fus %10.3fus %7.1fx\n", pName, Ref, Blit, Ref / Blit);
+}
+
+int main(void) {
+    int errors = Check();
+
+    printf("\n%-28s %12s %12s %8s\n", "", "per-pixel", "BitBlt", "speedup");
+    Row("highlight line (invert)", BenchBlit(RefBitBlt, 16, 16, 128, 16, DRAW_ROP_INVERT),
+        BenchBlit(DRAW_BitBlt, 16, 16, 128, 16, DRAW_ROP_INVERT));
+    Row("cursor blink (8x16 invert)", BenchBlit(RefBitBlt, 16, 16, 8, 16, DRAW_ROP_INVERT),
+        BenchBlit(DRAW_BitBlt, 16, 16, 8, 16, DRAW_ROP_INVERT));
+    Row("full frame copy", BenchBlit(RefBitBlt, 0, 0, 128, 64, DRAW_ROP_COPY),
+        BenchBlit(DRAW_BitBlt, 0, 0, 128, 64, DRAW_ROP_COPY));
+    Row("full frame xor, 3-row shift", BenchBlit(RefBitBlt, 3, 0, 128, 61, DRAW_ROP_XOR),
+        BenchBlit(DRAW_BitBlt, 3, 0, 128, 61, DRAW_ROP_XOR));
+    printf("%-28s %10.3fus\n", "inverse line, re-rasterized", BenchRedrawLine());
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
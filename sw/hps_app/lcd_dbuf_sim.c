@@ -0,0 +1,135 @@
+// Host check for drawing over a frame that is still being sent.
+// Build: make lcd_dbuf_sim
+//
+// Against the emulator, first in the default PIO mode (frames go out on
+// the LCD_Hw transmit thread, which reads the canvas front buffer in
+// place) and then in DMA mode: commits screen A and draws screen B into
+// the back buffer while A is still on the wire, then checks that the
+// front buffer never changed and that the panel ends up showing exactly
+// A (no part of B torn into it). B's commit must then show B.
+// LCD_BeginEdit must start from what was committed, and the
+// immediate-mode calls (LCD_TextOut, LCD_GraphicClear) must keep
+// accumulating on what is shown.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Lib.h"
+#include "hps_emu.h"
+#include "lcd_graphic.h"
+#include "messages.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define ROUNDS          20
+
+static uint8_t gPanel[FRAME_BYTES];
+static uint8_t gWantA[FRAME_BYTES], gWantB[FRAME_BYTES], gWantEdit[FRAME_BYTES];
+static const char *const gEditLines[4] = { " Eytan Mann     ", "                ", " Project 3420   ",
+                                           " edited line    " };
+
+// A screen drawn straight onto a canvas, for comparison
+static void Reference(uint8_t *pFrame, const char *const *pLines) {
+    LCD_CANVAS c = { 128, 64, FRAME_BYTES, pFrame };
+
+    memset(pFrame, 0, FRAME_BYTES);
+    for (int l = 0; l < 4; l++)
+        if (pLines[l])
+            DRAW_PrintString(&c, 0, l * 16, (char *)pLines[l], 1, &font_16x16);
+}
+
+static bool PanelIs(const char *pWhat, const uint8_t *pFrame) {
+    LCD_FrameSync();
+    EMU_GetPanel(gPanel);
+    if (memcmp(gPanel, pFrame, FRAME_BYTES) == 0) return true;
+    printf("  panel does not show %s\n", pWhat);
+    return false;
+}
+
+static bool InFlight(void) {
+    return LCDHW_DmaBusy() || LCDHW_TxBusy();
+}
+
+static int RunMode(const char *pMode) {
+    static uint8_t front[FRAME_BYTES], blank[FRAME_BYTES];
+    int errors = 0, overlapped = 0;
+    uint64_t in_flight_ns = 0;
+
+    for (int round = 0; round < ROUNDS; round++) {
+        uint64_t t0;
+
+        LCD_TextScreen(MSG_LIST[0]);
+        t0 = EMU_NowNs();
+        memcpy(front, LCD_FrontFrame(), FRAME_BYTES);
+
+        // Frame B is drawn while A is still being sent
+        LCD_BeginFrame();
+        for (int l = 0; l < 4; l++)
+            LCD_TextOutNoFlush(0, l * 16, MSG_LIST[1][l]);
+        if (InFlight()) overlapped++;
+        if (memcmp(front, LCD_FrontFrame(), FRAME_BYTES) != 0 || memcmp(front, gWantA, FRAME_BYTES) != 0) {
+            printf("  front buffer changed while the back one was drawn\n");
+            errors++;
+        }
+        if (!PanelIs("frame A after drawing B", gWantA)) errors++;
+        in_flight_ns = EMU_NowNs() - t0;
+
+        LCD_CommitFrame();
+        if (!PanelIs("frame B", gWantB)) errors++;
+    }
+    printf("%s: A still on the wire after B was drawn in %d/%d rounds (A took %.1f us on the bus)\n",
+           pMode, overlapped, ROUNDS, in_flight_ns / 1e3);
+    if (overlapped == 0) errors++;
+
+    // Clear inside a frame touches only the back buffer
+    LCD_BeginEdit();
+    LCD_GraphicClear();
+    if (!PanelIs("frame B before the clear is committed", gWantB)) errors++;
+    LCD_CommitFrame();
+    if (!PanelIs("a cleared screen", blank)) errors++;
+
+    // An edit starts from the front frame: replace B's last line only
+    LCD_TextScreen(MSG_LIST[1]);
+    LCD_BeginEdit();
+    LCD_TextOutNoFlush(0, 48, gEditLines[3]);
+    LCD_CommitFrame();
+    if (!PanelIs("the edited screen", gWantEdit)) errors++;
+
+    // Immediate mode accumulates on what is shown
+    LCD_GraphicClear();
+    LCD_TextOut(0, 0, (char *)MSG_LIST[1][0]);
+    LCD_TextOut(0, 32, (char *)MSG_LIST[1][2]);
+    LCD_TextOut(0, 48, (char *)MSG_LIST[1][3]);
+    if (!PanelIs("the immediate-mode screen", gWantB)) errors++;
+    return errors;
+}
+
+int main(void) {
+    int errors = 0;
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+    LCD_SetDiffGap(LCD_DIFF_OFF);       // every commit is a whole frame on the wire
+    Reference(gWantA, MSG_LIST[0]);
+    Reference(gWantB, MSG_LIST[1]);
+    Reference(gWantEdit, gEditLines);
+
+    errors += RunMode("PIO");
+    if (!LCD_SetDmaMode(true)) {
+        printf("DMA mode unavailable\n");
+        errors++;
+    } else {
+        errors += RunMode("DMA");
+        LCD_SetDmaMode(false);
+    }
+
+    LCDHW_Close();
+    HPSREG_Close();
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
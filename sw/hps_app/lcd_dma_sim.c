@@ -0,0 +1,165 @@
+// Host check for the DMA frame path.
+// Build: make lcd_dma_sim
+//
+// Queues frames with LCD_FrameCopyAsync against the emulator's SPIM0 and
+// DMA-330 models while a stand-in main loop keeps polling the FSM status
+// PIO, then checks what the panel received: every page as B0|page, 00, 10
+// with D/C low followed by its 128 bytes with D/C high, in order, and no
+// D/C change while a byte was on the wire. A faulted transfer must make
+// the next frame go out in full.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Driver.h"
+#include "LCD_Lib.h"
+#include "hps_emu.h"
+
+#define FRAME_BYTES            (128 * 8)
+#define POLL_WORK_NS           20000      // stand-in for one main-loop pass
+#define SPIM0_DMACR            (0x03F00000 + 0x4C)
+
+typedef struct {
+    bool    bIsData;
+    uint8_t Data;
+} WIRE_BYTE;
+
+static WIRE_BYTE gWire[4 * FRAME_BYTES];
+static int gWireLen;
+static int gDoneCalls;
+
+static void WireSink(void *pContext, bool bIsData, uint8_t Data) {
+    (void)pContext;
+    if (gWireLen < (int)(sizeof(gWire) / sizeof(gWire[0]))) {
+        gWire[gWireLen].bIsData = bIsData;
+        gWire[gWireLen].Data = Data;
+    }
+    gWireLen++;
+}
+
+static void OnFrameDone(void *pContext) {
+    (*(int *)pContext)++;
+}
+
+static bool Expect(int *pPos, bool bIsData, uint8_t Data) {
+    int i = (*pPos)++;
+    if (i >= gWireLen || gWire[i].bIsData != bIsData || gWire[i].Data != Data) {
+        printf("  mismatch at byte %d: want %s 0x%02X, got %s 0x%02X\n", i,
+               bIsData ? "data" : "cmd", Data,
+               i < gWireLen ? (gWire[i].bIsData ? "data" : "cmd") : "-",
+               i < gWireLen ? gWire[i].Data : 0);
+        return false;
+    }
+    return true;
+}
+
+static bool CheckFrame(int *pPos, const uint8_t *pFrame) {
+    for (int Page = 0; Page < 8; Page++) {
+        if (!Expect(pPos, false, 0xB0 | Page) || !Expect(pPos, false, 0x00) ||
+            !Expect(pPos, false, 0x10))
+            return false;
+        for (int i = 0; i < 128; i++) {
+            if (!Expect(pPos, true, pFrame[Page * 128 + i]))
+                return false;
+        }
+    }
+    return true;
+}
+
+// Submit one frame and keep "polling the FPGA" until its fence signals.
+// Inline is LCD_FrameCopy, which returns once the frame is out.
+static int RunFrame(const char *pName, uint8_t *pFrame, bool bInline) {
+    EMU_STATS stats;
+    uint64_t t0 = EMU_NowNs();
+    uint32_t fence = 0;
+    int polls = 0;
+
+    EMU_ClearStats();
+    if (bInline)
+        LCD_FrameCopy(pFrame);
+    else
+        fence = LCD_FrameCopyAsync(pFrame, OnFrameDone, &gDoneCalls);
+    uint64_t submit_ns = EMU_NowNs() - t0;
+    while (!bInline && !LCD_FrameDone(fence)) {
+        (void)HPSREG_Read32(LWFPGA_OFFSET(FSM_STATUS_PIO_BASE));
+        EMU_AdvanceNs(POLL_WORK_NS);
+        polls++;
+    }
+    EMU_GetStats(&stats);
+
+    printf("%-6s submit %6.1f us, done after %3d polls (%7.1f us), "
+           "%5llu CPU reg accesses, %5llu DMA insns\n",
+           pName, submit_ns / 1000.0, polls, (EMU_NowNs() - t0) / 1000.0,
+           (unsigned long long)(stats.RegReads + stats.RegWrites),
+           (unsigned long long)stats.DmaInsns);
+    if (stats.DcRaces || stats.FifoOverflows || stats.RxOverflows || stats.DmaFaults) {
+        printf("  dc_races=%llu tx_overflows=%llu rx_overflows=%llu faults=%llu\n",
+               (unsigned long long)stats.DcRaces, (unsigned long long)stats.FifoOverflows,
+               (unsigned long long)stats.RxOverflows, (unsigned long long)stats.DmaFaults);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    static uint8_t frame_a[FRAME_BYTES], frame_b[FRAME_BYTES];
+    int errors = 0, pos = 0;
+
+    for (int i = 0; i < FRAME_BYTES; i++) {
+        frame_a[i] = (uint8_t)(i * 7 + 3);
+        frame_b[i] = (uint8_t)(rand() & 0xFF);
+    }
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+    if (!LCD_SetDmaMode(true)) {
+        printf("FAIL: DMA mode unavailable\n");
+        return 1;
+    }
+    EMU_SetByteSink(WireSink, NULL);
+
+    errors += RunFrame("dma A", frame_a, false);
+    errors += RunFrame("dma B", frame_b, false);
+    LCDDrv_Display(true);      // PIO command after DMA must see D/C low again
+
+    if (!CheckFrame(&pos, frame_a)) errors++;
+    if (!CheckFrame(&pos, frame_b)) errors++;
+    if (!Expect(&pos, false, 0xAF)) errors++;
+    if (gWireLen != pos) {
+        printf("  %d unexpected trailing bytes\n", gWireLen - pos);
+        errors++;
+    }
+    if (gDoneCalls != 2) {
+        printf("  completion callback ran %d times, want 2\n", gDoneCalls);
+        errors++;
+    }
+
+    // A channel fault leaves part of a frame on the panel. With RDMAE
+    // cleared the program faults at its first RX handshake, after the first
+    // address command; the same frame queued again must then go out whole
+    // rather than as an empty diff against a shadow that never arrived.
+    HPSREG_Write32(SPIM0_DMACR, 0);
+    LCD_FrameCopyAsync(frame_a, NULL, NULL);
+    LCD_FrameSync();
+    HPSREG_Write32(SPIM0_DMACR, 1);
+    EMU_AdvanceNs(100000);              // what was in the FIFO reaches the panel
+    pos = gWireLen;
+    errors += RunFrame("refill", frame_a, false);
+    if (!CheckFrame(&pos, frame_a)) {
+        printf("  frame after a channel fault was not sent in full\n");
+        errors++;
+    }
+
+    // Same frame over PIO for comparison: the CPU spins for the whole push.
+    LCD_SetDmaMode(false);
+    errors += RunFrame("pio", frame_b, true);
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+// Host check and benchmark for the span primitives.
+// Build: make lcd_draw_bench
+//
+// Draws random lines, rectangles and fills, partly or wholly off the
+// canvas, in all three colours, through the span code and through a
+// per-pixel reference, on a random background, and requires identical
+// frames. Diagonal lines and circles are checked against their own
+// shape drawn set on a blank mask, so DRAW_INVERT must toggle exactly
+// those pixels. Then times a full-screen fill and a frame of outlines
+// both ways.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "lcd_graphic.h"
+#include "host_tool.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define CHECK_CASES     200000
+#define BENCH_FILLS     20000
+
+static uint8_t gFrameA[FRAME_BYTES], gFrameB[FRAME_BYTES], gMask[FRAME_BYTES];
+
+static void RefPixel(LCD_CANVAS *pCanvas, int X, int Y, int Color) {
+    if (Color == DRAW_INVERT) {
+        if (X < 0 || X >= pCanvas->Width || Y < 0 || Y >= pCanvas->Height) return;
+        pCanvas->pFrame[(Y >> 3) * pCanvas->Width + X] ^= 1 << (Y & 7);
+    } else {
+        DRAW_Pixel(pCanvas, X, Y, Color);
+    }
+}
+
+static void RefFill(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
+    int t;
+
+    if (X1 > X2) { t = X1; X1 = X2; X2 = t; }
+    if (Y1 > Y2) { t = Y1; Y1 = Y2; Y2 = t; }
+    for (int y = Y1; y <= Y2; y++)
+        for (int x = X1; x <= X2; x++)
+            RefPixel(pCanvas, x, y, Color);
+}
+
+// Outline as the old DRAW_Rect drew it, minus the repeated corners
+static void RefRect(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
+    int t;
+
+    if (X1 > X2) { t = X1; X1 = X2; X2 = t; }
+    if (Y1 > Y2) { t = Y1; Y1 = Y2; Y2 = t; }
+    for (int y = Y1; y <= Y2; y++)
+        for (int x = X1; x <= X2; x++)
+            if (x == X1 || x == X2 || y == Y1 || y == Y2)
+                RefPixel(pCanvas, x, y, Color);
+}
+
+// What drawing the pixels set in gMask with Color does to pFrame
+static void ApplyMask(uint8_t *pFrame, int Color) {
+    for (int k = 0; k < FRAME_BYTES; k++) {
+        if (Color == DRAW_INVERT)
+            pFrame[k] ^= gMask[k];
+        else if (Color)
+            pFrame[k] |= gMask[k];
+        else
+            pFrame[k] &= ~gMask[k];
+    }
+}
+
+static int Coord(int Max) {
+    return rand() % (Max + 40) - 20;
+}
+
+static int Check(void) {
+    LCD_CANVAS a, b, m;
+    int errors = 0;
+
+    InitCanvas(&a, gFrameA, 128, 64);
+    InitCanvas(&b, gFrameB, 128, 64);
+    InitCanvas(&m, gMask, 128, 64);
+    for (int i = 0; i < CHECK_CASES; i++) {
+        int x1 = Coord(128), y1 = Coord(64), x2 = Coord(128), y2 = Coord(64);
+        int color = rand() % 3;
+        int kind = i % 7;
+
+        for (int k = 0; k < FRAME_BYTES; k++)
+            gFrameA[k] = gFrameB[k] = (uint8_t)rand();
+        switch (kind) {
+        case 0:
+            DRAW_HLine(&a, x1, x2, y1, color);
+            RefFill(&b, x1, y1, x2, y1, color);
+            break;
+        case 1:
+            DRAW_VLine(&a, x1, y1, y2, color);
+            RefFill(&b, x1, y1, x1, y2, color);
+            break;
+        case 2:
+            DRAW_FillRect(&a, x1, y1, x2, y2, color);
+            RefFill(&b, x1, y1, x2, y2, color);
+            break;
+        case 3:
+            DRAW_Rect(&a, x1, y1, x2, y2, color);
+            RefRect(&b, x1, y1, x2, y2, color);
+            break;
+        case 4:
+            if (i & 1) y2 = y1; else x2 = x1;
+            DRAW_Line(&a, x1, y1, x2, y2, color);
+            RefFill(&b, x1, y1, x2, y2, color);
+            break;
+        case 5:
+            memset(gMask, 0x00, FRAME_BYTES);
+            DRAW_Line(&m, x1, y1, x2, y2, 1);
+            DRAW_Line(&a, x1, y1, x2, y2, color);
+            ApplyMask(gFrameB, color);
+            break;
+        default:
+            memset(gMask, 0x00, FRAME_BYTES);
+            DRAW_Circle(&m, x1, y1, abs(x2) % 40, 1);
+            DRAW_Circle(&a, x1, y1, abs(x2) % 40, color);
+            ApplyMask(gFrameB, color);
+            break;
+        }
+        if (memcmp(gFrameA, gFrameB, FRAME_BYTES) != 0 && errors++ < 5)
+            printf("  mismatch: kind %d (%d,%d)-(%d,%d) color %d\n", kind, x1, y1, x2, y2, color);
+    }
+    printf("spans: %d cases, %d mismatches\n", CHECK_CASES, errors);
+    return errors;
+}
+
+typedef void (*RECT_FN)(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color);
+
+// Microseconds per call of pfnRect over the rectangles Inset pixels apart
+static double Bench(RECT_FN pfnRect, int Color, int Inset) {
+    LCD_CANVAS c;
+    uint64_t t0;
+    int calls = 0;
+
+    InitCanvas(&c, gFrameA, 128, 64);
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_FILLS; i++) {
+        for (int d = 0; d < 32; d += Inset) {
+            pfnRect(&c, d, d, 127 - d, 63 - d, Color);
+            calls++;
+        }
+    }
+    return (NowNs() - t0) / 1e3 / calls;
+}
+
+int main(void) {
+    int errors = Check();
+
+    double ref_fill = Bench(RefFill, 1, 32);
+    double span_fill = Bench(DRAW_FillRect, 1, 32);
+    double ref_inv = Bench(RefFill, DRAW_INVERT, 32);
+    double span_inv = Bench(DRAW_FillRect, DRAW_INVERT, 32);
+    double ref_rect = Bench(RefRect, 1, 3);
+    double span_rect = Bench(DRAW_Rect, 1, 3);
+
+    printf("\n%-24s %12s %12s %8s\n", "", "per-pixel", "span", "speedup");
+    printf("%-24s %10.2fus %10.2fus %7.1fx\n", "full-screen fill", ref_fill, span_fill, ref_fill / span_fill);
+    printf("%-24s %10.2fus %10.2fus %7.1fx\n", "full-screen invert", ref_inv, span_inv, ref_inv / span_inv);
+    printf("%-24s %10.2fus %10.2fus %7.1fx\n", "rect outline", ref_rect, span_rect, ref_rect / span_rect);
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,235 @@
+// Host check of the event loop (event_loop.c).
+// Build: make lcd_evloop_sim
+//
+// Runs the loop with the app's kinds of sources for ACTIVE_US: a 5 ms and
+// a 20 ms periodic timer (the status poll and a watchdog), one-shot
+// deadlines armed at random from the fast timer, an eventfd a thread
+// signals at random intervals (the PIO interrupt stand-in) and SIGUSR1
+// sent to the process. Then every periodic source is removed and the loop
+// should sleep until its one remaining deadline.
+//
+// Reports timer lateness p50/p99/max against the schedule, eventfd
+// reaction latency, and wakeups and CPU time while idle. Fails if a
+// deadline, event or signal goes missing, a timer runs early, p99
+// lateness of the fast timer or the deadlines is over JITTER_BUDGET_US, or the idle loop wakes for anything
+// but its deadline.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+#include "event_loop.h"
+#include "host_tool.h"
+
+#define ACTIVE_US           2000000
+#define GRACE_US            100000      // outstanding deadlines fire before idle starts
+#define IDLE_US             1000000
+#define FAST_US             5000
+#define SLOW_US             20000
+#define MIN_DEADLINE_US     1000
+#define MAX_DEADLINE_US     15000
+#define MIN_GAP_US          2000
+#define MAX_GAP_US          18000
+#define SIGNAL_EVERY        20          // events
+#define JITTER_BUDGET_US    2000
+#define MAX_SAMPLES         1024
+
+typedef struct {
+    const char *pName;
+    uint32_t PeriodUs;
+    uint64_t DueNs;                 // the next expiry
+    uint64_t Late[MAX_SAMPLES];
+    int nLate;
+    int Early;
+} SAMPLES;
+
+static SAMPLES gFast = { "fast", FAST_US }, gSlow = { "slow", SLOW_US };
+static SAMPLES gDeadline = { "deadline", 0 }, gEvent = { "eventfd", 0 };
+static uint64_t gDeadlineDue[MAX_SAMPLES];
+static int gFastId, gSlowId, gArmed, gFired;
+static int gEventFd;
+static _Atomic uint64_t gSentNs;
+static atomic_int gEventsSent, gSignalsSent;
+static int gSignals;
+static uint64_t gActiveEndNs, gIdleWakeups, gIdleStartNs;
+static double gIdleCpu;
+
+static double CpuSeconds(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+static int CompareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static void Sample(SAMPLES *pSamples, uint64_t Now, uint64_t Due) {
+    if (Now < Due) pSamples->Early++;
+    else if (pSamples->nLate < MAX_SAMPLES) pSamples->Late[pSamples->nLate++] = Now - Due;
+}
+
+static void OnPeriodic(void *pContext) {
+    SAMPLES *pTimer = pContext;
+    uint64_t now = NowNs(), period = pTimer->PeriodUs * 1000ull;
+
+    // A missed period is skipped, as the loop does (and counts it)
+    while (now >= pTimer->DueNs + period)
+        pTimer->DueNs += period;
+    Sample(pTimer, now, pTimer->DueNs);
+    pTimer->DueNs += period;
+}
+
+static void OnDeadline(void *pContext) {
+    int i = (int)(intptr_t)pContext;
+
+    Sample(&gDeadline, NowNs(), gDeadlineDue[i]);
+    gFired++;
+}
+
+static void OnFast(void *pContext) {
+    uint32_t delay = MIN_DEADLINE_US + rand() % (MAX_DEADLINE_US - MIN_DEADLINE_US);
+
+    OnPeriodic(pContext);
+    if (gArmed == MAX_SAMPLES) return;
+    // Taken before arming, so the loop's own due time is never earlier
+    gDeadlineDue[gArmed] = NowNs() + delay * 1000ull;
+    if (EVLOOP_AddDeadline("deadline", delay, OnDeadline, (void *)(intptr_t)gArmed) >= 0)
+        gArmed++;
+}
+
+static void OnEvent(int Fd, uint32_t Events, void *pContext) {
+    uint64_t count;
+
+    (void)Events;
+    (void)pContext;
+    if (read(Fd, &count, sizeof(count)) == sizeof(count))
+        Sample(&gEvent, NowNs(), atomic_load(&gSentNs));
+}
+
+static void OnSignal(int Signo, void *pContext) {
+    (void)Signo;
+    (void)pContext;
+    gSignals++;
+}
+
+static void OnEnd(void *pContext) {
+    (void)pContext;
+    gIdleWakeups = EVLOOP_Wakeups() - gIdleWakeups;
+    gIdleCpu = CpuSeconds() - gIdleCpu;
+    EVLOOP_Stop();
+}
+
+// Everything that was due has fired: from here the loop should sleep
+static void OnIdle(void *pContext) {
+    (void)pContext;
+    gIdleStartNs = NowNs();
+    gIdleWakeups = EVLOOP_Wakeups();
+    gIdleCpu = CpuSeconds();
+    EVLOOP_AddDeadline("end", IDLE_US, OnEnd, NULL);
+}
+
+static void OnActiveEnd(void *pContext) {
+    (void)pContext;
+    EVLOOP_CancelTimer(gFastId);
+    EVLOOP_CancelTimer(gSlowId);
+    EVLOOP_RemoveFd(gEventFd);
+    EVLOOP_AddDeadline("grace", GRACE_US, OnIdle, NULL);
+}
+
+// The FPGA stand-in: events at random intervals, now and then a signal
+static void *Sender(void *pArg) {
+    uint64_t one = 1;
+
+    (void)pArg;
+    srand(2);
+    for (;;) {
+        usleep(MIN_GAP_US + rand() % (MAX_GAP_US - MIN_GAP_US));
+        if (NowNs() + MAX_GAP_US * 1000ull >= gActiveEndNs) break;
+        atomic_store(&gSentNs, NowNs());
+        if (write(gEventFd, &one, sizeof(one)) == sizeof(one))
+            atomic_fetch_add(&gEventsSent, 1);
+        if (atomic_load(&gEventsSent) % SIGNAL_EVERY == 0) {
+            kill(getpid(), SIGUSR1);
+            atomic_fetch_add(&gSignalsSent, 1);
+        }
+    }
+    return NULL;
+}
+
+static int Report(SAMPLES *pSamples, bool bBudget) {
+    int n = pSamples->nLate;
+    uint64_t p50, p99, max;
+    bool over;
+
+    qsort(pSamples->Late, n, sizeof(pSamples->Late[0]), CompareU64);
+    p50 = n ? pSamples->Late[n / 2] : 0;
+    p99 = n ? pSamples->Late[n * 99 / 100] : 0;
+    max = n ? pSamples->Late[n - 1] : 0;
+    over = bBudget && p99 > JITTER_BUDGET_US * 1000ull;
+    printf("%-9s %6d %8.1f %8.1f %8.1f %6d%s\n", pSamples->pName, n, p50 / 1e3, p99 / 1e3, max / 1e3,
+           pSamples->Early, over ? "  over budget" : "");
+    return over || pSamples->Early;
+}
+
+int main(void) {
+    EVLOOP_TIMER_STATS stats[EVLOOP_MAX_SOURCES];
+    pthread_t thread;
+    uint64_t t0;
+    int errors = 0, n;
+
+    if (!EVLOOP_Init()) return 1;
+    // Before the thread starts, so the signal is blocked in both
+    EVLOOP_AddSignal(SIGUSR1, OnSignal, NULL);
+    gEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    EVLOOP_AddFd(gEventFd, EPOLLIN, OnEvent, NULL);
+
+    t0 = NowNs();
+    gActiveEndNs = t0 + ACTIVE_US * 1000ull;
+    gFast.DueNs = t0 + FAST_US * 1000ull;
+    gSlow.DueNs = t0 + SLOW_US * 1000ull;
+    gFastId = EVLOOP_AddTimer("fast", FAST_US, OnFast, &gFast);
+    gSlowId = EVLOOP_AddTimer("slow", SLOW_US, OnPeriodic, &gSlow);
+    EVLOOP_AddDeadline("active", ACTIVE_US, OnActiveEnd, NULL);
+    pthread_create(&thread, NULL, Sender, NULL);
+
+    EVLOOP_Run();
+    pthread_join(thread, NULL);
+
+    printf("%-9s %6s %8s %8s %8s %6s   (late, us)\n", "source", "count", "p50", "p99", "max", "early");
+    errors += Report(&gFast, true);
+    errors += Report(&gSlow, false);       // 100 samples: its p99 is its max
+    errors += Report(&gDeadline, true);
+    errors += Report(&gEvent, false);
+
+    n = EVLOOP_GetTimerStats(stats, EVLOOP_MAX_SOURCES);
+    for (int i = 0; i < n; i++)
+        if (stats[i].PeriodUs)
+            printf("loop: %-9s %llu fired, %llu missed, late mean %.1f us, max %.1f us\n", stats[i].pName,
+                   (unsigned long long)stats[i].Fired, (unsigned long long)stats[i].Missed,
+                   stats[i].LateSumNs / 1e3 / (stats[i].Fired ? stats[i].Fired : 1), stats[i].LateMaxNs / 1e3);
+    printf("deadlines %d/%d fired, events %d/%d, signals %d/%d\n", gFired, gArmed, gEvent.nLate,
+           atomic_load(&gEventsSent), gSignals, atomic_load(&gSignalsSent));
+    printf("idle: %llu wakeups in %.2f s, CPU %.3f ms (%.3f%%)\n", (unsigned long long)gIdleWakeups,
+           (NowNs() - gIdleStartNs) / 1e9, gIdleCpu * 1e3, 100.0 * gIdleCpu / (IDLE_US / 1e6));
+
+    // Events sent back to back can merge into one read; none may be lost
+    errors += gFired != gArmed || gSignals != atomic_load(&gSignalsSent);
+    errors += gEvent.nLate < atomic_load(&gEventsSent) * 9 / 10;
+    errors += gIdleWakeups != 1;
+    EVLOOP_Close();
+    close(gEventFd);
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+// Host check and benchmark for the compact font format.
+// Build: make lcd_font_bench
+// Run:   ./lcd_font_bench [OUT.fnt]
+//
+// Saves font_16x16 as a compact font (OUT.fnt, default font_8x16.fnt),
+// maps it back with FONT_Load and requires every message row to render
+// identically through both. Then compares the glyph data each font
+// carries, the bytes the message rows actually touch, and
+// DRAW_PrintString speed. A proportional copy is saved alongside
+// (suffix .prop.fnt) for the text layout tools.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "lcd_graphic.h"
+#include "font.h"
+#include "font_file.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define BENCH_CHARS     4000000
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+
+static uint8_t gFrameA[FRAME_BYTES], gFrameB[FRAME_BYTES];
+
+// The compact cell is trimmed to the inked columns, so it matches the
+// full table on a clear background (the full cell's blank right half
+// only clears pixels that are already clear).
+static int CheckStrings(FONT_TABLE *pCompact) {
+    LCD_CANVAS a, b;
+    int errors = 0;
+
+    InitCanvas(&a, gFrameA, 128, 64);
+    InitCanvas(&b, gFrameB, 128, 64);
+    for (int m = 0; m < MSG_COUNT; m++) {
+        for (int y = -3; y <= 50; y += 7) {
+            memset(gFrameA, 0, FRAME_BYTES);
+            memset(gFrameB, 0, FRAME_BYTES);
+            for (int l = 0; l < 4; l++) {
+                DRAW_PrintString(&a, l - 3, y + l * 3, (char *)MSG_LIST[m][l], 1, &font_16x16);
+                DRAW_PrintString(&b, l - 3, y + l * 3, (char *)MSG_LIST[m][l], 1, pCompact);
+            }
+            if (memcmp(gFrameA, gFrameB, FRAME_BYTES) != 0 && errors++ < 5)
+                printf("  mismatch: message %d at y %d\n", m, y);
+        }
+    }
+    printf("strings: %d mismatches\n", errors);
+    return errors;
+}
+
+// Distinct glyph bytes the message rows read: the working set a render
+// pulls into the cache
+static size_t TouchedBytes(const FONT_TABLE *pFont) {
+    bool used[256] = { false };
+    size_t bytes = 0;
+
+    for (int m = 0; m < MSG_COUNT; m++)
+        for (int l = 0; l < 4; l++)
+            for (const char *p = MSG_LIST[m][l]; *p; p++)
+                used[(unsigned char)*p] = true;
+    for (int c = 0; c < 256; c++) {
+        if (!used[c]) continue;
+        if (pFont->pGlyphs) bytes += sizeof(FONT_GLYPH);
+        if (FONT_Glyph(pFont, (unsigned char)c)) bytes += 2 * pFont->CellWidth;
+    }
+    return bytes;
+}
+
+static double BenchStrings(FONT_TABLE *pFont) {
+    LCD_CANVAS c;
+    uint64_t t0, chars = 0;
+
+    InitCanvas(&c, gFrameA, 128, 64);
+    t0 = NowNs();
+    for (int r = 0; r < BENCH_CHARS / 64; r++) {
+        const char *const *pLines = MSG_LIST[r % MSG_COUNT];
+        for (int l = 0; l < 4; l++) {
+            DRAW_PrintString(&c, 0, l * 16, (char *)pLines[l], 1, pFont);
+            chars += strlen(pLines[l]);
+        }
+    }
+    return chars / ((NowNs() - t0) / 1e9);
+}
+
+int main(int argc, char **argv) {
+    const char *pPath = argc > 1 ? argv[1] : "font_8x16.fnt";
+    char prop_path[256];
+    FONT_TABLE *pCompact;
+    int errors, len = strlen(pPath);
+
+    if (len > 4 && strcmp(pPath + len - 4, ".fnt") == 0) len -= 4;
+    snprintf(prop_path, sizeof(prop_path), "%.*s.prop.fnt", len, pPath);
+    if (!FONT_Save(&font_16x16, pPath, false) || !FONT_Save(&font_16x16, prop_path, true))
+        return 1;
+    pCompact = FONT_Load(pPath);
+    if (!pCompact)
+        return 1;
+
+    errors = CheckStrings(pCompact);
+
+    double full = BenchStrings(&font_16x16);
+    double compact = BenchStrings(pCompact);
+
+    printf("\n%-22s %12s %12s\n", "", "font_16x16", "compact");
+    printf("%-22s %12zu %12zu\n", "glyph data, bytes", FONT_DataBytes(&font_16x16), FONT_DataBytes(pCompact));
+    printf("%-22s %12zu %12zu\n", "touched by messages", TouchedBytes(&font_16x16), TouchedBytes(pCompact));
+    printf("%-22s %10.2fM/s %10.2fM/s\n", "DRAW_PrintString", full / 1e6, compact / 1e6);
+
+    FONT_Unload(pCompact);
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
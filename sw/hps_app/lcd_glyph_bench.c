@@ -0,0 +1,122 @@
+// Host check and microbenchmark for the glyph blitter.
+// Build: make lcd_glyph_bench
+//
+// Draws every character at every X/Y offset around and across the canvas
+// edges with both colours, through DRAW_PrintChar (page blitter) and
+// DRAW_PrintCharRef (per-pixel), on a random background, and requires
+// identical frames. Then times both on aligned and unaligned rows, and
+// DRAW_PrintString on the message rows main.c draws.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "lcd_graphic.h"
+#include "font.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define BENCH_CHARS     2000000
+
+typedef void (*CHAR_FN)(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table);
+
+static uint8_t gFrameA[FRAME_BYTES], gFrameB[FRAME_BYTES];
+
+static int CheckChars(void) {
+    LCD_CANVAS a, b;
+    uint8_t background[FRAME_BYTES];
+    int cases = 0, errors = 0;
+
+    InitCanvas(&a, gFrameA, 128, 64);
+    InitCanvas(&b, gFrameB, 128, 64);
+    for (int i = 0; i < FRAME_BYTES; i++)
+        background[i] = (uint8_t)rand();
+
+    for (int ch = 0; ch < 256; ch++) {
+        for (int y = -17; y <= 65; y++) {
+            for (int x = -17; x <= 129; x += (x > -2 && x < 114) ? 13 : 1) {
+                for (int color = 0; color < 2; color++) {
+                    memcpy(gFrameA, background, FRAME_BYTES);
+                    memcpy(gFrameB, background, FRAME_BYTES);
+                    DRAW_PrintChar(&a, x, y, (char)ch, color, &font_16x16);
+                    DRAW_PrintCharRef(&b, x, y, (char)ch, color, &font_16x16);
+                    cases++;
+                    if (memcmp(gFrameA, gFrameB, FRAME_BYTES) != 0 && errors++ < 5)
+                        printf("  mismatch: char 0x%02X at (%d,%d) color %d\n", ch, x, y, color);
+                }
+            }
+        }
+    }
+    printf("chars:   %d cases, %d mismatches\n", cases, errors);
+    return errors;
+}
+
+static int CheckStrings(void) {
+    LCD_CANVAS a, b;
+    int errors = 0;
+
+    InitCanvas(&a, gFrameA, 128, 64);
+    InitCanvas(&b, gFrameB, 128, 64);
+    for (int m = 0; m < (int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])); m++) {
+        for (int y = -3; y <= 50; y += 7) {
+            memset(gFrameA, 0x5A, FRAME_BYTES);
+            memset(gFrameB, 0x5A, FRAME_BYTES);
+            for (int l = 0; l < 4; l++) {
+                const char *pText = MSG_LIST[m][l];
+                DRAW_PrintString(&a, l - 3, y + l * 3, (char *)pText, 1, &font_16x16);
+                for (int i = 0; pText[i]; i++)
+                    DRAW_PrintCharRef(&b, l - 3 + i * 8, y + l * 3, pText[i], 1, &font_16x16);
+            }
+            if (memcmp(gFrameA, gFrameB, FRAME_BYTES) != 0) errors++;
+        }
+    }
+    printf("strings: %d mismatches\n", errors);
+    return errors;
+}
+
+static double BenchChars(CHAR_FN pfnChar, int Y) {
+    LCD_CANVAS c;
+    uint64_t t0;
+
+    InitCanvas(&c, gFrameA, 128, 64);
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_CHARS; i++)
+        pfnChar(&c, (i & 15) * 8, Y, (char)(0x20 + (i % 95)), 1, &font_16x16);
+    return BENCH_CHARS / ((NowNs() - t0) / 1e9);
+}
+
+static double BenchStrings(void) {
+    LCD_CANVAS c;
+    uint64_t t0, chars = 0;
+
+    InitCanvas(&c, gFrameA, 128, 64);
+    t0 = NowNs();
+    for (int r = 0; r < BENCH_CHARS / 64; r++) {
+        const char *const *pLines = MSG_LIST[r % 18];
+        for (int l = 0; l < 4; l++) {
+            DRAW_PrintString(&c, 0, l * 16, (char *)pLines[l], 1, &font_16x16);
+            chars += strlen(pLines[l]);
+        }
+    }
+    return chars / ((NowNs() - t0) / 1e9);
+}
+
+int main(void) {
+    int errors = CheckChars() + CheckStrings();
+
+    double ref_al = BenchChars(DRAW_PrintCharRef, 16);
+    double blit_al = BenchChars(DRAW_PrintChar, 16);
+    double ref_un = BenchChars(DRAW_PrintCharRef, 19);
+    double blit_un = BenchChars(DRAW_PrintChar, 19);
+
+    printf("\n%-22s %12s %12s %8s\n", "", "per-pixel", "blitter", "speedup");
+    printf("%-22s %10.2fM/s %10.2fM/s %7.1fx\n", "chars, page aligned", ref_al / 1e6, blit_al / 1e6, blit_al / ref_al);
+    printf("%-22s %10.2fM/s %10.2fM/s %7.1fx\n", "chars, unaligned", ref_un / 1e6, blit_un / 1e6, blit_un / ref_un);
+    printf("%-22s %23.2fM/s\n", "DRAW_PrintString", BenchStrings() / 1e6);
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
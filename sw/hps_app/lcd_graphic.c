@@ -3,14 +3,31 @@
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 
 #include "lcd_graphic.h"
 #include "LCD_Lib.h"
 #include "font.h"
+#include "trace.h"
 
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DRAW_NEON   1
+#endif
+
+// Text canvas: drawing goes to the back buffer, the transfer reads the
+// front one. In PIO and spidev modes the transmit thread reads the front
+// in place until its fence retires, so a buffer becomes the back again
+// only after the frame it held is out.
 static LCD_CANVAS gCanvas;
-static uint8_t gFrameBuffer[128 * 8];
+static uint8_t gFrames[2][128 * 8];
+static uint32_t gFences[2];         // transfer that last sent each buffer
+static atomic_int gFront;
 static bool gCanvasInit = false;
+static bool gBackOpen = false;      // back buffer prepared for drawing
+static bool gFrameOpen = false;     // inside LCD_BeginFrame/LCD_CommitFrame
+static FONT_TABLE *gpFont = &font_16x16;
+static uint32_t gFontGeneration;
 
 void DRAW_Pixel(LCD_CANVAS *pCanvas, int X, int Y, int Color) {
     int nLine;
@@ -25,6 +42,8 @@ void DRAW_Pixel(LCD_CANVAS *pCanvas, int X, int Y, int Color) {
     
     if (Color == 0x00)
         *pFrame &= ~Mask;
+    else if (Color == DRAW_INVERT)
+        *pFrame ^= Mask;
     else
         *pFrame |= Mask;
 }
@@ -33,8 +52,178 @@ void DRAW_Refresh(LCD_CANVAS *pCanvas) {
     LCD_FrameCopy(pCanvas->pFrame);
 }
 
+#define REP8(b)     (0x0101010101010101ull * (uint8_t)(b))
+
+static inline uint64_t ApplyRop(uint64_t Dst, uint64_t Src, uint64_t Mask, int Rop) {
+    switch (Rop) {
+    case DRAW_ROP_COPY: return (Dst & ~Mask) | (Src & Mask);
+    case DRAW_ROP_OR:   return Dst | (Src & Mask);
+    case DRAW_ROP_AND:  return Dst & (Src | ~Mask);
+    case DRAW_ROP_XOR:  return Dst ^ (Src & Mask);
+    default:            return Dst ^ Mask;
+    }
+}
+
+// One destination page row of a blit: n columns whose source byte is the
+// top of pLo shifted down by Shift with the bottom of pHi below it (either
+// may be NULL when that source page is outside the canvas). Bits outside
+// Mask keep their value. 16 columns at a time with NEON, then 8 at a time
+// in a 64-bit word, shifting each byte with SWAR masks.
+static void BlitRow(uint8_t *pDst, const uint8_t *pLo, const uint8_t *pHi, int Shift, uint8_t Mask, int n, int Rop) {
+    uint64_t M = REP8(Mask);
+    uint64_t MaskLo = REP8(0xFF >> Shift);
+    uint64_t MaskHi = REP8(0xFF << (8 - Shift));
+    uint64_t Src, Dst, w;
+    int x = 0;
+
+#ifdef DRAW_NEON
+    uint8x16_t vM = vdupq_n_u8(Mask);
+    int8x16_t vShLo = vdupq_n_s8(-Shift), vShHi = vdupq_n_s8(8 - Shift);
+
+    for (; x + 16 <= n; x += 16) {
+        uint8x16_t vSrc = vdupq_n_u8(0), vDst = vld1q_u8(pDst + x);
+
+        if (pLo) vSrc = vshlq_u8(vld1q_u8(pLo + x), vShLo);
+        if (pHi) vSrc = vorrq_u8(vSrc, vshlq_u8(vld1q_u8(pHi + x), vShHi));
+        switch (Rop) {
+        case DRAW_ROP_COPY: vDst = vbslq_u8(vM, vSrc, vDst); break;
+        case DRAW_ROP_OR:   vDst = vorrq_u8(vDst, vandq_u8(vSrc, vM)); break;
+        case DRAW_ROP_AND:  vDst = vandq_u8(vDst, vornq_u8(vSrc, vM)); break;
+        case DRAW_ROP_XOR:  vDst = veorq_u8(vDst, vandq_u8(vSrc, vM)); break;
+        default:            vDst = veorq_u8(vDst, vM); break;
+        }
+        vst1q_u8(pDst + x, vDst);
+    }
+#endif
+    for (; x + 8 <= n; x += 8) {
+        Src = 0;
+        if (pLo) { memcpy(&w, pLo + x, 8); Src |= (w >> Shift) & MaskLo; }
+        if (pHi) { memcpy(&w, pHi + x, 8); Src |= (w << (8 - Shift)) & MaskHi; }
+        memcpy(&Dst, pDst + x, 8);
+        Dst = ApplyRop(Dst, Src, M, Rop);
+        memcpy(pDst + x, &Dst, 8);
+    }
+    for (; x < n; x++) {
+        Src = 0;
+        if (pLo) Src |= pLo[x] >> Shift;
+        if (pHi) Src |= (uint8_t)(pHi[x] << (8 - Shift));
+        pDst[x] = (uint8_t)ApplyRop(pDst[x], Src, Mask, Rop);
+    }
+}
+
+// Fills the clipped rectangle X1..X2, Y1..Y2 (inclusive, either order)
+// a page at a time: each page the span touches gets one mask, a full
+// page row is a memset and a partial one a masked byte per column.
+static void FillSpan(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
+    int t;
+
+    if (X1 > X2) { t = X1; X1 = X2; X2 = t; }
+    if (Y1 > Y2) { t = Y1; Y1 = Y2; Y2 = t; }
+    if (X1 < 0) X1 = 0;
+    if (Y1 < 0) Y1 = 0;
+    if (X2 >= pCanvas->Width) X2 = pCanvas->Width - 1;
+    if (Y2 >= pCanvas->Height) Y2 = pCanvas->Height - 1;
+    if (X1 > X2 || Y1 > Y2) return;
+
+    for (int Page = Y1 >> 3; Page <= Y2 >> 3; Page++) {
+        uint8_t Mask = 0xFF;
+        uint8_t *pDst = pCanvas->pFrame + Page * pCanvas->Width + X1;
+        int n = X2 - X1 + 1;
+
+        if (Page == Y1 >> 3) Mask &= 0xFF << (Y1 & 7);
+        if (Page == Y2 >> 3) Mask &= 0xFF >> (7 - (Y2 & 7));
+        if (Color == DRAW_INVERT) {
+            BlitRow(pDst, NULL, NULL, 0, Mask, n, DRAW_ROP_INVERT);
+        } else if (Mask == 0xFF) {
+            memset(pDst, Color ? 0xFF : 0x00, n);
+        } else if (Color) {
+            for (int x = 0; x < n; x++) pDst[x] |= Mask;
+        } else {
+            for (int x = 0; x < n; x++) pDst[x] &= ~Mask;
+        }
+    }
+}
+
+void DRAW_HLine(LCD_CANVAS *pCanvas, int X1, int X2, int Y, int Color) {
+    FillSpan(pCanvas, X1, Y, X2, Y, Color);
+}
+
+void DRAW_VLine(LCD_CANVAS *pCanvas, int X, int Y1, int Y2, int Color) {
+    FillSpan(pCanvas, X, Y1, X, Y2, Color);
+}
+
+void DRAW_FillRect(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
+    FillSpan(pCanvas, X1, Y1, X2, Y2, Color);
+}
+
+void DRAW_BitBlt(LCD_CANVAS *pDst, int DstX, int DstY, const LCD_CANVAS *pSrc, int SrcX, int SrcY,
+                 int Width, int Height, int Rop) {
+    uint8_t Stack[128 * 8];
+    uint8_t *pCopy = NULL;
+    const uint8_t *pSrcFrame;
+    int SrcPages, Last;
+
+    if (Rop == DRAW_ROP_INVERT || !pSrc) {
+        Rop = DRAW_ROP_INVERT;
+        pSrc = pDst;
+        SrcX = DstX;
+        SrcY = DstY;
+    }
+
+    // Clip against both canvases, moving the other corner along
+    if (DstX < 0) { SrcX -= DstX; Width += DstX; DstX = 0; }
+    if (DstY < 0) { SrcY -= DstY; Height += DstY; DstY = 0; }
+    if (SrcX < 0) { DstX -= SrcX; Width += SrcX; SrcX = 0; }
+    if (SrcY < 0) { DstY -= SrcY; Height += SrcY; SrcY = 0; }
+    if (Width > pDst->Width - DstX) Width = pDst->Width - DstX;
+    if (Width > pSrc->Width - SrcX) Width = pSrc->Width - SrcX;
+    if (Height > pDst->Height - DstY) Height = pDst->Height - DstY;
+    if (Height > pSrc->Height - SrcY) Height = pSrc->Height - SrcY;
+    if (Width <= 0 || Height <= 0) return;
+
+    // Blitting a canvas onto itself reads a snapshot, so overlapping
+    // regions behave as if the source had been copied out first
+    pSrcFrame = pSrc->pFrame;
+    if (Rop != DRAW_ROP_INVERT && pSrc->pFrame == pDst->pFrame) {
+        pCopy = pSrc->FrameSize <= (int)sizeof(Stack) ? Stack : malloc(pSrc->FrameSize);
+        if (!pCopy) return;
+        memcpy(pCopy, pSrc->pFrame, pSrc->FrameSize);
+        pSrcFrame = pCopy;
+    }
+
+    SrcPages = (pSrc->Height + 7) / 8;
+    Last = DstY + Height - 1;
+    for (int Page = DstY >> 3; Page <= Last >> 3; Page++) {
+        uint8_t Mask = 0xFF;
+        const uint8_t *pLo = NULL, *pHi = NULL;
+        int Shift = 0;
+
+        if (Page == DstY >> 3) Mask &= 0xFF << (DstY & 7);
+        if (Page == Last >> 3) Mask &= 0xFF >> (7 - (Last & 7));
+        if (Rop != DRAW_ROP_INVERT) {
+            // Source row that lands on the top bit of this page
+            int Row = Page * 8 + SrcY - DstY;
+            int SrcPage = Row >= 0 ? Row / 8 : -((7 - Row) / 8);
+
+            Shift = Row - SrcPage * 8;
+            if (SrcPage >= 0 && SrcPage < SrcPages)
+                pLo = pSrcFrame + SrcPage * pSrc->Width + SrcX;
+            if (Shift && SrcPage + 1 >= 0 && SrcPage + 1 < SrcPages)
+                pHi = pSrcFrame + (SrcPage + 1) * pSrc->Width + SrcX;
+        }
+        BlitRow(pDst->pFrame + Page * pDst->Width + DstX, pLo, pHi, Shift, Mask, Width, Rop);
+    }
+    if (pCopy && pCopy != Stack)
+        free(pCopy);
+}
+
 void DRAW_Line(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
-    int x, y, dx, dy, sx, sy, err, e2;
+    int dx, dy, sx, sy, err, e2;
+
+    if (Y1 == Y2 || X1 == X2) {
+        FillSpan(pCanvas, X1, Y1, X2, Y2, Color);
+        return;
+    }
     
     dx = abs(X2 - X1);
     dy = abs(Y2 - Y1);
@@ -51,11 +240,34 @@ void DRAW_Line(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
     }
 }
 
+// Each pixel of the outline is drawn once, so DRAW_INVERT works too
 void DRAW_Rect(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color) {
-    DRAW_Line(pCanvas, X1, Y1, X2, Y1, Color);
-    DRAW_Line(pCanvas, X2, Y1, X2, Y2, Color);
-    DRAW_Line(pCanvas, X2, Y2, X1, Y2, Color);
-    DRAW_Line(pCanvas, X1, Y2, X1, Y1, Color);
+    int t;
+
+    if (X1 > X2) { t = X1; X1 = X2; X2 = t; }
+    if (Y1 > Y2) { t = Y1; Y1 = Y2; Y2 = t; }
+    FillSpan(pCanvas, X1, Y1, X2, Y1, Color);
+    if (Y2 == Y1) return;
+    FillSpan(pCanvas, X1, Y2, X2, Y2, Color);
+    if (Y2 - Y1 < 2) return;
+    FillSpan(pCanvas, X1, Y1 + 1, X1, Y2 - 1, Color);
+    if (X2 != X1)
+        FillSpan(pCanvas, X2, Y1 + 1, X2, Y2 - 1, Color);
+}
+
+// The eight mirror images of (x, y), each distinct pixel once: on the
+// axes (y == 0) and the diagonals (x == y) images coincide, and
+// DRAW_INVERT would toggle them back
+static void CirclePoints(LCD_CANVAS *pCanvas, int x0, int y0, int x, int y, int Color) {
+    DRAW_Pixel(pCanvas, x0 + x, y0 + y, Color);
+    if (x != 0) DRAW_Pixel(pCanvas, x0 - x, y0 + y, Color);
+    if (y != 0) DRAW_Pixel(pCanvas, x0 + x, y0 - y, Color);
+    if (x != 0 && y != 0) DRAW_Pixel(pCanvas, x0 - x, y0 - y, Color);
+    if (x == y) return;
+    DRAW_Pixel(pCanvas, x0 + y, y0 + x, Color);
+    if (y != 0) DRAW_Pixel(pCanvas, x0 - y, y0 + x, Color);
+    if (x != 0) DRAW_Pixel(pCanvas, x0 + y, y0 - x, Color);
+    if (x != 0 && y != 0) DRAW_Pixel(pCanvas, x0 - y, y0 - x, Color);
 }
 
 void DRAW_Circle(LCD_CANVAS *pCanvas, int x0, int y0, int Radius, int Color) {
@@ -63,14 +275,7 @@ void DRAW_Circle(LCD_CANVAS *pCanvas, int x0, int y0, int Radius, int Color) {
     int radiusError = 1 - x;
 
     while (x >= y) {
-        DRAW_Pixel(pCanvas, x + x0, y + y0, Color);
-        DRAW_Pixel(pCanvas, y + x0, x + y0, Color);
-        DRAW_Pixel(pCanvas, -x + x0, y + y0, Color);
-        DRAW_Pixel(pCanvas, -y + x0, x + y0, Color);
-        DRAW_Pixel(pCanvas, -x + x0, -y + y0, Color);
-        DRAW_Pixel(pCanvas, -y + x0, -x + y0, Color);
-        DRAW_Pixel(pCanvas, x + x0, -y + y0, Color);
-        DRAW_Pixel(pCanvas, y + x0, -x + y0, Color);
+        CirclePoints(pCanvas, x0, y0, x, y, Color);
         y++;
         if (radiusError < 0)
             radiusError += 2 * y + 1;
@@ -85,16 +290,21 @@ void DRAW_Clear(LCD_CANVAS *pCanvas, int nValue) {
     memset(pCanvas->pFrame, nValue ? 0xFF : 0x00, pCanvas->FrameSize);
 }
 
-void DRAW_PrintChar(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table) {
-    unsigned char *pFont;
+// Per-pixel reference for DRAW_PrintChar; the blitter must match it bit for bit
+void DRAW_PrintCharRef(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table) {
+    static const unsigned char Blank[2 * LCD_CELL_SIZE_X];
+    const unsigned char *pGlyph = FONT_Glyph(font_table, (unsigned char)Text);
+    const unsigned char *pFont;
+    int Width = font_table->CellWidth;
     uint8_t Mask;
     int x, y, p;
 
+    if (!pGlyph) pGlyph = Blank;
     for (y = 0; y < 2; y++) {
         Mask = 0x01;
         for (p = 0; p < 8; p++) {
-            pFont = font_table->pBitmap[(unsigned char)Text][y];
-            for (x = 0; x < 16; x++) {
+            pFont = pGlyph + y * Width;
+            for (x = 0; x < Width; x++) {
                 if (Mask & *pFont) {
                     DRAW_Pixel(pCanvas, X0 + x, Y0 + y * 8 + p, Color);
                 } else {
@@ -108,35 +318,213 @@ void DRAW_PrintChar(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, F
     }
 }
 
+// Copies the first nCols columns of a glyph cell straight into the page
+// format frame (the font is stored the same way, two pages of Stride
+// bytes). The cell replaces what was under it; Color 0 or an empty glyph
+// (pGlyph NULL) clears it without reading any bitmap. Clipping is done
+// once per glyph. When Y0 is not page aligned each column spans three
+// pages and is shifted and masked into them.
+static void BlitGlyph(LCD_CANVAS *pCanvas, int X0, int Y0, const unsigned char *pGlyph, int Stride,
+                      int nCols, int Color) {
+    int Pages = pCanvas->Height / 8;
+    int Shift = Y0 & 7;
+    int Page0 = (Y0 - Shift) / 8;
+    int x0 = X0 < 0 ? -X0 : 0;
+    int x1 = nCols;
+
+    if (X0 + x1 > pCanvas->Width) x1 = pCanvas->Width - X0;
+    if (x0 >= x1) return;
+    if (!pGlyph) Color = 0;
+
+    if (Shift == 0) {
+        for (int h = 0; h < LCD_CELL_SIZE_Y; h++) {
+            int Page = Page0 + h;
+            uint8_t *pDst;
+
+            if (Page < 0 || Page >= Pages) continue;
+            pDst = pCanvas->pFrame + Page * pCanvas->Width + X0;
+            if (Color)
+                memcpy(pDst + x0, pGlyph + h * Stride + x0, x1 - x0);
+            else
+                memset(pDst + x0, 0x00, x1 - x0);
+        }
+        return;
+    }
+
+    // An off-canvas page gets an empty mask and a scratch row to write to
+    uint8_t Scratch[2 * LCD_CELL_SIZE_X];
+    uint8_t *pDst[3];
+    uint8_t Mask[3];
+    for (int k = 0; k < 3; k++) {
+        int Page = Page0 + k;
+        bool bOn = Page >= 0 && Page < Pages;
+        Mask[k] = bOn ? (uint8_t)((0xFFFFu << Shift) >> (8 * k)) : 0;
+        pDst[k] = bOn ? pCanvas->pFrame + Page * pCanvas->Width + X0 : Scratch + LCD_CELL_SIZE_X - x0;
+    }
+    for (int x = x0; x < x1; x++) {
+        uint32_t Col = Color ? ((pGlyph[x] | (pGlyph[Stride + x] << 8)) << Shift) : 0;
+        pDst[0][x] = (pDst[0][x] & ~Mask[0]) | ((uint8_t)Col & Mask[0]);
+        pDst[1][x] = (pDst[1][x] & ~Mask[1]) | ((uint8_t)(Col >> 8) & Mask[1]);
+        pDst[2][x] = (pDst[2][x] & ~Mask[2]) | ((uint8_t)(Col >> 16) & Mask[2]);
+    }
+}
+
+void DRAW_PrintChar(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table) {
+    // Canvases that end mid-page keep the per-pixel path for the bottom clip
+    if (pCanvas->Height & 7) {
+        DRAW_PrintCharRef(pCanvas, X0, Y0, Text, Color, font_table);
+        return;
+    }
+    BlitGlyph(pCanvas, X0, Y0, FONT_Glyph(font_table, (unsigned char)Text), font_table->CellWidth,
+              font_table->CellWidth, Color);
+}
+
 void DRAW_PrintString(LCD_CANVAS *pCanvas, int X0, int Y0, char *pText, int Color, FONT_TABLE *font_table) {
-    int nLen = strlen(pText);
+    DRAW_PrintText(pCanvas, X0, Y0, pText, strlen(pText), Color, font_table);
+}
+
+// The first nLen characters of pText (a row of a TEXT_LAYOUT). A cell is
+// usually wider than the advance (16 columns for 8 in the built-in font);
+// the next character overwrites the rest anyway, so only the last one is
+// drawn whole.
+void DRAW_PrintText(LCD_CANVAS *pCanvas, int X0, int Y0, const char *pText, int nLen, int Color,
+                    FONT_TABLE *font_table) {
+    int Cell = font_table->CellWidth;
+
     for (int i = 0; i < nLen; i++) {
-        DRAW_PrintChar(pCanvas, X0 + i * font_table->FontWidth, Y0, pText[i], Color, font_table);
+        unsigned char Code = (unsigned char)pText[i];
+        int Advance = FONT_Advance(font_table, Code);
+
+        if (pCanvas->Height & 7)
+            DRAW_PrintChar(pCanvas, X0, Y0, pText[i], Color, font_table);
+        else
+            BlitGlyph(pCanvas, X0, Y0, FONT_Glyph(font_table, Code), Cell,
+                      (i == nLen - 1 || Advance >= Cell) ? Cell : Advance, Color);
+        X0 += Advance;
     }
 }
 
+// Columns DRAW_PrintString advances over pText
+int DRAW_TextWidth(const char *pText, FONT_TABLE *font_table) {
+    int Width = 0;
+
+    for (; *pText; pText++)
+        Width += FONT_Advance(font_table, (unsigned char)*pText);
+    return Width;
+}
+
 static void InitCanvas(void) {
     if (!gCanvasInit) {
         gCanvas.Width = 128;
         gCanvas.Height = 64;
         gCanvas.FrameSize = 128 * 8;
-        gCanvas.pFrame = gFrameBuffer;
-        memset(gFrameBuffer, 0x00, sizeof(gFrameBuffer));
+        memset(gFrames, 0x00, sizeof(gFrames));
+        atomic_store(&gFront, 0);
+        gCanvas.pFrame = gFrames[1];
         gCanvasInit = true;
     }
 }
 
-void LCD_TextOut(int x, int y, char *text) {
+// Makes the back buffer drawable: once the transfer that last sent it
+// has retired it is cleared, or seeded from the front for an edit
+static void OpenBack(bool bKeep) {
+    int Front, Back;
+
     InitCanvas();
-    DRAW_PrintString(&gCanvas, x, y, text, 1, &font_16x16);
-    DRAW_Refresh(&gCanvas);
+    Front = atomic_load_explicit(&gFront, memory_order_relaxed);
+    Back = 1 - Front;
+    if (!LCD_FrameDone(gFences[Back]))
+        LCD_FrameSync();
+    gCanvas.pFrame = gFrames[Back];
+    if (bKeep)
+        memcpy(gFrames[Back], gFrames[Front], sizeof(gFrames[Back]));
+    else
+        memset(gFrames[Back], 0x00, sizeof(gFrames[Back]));
+    gBackOpen = true;
+}
+
+// Outside LCD_BeginFrame/LCD_CommitFrame drawing builds on what is shown
+static void EnsureBack(void) {
+    if (!gBackOpen)
+        OpenBack(true);
+}
+
+void LCD_TextOut(int x, int y, char *text) {
+    LCD_TextOutNoFlush(x, y, text);
+    if (!gFrameOpen)
+        LCD_CommitFrame();
 }
 
 void LCD_GraphicClear(void) {
-    printf("    [LCD_GraphicClear] Clearing buffer...\n");
+    if (gBackOpen)
+        memset(gCanvas.pFrame, 0x00, gCanvas.FrameSize);
+    else
+        OpenBack(false);
+    if (gFrameOpen) return;
+    TRACE_Record(TRACE_CLEAR_BEGIN, 0, 0);
+    LCD_CommitFrame();
+    TRACE_Record(TRACE_CLEAR_END, 0, 0);
+}
+
+void LCD_BeginFrame(void) {
+    OpenBack(false);
+    gFrameOpen = true;
+}
+
+void LCD_BeginEdit(void) {
+    EnsureBack();
+    gFrameOpen = true;
+}
+
+void LCD_TextOutNoFlush(int x, int y, const char *text) {
+    EnsureBack();
+    DRAW_PrintString(&gCanvas, x, y, (char *)text, 1, gpFont);
+}
+
+void LCD_TextSpanNoFlush(int x, int y, const char *text, int len) {
+    EnsureBack();
+    DRAW_PrintText(&gCanvas, x, y, text, len, 1, gpFont);
+}
+
+// The swap publishes the back buffer as the front before it is queued,
+// so the transfer only ever reads a finished frame
+void LCD_CommitFrame(void) {
+    int Back;
+
+    EnsureBack();
+    Back = gCanvas.pFrame == gFrames[0] ? 0 : 1;
+    atomic_store_explicit(&gFront, Back, memory_order_release);
+    gFences[Back] = LCD_FrameCopyAsync(gFrames[Back], NULL, NULL);
+    gCanvas.pFrame = gFrames[1 - Back];
+    gBackOpen = false;
+    gFrameOpen = false;
+}
+
+const uint8_t *LCD_FrontFrame(void) {
     InitCanvas();
-    memset(gFrameBuffer, 0x00, sizeof(gFrameBuffer));
-    printf("    [LCD_GraphicClear] Buffer cleared, refreshing display...\n");
-    DRAW_Refresh(&gCanvas);
-    printf("    [LCD_GraphicClear] Done.\n");
-}
\ No newline at end of file
+    return gFrames[atomic_load_explicit(&gFront, memory_order_acquire)];
+}
+
+// One 16-pixel text row per line, sent as a single frame
+void LCD_TextScreen(const char *const lines[4]) {
+    LCD_BeginFrame();
+    for (int i = 0; i < 4; i++) {
+        if (lines[i])
+            LCD_TextOutNoFlush(0, i * 16, lines[i]);
+    }
+    LCD_CommitFrame();
+}
+
+// Font for LCD_TextOut and friends; NULL selects the built-in 8x16 font
+void LCD_SetFont(FONT_TABLE *pFont) {
+    gpFont = pFont ? pFont : &font_16x16;
+    gFontGeneration++;
+}
+
+FONT_TABLE *LCD_GetFont(void) {
+    return gpFont;
+}
+
+uint32_t LCD_FontGeneration(void) {
+    return gFontGeneration;
+}
@@ -12,16 +12,62 @@ typedef struct {
     uint8_t *pFrame;
 } LCD_CANVAS;
 
+// Pixels, lines, rectangles and circles also take DRAW_INVERT, which
+// toggles each pixel of the shape once instead of setting it.
+#define DRAW_INVERT     2
+
+// DRAW_BitBlt raster operations, applied to each destination pixel of
+// the region with the matching source pixel. INVERT ignores the source.
+#define DRAW_ROP_COPY       0
+#define DRAW_ROP_OR         1
+#define DRAW_ROP_AND        2
+#define DRAW_ROP_XOR        3
+#define DRAW_ROP_INVERT     4
+
 void DRAW_Pixel(LCD_CANVAS *pCanvas, int X, int Y, int Color);
 void DRAW_Refresh(LCD_CANVAS *pCanvas);
 void DRAW_Line(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color);
 void DRAW_Rect(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color);
+void DRAW_HLine(LCD_CANVAS *pCanvas, int X1, int X2, int Y, int Color);
+void DRAW_VLine(LCD_CANVAS *pCanvas, int X, int Y1, int Y2, int Color);
+void DRAW_FillRect(LCD_CANVAS *pCanvas, int X1, int Y1, int X2, int Y2, int Color);
+void DRAW_BitBlt(LCD_CANVAS *pDst, int DstX, int DstY, const LCD_CANVAS *pSrc, int SrcX, int SrcY,
+                 int Width, int Height, int Rop);
 void DRAW_Circle(LCD_CANVAS *pCanvas, int x0, int y0, int Radius, int Color);
 void DRAW_Clear(LCD_CANVAS *pCanvas, int nValue);
 void DRAW_PrintChar(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table);
+void DRAW_PrintCharRef(LCD_CANVAS *pCanvas, int X0, int Y0, char Text, int Color, FONT_TABLE *font_table);
 void DRAW_PrintString(LCD_CANVAS *pCanvas, int X0, int Y0, char *pText, int Color, FONT_TABLE *font_table);
+void DRAW_PrintText(LCD_CANVAS *pCanvas, int X0, int Y0, const char *pText, int nLen, int Color,
+                    FONT_TABLE *font_table);
+int  DRAW_TextWidth(const char *pText, FONT_TABLE *font_table);
 
 void LCD_TextOut(int x, int y, char *text);
 void LCD_GraphicClear(void);
 
+// Batched drawing: LCD_BeginFrame clears the frame buffer and holds back
+// refreshes (LCD_TextOut and LCD_GraphicClear only draw) until
+// LCD_CommitFrame sends the finished screen in one transfer.
+//
+// The canvas is double-buffered. Drawing goes to the back buffer and
+// LCD_CommitFrame swaps it to the front before queueing it, so a transfer
+// never reads a frame that is still being drawn. The commit returns at
+// once in every mode (the DMA engine or the PIO/spidev transmit thread
+// sends the front), and the next frame is drawn while this one is on
+// the wire. LCD_BeginEdit is LCD_BeginFrame for incremental changes: the
+// back buffer starts as a copy of the front instead of blank.
+// LCD_FrontFrame is the last committed frame.
+void LCD_BeginFrame(void);
+void LCD_BeginEdit(void);
+void LCD_TextOutNoFlush(int x, int y, const char *text);
+void LCD_TextSpanNoFlush(int x, int y, const char *text, int len);
+void LCD_CommitFrame(void);
+void LCD_TextScreen(const char *const lines[4]);
+const uint8_t *LCD_FrontFrame(void);
+
+void LCD_SetFont(FONT_TABLE *pFont);
+FONT_TABLE *LCD_GetFont(void);
+// Changes on every LCD_SetFont, for caches of text drawn in the font
+uint32_t LCD_FontGeneration(void);
+
 #endif // _LCD_GRAPHIC_H_
\ No newline at end of file
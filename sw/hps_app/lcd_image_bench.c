@@ -0,0 +1,154 @@
+// Host check and benchmark for the row-major to page-major image import.
+// Build: make lcd_image_bench
+//
+// For every kernel this build and CPU have, against the per-pixel
+// reference:
+//   - exhaustive over single source bytes: every value 0..255 at every
+//     byte position of a 128x64 image (the conversion only moves bits,
+//     so this covers every source bit at every position),
+//   - random images of every size from 1x1 to 136x72 with padded rows,
+//     checking that nothing past the canvas is written,
+//   - a PBM round trip through IMAGE_LoadPbm.
+// Then times a panel-sized frame and a 1024x1024 image per kernel.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "image.h"
+#include "host_tool.h"
+
+#define MAX_W           136
+#define MAX_H           72
+#define GUARD           64
+#define BIG             1024
+#define BENCH_BYTES     (256u << 20)
+
+static uint8_t gSrc[MAX_H * (MAX_W / 8 + 8)];
+static uint8_t gWant[MAX_W * MAX_H / 8 + GUARD], gGot[MAX_W * MAX_H / 8 + GUARD];
+
+// pGot through the kernel under test, pWant through the reference
+static bool Same(int Kernel, int Width, int Height, int Stride) {
+    LCD_CANVAS want = { Width, Height, Width * ((Height + 7) / 8), gWant };
+    LCD_CANVAS got = { Width, Height, want.FrameSize, gGot };
+
+    memset(gGot, 0xA5, sizeof(gGot));
+    IMAGE_SetKernel(IMAGE_KERNEL_REF);
+    IMAGE_RowsToPages(&want, gSrc, Stride);
+    IMAGE_SetKernel(Kernel);
+    IMAGE_RowsToPages(&got, gSrc, Stride);
+    if (memcmp(gWant, gGot, want.FrameSize) != 0) return false;
+    for (int i = want.FrameSize; i < want.FrameSize + GUARD; i++)
+        if (gGot[i] != 0xA5) return false;
+    return true;
+}
+
+static int CheckBytes(int Kernel) {
+    int errors = 0;
+
+    memset(gSrc, 0, sizeof(gSrc));
+    for (int y = 0; y < 64; y++) {
+        for (int k = 0; k < 16; k++) {
+            for (int v = 0; v < 256; v++) {
+                gSrc[y * 16 + k] = (uint8_t)v;
+                if (!Same(Kernel, 128, 64, 16) && errors++ < 3)
+                    printf("  %s: byte 0x%02X at row %d, byte %d\n", IMAGE_KernelName(Kernel), v, y, k);
+            }
+            gSrc[y * 16 + k] = 0;
+        }
+    }
+    return errors;
+}
+
+static int CheckSizes(int Kernel) {
+    int errors = 0;
+
+    for (int h = 1; h <= MAX_H; h++) {
+        for (int w = 1; w <= MAX_W; w++) {
+            int stride = (w + 7) / 8 + (rand() % 3 == 0 ? rand() % 8 : 0);
+
+            for (int i = 0; i < h * stride; i++)
+                gSrc[i] = (uint8_t)rand();
+            if (!Same(Kernel, w, h, stride) && errors++ < 3)
+                printf("  %s: %dx%d, stride %d\n", IMAGE_KernelName(Kernel), w, h, stride);
+        }
+    }
+    return errors;
+}
+
+static int CheckPbm(int Kernel) {
+    const char *pPath = "/tmp/lcd_image_bench.pbm";
+    LCD_CANVAS want = { 100, 37, 100 * 5, gWant }, got;
+    int stride = 13, errors = 0;
+    FILE *f;
+
+    for (int i = 0; i < 37 * stride; i++)
+        gSrc[i] = (uint8_t)rand();
+    IMAGE_SetKernel(IMAGE_KERNEL_REF);
+    IMAGE_RowsToPages(&want, gSrc, stride);
+    f = fopen(pPath, "wb");
+    if (!f) return 1;
+    fprintf(f, "P4\n# lcd_image_bench\n100 37\n");
+    fwrite(gSrc, 1, 37 * stride, f);
+    fclose(f);
+    IMAGE_SetKernel(Kernel);
+    if (!IMAGE_LoadPbm(pPath, &got) || got.Width != 100 || got.Height != 37 ||
+        memcmp(got.pFrame, gWant, want.FrameSize) != 0) {
+        printf("  PBM round trip differs\n");
+        errors++;
+    }
+    IMAGE_Free(&got);
+    remove(pPath);
+    return errors;
+}
+
+// MB of source per second
+static double Bench(int Kernel, LCD_CANVAS *pDst, const uint8_t *pRows, int Stride) {
+    size_t bytes = (size_t)Stride * pDst->Height;
+    int loops = BENCH_BYTES / bytes / (Kernel == IMAGE_KERNEL_REF ? 64 : 1);
+    uint64_t t0;
+
+    IMAGE_SetKernel(Kernel);
+    t0 = NowNs();
+    for (int i = 0; i < loops; i++)
+        IMAGE_RowsToPages(pDst, pRows, Stride);
+    return (double)bytes * loops / ((NowNs() - t0) / 1e9) / 1e6;
+}
+
+int main(void) {
+    static uint8_t big_src[BIG * BIG / 8], big_dst[BIG * BIG / 8];
+    LCD_CANVAS panel = { 128, 64, 128 * 8, gGot }, big = { BIG, BIG, sizeof(big_dst), big_dst };
+    int best = IMAGE_GetKernel(), errors = 0;
+    uint64_t t0;
+
+    for (int k = IMAGE_KERNEL_SWAR; k < IMAGE_KERNELS; k++) {
+        int e;
+
+        if (!IMAGE_SetKernel(k)) continue;
+        e = CheckBytes(k) + CheckSizes(k);
+        printf("%-12s %s\n", IMAGE_KernelName(k), e ? "MISMATCH" : "matches the reference");
+        errors += e;
+    }
+    errors += CheckPbm(best);
+
+    for (size_t i = 0; i < sizeof(big_src); i++)
+        big_src[i] = (uint8_t)rand();
+    t0 = NowNs();
+    for (int i = 0; i < 64; i++)
+        memcpy(big_dst, big_src, sizeof(big_src));
+    printf("\n%-12s %14s %14s   (memcpy %.0f MB/s)\n", "", "128x64 frame", "1024x1024",
+           64.0 * sizeof(big_src) / ((NowNs() - t0) / 1e9) / 1e6);
+    for (int k = IMAGE_KERNEL_REF; k < IMAGE_KERNELS; k++) {
+        if (!IMAGE_SetKernel(k)) continue;
+        double frame = Bench(k, &panel, gSrc, 16);
+        double image = Bench(k, &big, big_src, BIG / 8);
+        printf("%-12s %9.0f MB/s %9.0f MB/s   %.3f us/frame%s\n", IMAGE_KernelName(k), frame, image,
+               1024 / frame, k == best ? "  (default)" : "");
+    }
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
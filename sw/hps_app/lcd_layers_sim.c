@@ -0,0 +1,186 @@
+// Host check for the layer compositor.
+// Build: make lcd_layers_sim
+//
+// Stacks a message screen (opaque content layer) under a transparent
+// status strip, as the app does, against the emulator in PIO and DMA
+// mode. After every change the panel must equal a per-pixel composition
+// of the layers: a countdown running from 15 to 0, a row marquee
+// scrolling under the strip, the strip moving and being hidden. Reports
+// the SPI bytes a countdown tick and a marquee step cost.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Lib.h"
+#include "hps_emu.h"
+#include "lcd_graphic.h"
+#include "layers.h"
+#include "marquee.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+#define MARQUEE_STEPS   300
+
+static int gContent, gStatus;
+static int gStatusX, gStatusY;
+static bool gStatusShown = true;
+static char gStatusText[17];
+
+// The content with the strip's ink ORed in where it is placed
+static void Expected(uint8_t *pFrame) {
+    const LCD_CANVAS *pStrip = LAYER_Canvas(gStatus);
+
+    memcpy(pFrame, LAYER_Canvas(gContent)->pFrame, FRAME_BYTES);
+    if (!gStatusShown) return;
+    for (int y = 0; y < pStrip->Height; y++)
+        for (int x = 0; x < pStrip->Width; x++)
+            if (GetPixel(pStrip, x, y) && gStatusX + x < 128 && gStatusY + y < 64)
+                pFrame[((gStatusY + y) >> 3) * 128 + gStatusX + x] |= 1 << ((gStatusY + y) & 7);
+}
+
+static bool PanelOk(const char *pWhat) {
+    uint8_t want[FRAME_BYTES], got[FRAME_BYTES];
+
+    LCD_FrameSync();
+    Expected(want);
+    EMU_GetPanel(got);
+    if (memcmp(want, got, FRAME_BYTES) == 0 && memcmp(want, LAYER_Frame(), FRAME_BYTES) == 0) return true;
+    printf("  panel is not the composition after %s\n", pWhat);
+    return false;
+}
+
+// Redraws the strip from the first character that changed, as the app does
+static void SetStatus(const char *pText) {
+    LCD_CANVAS *pStrip = LAYER_Canvas(gStatus);
+    char text[17];
+    int first = 0, x;
+
+    snprintf(text, sizeof(text), "%-16s", pText);
+    while (first < 16 && text[first] == gStatusText[first]) first++;
+    if (first == 16) return;
+    memcpy(gStatusText, text, 16);
+    text[first] = '\0';
+    x = DRAW_TextWidth(text, &font_16x16);
+    text[first] = gStatusText[first];
+    DRAW_FillRect(pStrip, x, 0, pStrip->Width - 1, pStrip->Height - 1, 0);
+    DRAW_PrintString(pStrip, x, 0, text + first, 1, &font_16x16);
+    LAYER_Dirty(gStatus, x, 0, pStrip->Width - 1, pStrip->Height - 1);
+}
+
+static void ShowScreen(int Msg) {
+    LCD_CANVAS *pContent = LAYER_Canvas(gContent);
+
+    memset(pContent->pFrame, 0, FRAME_BYTES);
+    for (int l = 0; l < 4; l++)
+        DRAW_PrintString(pContent, 0, l * 16, (char *)MSG_LIST[Msg][l], 1, &font_16x16);
+    LAYER_DirtyAll(gContent);
+}
+
+static int RunAll(bool bDma) {
+    char text[32];
+    uint64_t bytes = 0, cmd = 0;
+    int errors = 0, ticks = 0;
+    LAYER_STATS stats;
+    MARQUEE m;
+
+    printf("\n%s\n", bDma ? "DMA" : "PIO");
+    gContent = LAYER_Add(0, 0, 128, 64, DRAW_ROP_COPY);
+    gStatus = LAYER_Add(0, 16, 128, 16, DRAW_ROP_OR);
+    gStatusX = 0;
+    gStatusY = 16;
+    gStatusShown = true;
+    memset(gStatusText, 0, sizeof(gStatusText));
+
+    // Every message with its counter on the blank second row
+    for (int i = 0; i < MSG_COUNT; i++) {
+        ShowScreen(i);
+        snprintf(text, sizeof(text), " Msg %2d/%-2d   15s", i + 1, MSG_COUNT);
+        SetStatus(text);
+        LAYER_Compose();
+        if (!PanelOk("a message screen")) errors++;
+    }
+
+    // The countdown alone
+    for (int s = 14; s >= 0; s--) {
+        EMU_STATS emu;
+
+        EMU_ClearStats();
+        snprintf(text, sizeof(text), " Msg %2d/%-2d   %2ds", MSG_COUNT, MSG_COUNT, s);
+        SetStatus(text);
+        LAYER_Compose();
+        if (!PanelOk("a countdown tick")) errors++;
+        EMU_GetStats(&emu);
+        bytes += emu.TxBytes;
+        cmd += emu.CmdBytes;
+        ticks++;
+    }
+    printf("%-28s %6.1f SPI bytes (%.1f cmd)\n", "countdown tick", (double)bytes / ticks, (double)cmd / ticks);
+
+    // A row marquee on the last line, under the strip; the counter keeps going
+    ShowScreen(0);
+    LAYER_Compose();
+    bytes = 0;
+    if (MARQUEE_InitRow(&m, NULL, 48, " If You Need Help - press the red button ", &font_16x16)) {
+        for (int i = 0; i < MARQUEE_STEPS; i++) {
+            EMU_STATS emu;
+
+            EMU_ClearStats();
+            MARQUEE_Draw(&m, 1, LAYER_Canvas(gContent));
+            LAYER_Dirty(gContent, 0, m.Y, 127, m.Y + m.Strip.Height - 1);
+            if (i % 40 == 0) {
+                snprintf(text, sizeof(text), " Msg  1/%-2d   %2ds", MSG_COUNT, 15 - i / 40);
+                SetStatus(text);
+            }
+            LAYER_Compose();
+            if (!PanelOk("a marquee step") && errors++ > 3) break;
+            EMU_GetStats(&emu);
+            if (i > 0 && i % 40) bytes += emu.TxBytes;
+        }
+        printf("%-28s %6.1f SPI bytes\n", "marquee step", (double)bytes / (MARQUEE_STEPS - 1 - MARQUEE_STEPS / 40));
+        MARQUEE_Free(&m);
+    }
+
+    // Moved over the text, then hidden
+    LAYER_Move(gStatus, 0, 48);
+    gStatusY = 48;
+    LAYER_Compose();
+    if (!PanelOk("moving the strip")) errors++;
+    LAYER_Show(gStatus, false);
+    gStatusShown = false;
+    LAYER_Compose();
+    if (!PanelOk("hiding the strip")) errors++;
+
+    LAYER_GetStats(&stats);
+    printf("%-28s %6.0f pixels\n", "recomposed per compose", (double)stats.Pixels / stats.Composes);
+    LAYER_Free();
+    return errors;
+}
+
+int main(void) {
+    int errors;
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+
+    errors = RunAll(false);
+    if (!LCD_SetDmaMode(true)) {
+        printf("DMA mode unavailable\n");
+        errors++;
+    } else {
+        errors += RunAll(true);
+        LCD_SetDmaMode(false);
+    }
+
+    LCDHW_Close();
+    HPSREG_Close();
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
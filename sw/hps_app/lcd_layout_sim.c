@@ -0,0 +1,162 @@
+// Host check and benchmark for the text layout engine.
+// Build: make lcd_layout_sim
+// Run:   ./lcd_layout_sim [FONT.fnt]
+//
+// Lays out random texts (words of random length, runs of spaces, forced
+// breaks) in boxes of assorted sizes with every alignment, wrapped and
+// unwrapped, and checks each layout: rows fit the box unless one glyph
+// or an unwrapped paragraph is wider, rows never start or end with a
+// space, the non-space text comes out complete and in order (up to the
+// rows that did not fit), and rows are placed per the alignment. Then
+// times laying out every message against showing a stored layout.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "lcd_graphic.h"
+#include "font.h"
+#include "font_file.h"
+#include "text_layout.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define CHECK_CASES     200000
+#define BENCH_LOOPS     200000
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+
+static void RandomText(char *pText, int Size) {
+    static const char Chars[] = "abcdefghijklmnopqrstuvwxyzMW0123456789.,!?";
+    int n = rand() % (Size - 1);
+
+    for (int i = 0; i < n; i++) {
+        int r = rand() % 100;
+        pText[i] = r < 18 ? ' ' : r < 21 ? '\n' : Chars[rand() % (sizeof(Chars) - 1)];
+    }
+    pText[n] = '\0';
+}
+
+static int CheckOne(const TEXT_METRICS *pMetrics, const char *pText, int Width, int Height, int Flags) {
+    TEXT_LAYOUT layout;
+    const char *p = pText;
+    int errors = 0;
+
+    TEXT_Layout(&layout, pMetrics, pText, Width, Height, Flags);
+    if (layout.nLines > Height / pMetrics->LineHeight) errors++;
+    for (int i = 0; i < layout.nLines; i++) {
+        const TEXT_LINE *pLine = &layout.Lines[i];
+        const char *pRow = pText + pLine->Start;
+        int Room = Width - pLine->Width, Want;
+
+        if (pLine->Width != TEXT_Width(pMetrics, pRow, pLine->Len)) errors++;
+        if (pLine->Len && (pRow[0] == ' ' || pRow[pLine->Len - 1] == ' ')) errors++;
+        if (memchr(pRow, '\n', pLine->Len)) errors++;
+        if (Room < 0 && (Flags & TEXT_WRAP) && pLine->Len != 1) errors++;
+        if (Room < 0 && !layout.bOverflow) errors++;
+        if (Room < 0) Room = 0;
+        Want = (Flags & TEXT_ALIGN_MASK) == TEXT_CENTER ? Room / 2 :
+               (Flags & TEXT_ALIGN_MASK) == TEXT_RIGHT ? Room : 0;
+        if (pLine->X != Want) errors++;
+        if (i > 0 && pLine->Y != layout.Lines[i - 1].Y + pMetrics->LineHeight) errors++;
+        // Rows follow each other through the text, skipping only blanks
+        if (pRow < p) errors++;
+        for (; p < pRow; p++)
+            if (*p != ' ' && *p != '\n') errors++;
+        p = pRow + pLine->Len;
+    }
+    if (!layout.bTruncated) {
+        for (; *p; p++)
+            if (*p != ' ' && *p != '\n') errors++;
+    }
+    if (layout.nLines && (Flags & TEXT_MIDDLE) &&
+        layout.Lines[0].Y != (Height - layout.nLines * pMetrics->LineHeight) / 2)
+        errors++;
+    return errors;
+}
+
+static int Check(const TEXT_METRICS *pMetrics) {
+    static const int Boxes[][2] = { { 128, 64 }, { 128, 16 }, { 40, 48 }, { 5, 64 }, { 200, 128 } };
+    int nBoxes = sizeof(Boxes) / sizeof(Boxes[0]);
+    int errors = 0;
+    char text[160];
+
+    for (int i = 0; i < CHECK_CASES; i++) {
+        int b = rand() % nBoxes;
+        int flags = (rand() % 3) | (rand() & 1 ? TEXT_WRAP : 0) | (rand() & 1 ? TEXT_MIDDLE : 0);
+
+        RandomText(text, sizeof(text));
+        if (CheckOne(pMetrics, text, Boxes[b][0], Boxes[b][1], flags) && errors++ < 5)
+            printf("  bad layout: box %dx%d flags 0x%x \"%s\"\n", Boxes[b][0], Boxes[b][1], flags, text);
+    }
+    printf("layouts: %d cases, %d bad\n", CHECK_CASES, errors);
+    return errors;
+}
+
+// Drawing the rows in place must match drawing copies of them
+static int CheckDraw(const TEXT_LAYOUT *pLayout, const char *pText, FONT_TABLE *pFont) {
+    static uint8_t a[128 * 8], b[128 * 8];
+    LCD_CANVAS ca = { 128, 64, sizeof(a), a }, cb = { 128, 64, sizeof(b), b };
+    char row[160];
+
+    memset(a, 0, sizeof(a));
+    memset(b, 0, sizeof(b));
+    for (int l = 0; l < pLayout->nLines; l++) {
+        const TEXT_LINE *pLine = &pLayout->Lines[l];
+
+        DRAW_PrintText(&ca, pLine->X, pLine->Y, pText + pLine->Start, pLine->Len, 1, pFont);
+        snprintf(row, sizeof(row), "%.*s", pLine->Len, pText + pLine->Start);
+        DRAW_PrintString(&cb, pLine->X, pLine->Y, row, 1, pFont);
+    }
+    return memcmp(a, b, sizeof(a)) != 0;
+}
+
+int main(int argc, char **argv) {
+    static char text[MSG_COUNT][160];
+    static TEXT_LAYOUT layouts[MSG_COUNT];
+    FONT_TABLE *pFont = &font_16x16;
+    TEXT_METRICS metrics;
+    uint64_t t0;
+    int errors, truncated = 0;
+    volatile int sink = 0;
+
+    if (argc > 1 && !(pFont = FONT_Load(argv[1])))
+        return 1;
+    TEXT_InitMetrics(&metrics, pFont);
+    errors = Check(&metrics);
+
+    // Every message as one string, wrapped and centered
+    for (int m = 0; m < MSG_COUNT; m++) {
+        snprintf(text[m], sizeof(text[m]), "%s %s %s %s", MSG_LIST[m][0], MSG_LIST[m][1], MSG_LIST[m][2],
+                 MSG_LIST[m][3]);
+        TEXT_Layout(&layouts[m], &metrics, text[m], 128, 64, TEXT_CENTER | TEXT_WRAP | TEXT_MIDDLE);
+        truncated += layouts[m].bTruncated;
+        if (CheckDraw(&layouts[m], text[m], pFont) && errors++ < 5)
+            printf("  message %d draws differently in place\n", m);
+    }
+    printf("messages wrapped and centered: %d of %d do not fit four rows\n", truncated, MSG_COUNT);
+
+    // Per transition: lay the message out again, or read the stored rows
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_LOOPS; i++) {
+        TEXT_LAYOUT layout;
+        TEXT_Layout(&layout, &metrics, text[i % MSG_COUNT], 128, 64, TEXT_CENTER | TEXT_WRAP);
+        sink += layout.Lines[0].X;
+    }
+    double layout_us = (NowNs() - t0) / 1e3 / BENCH_LOOPS;
+    t0 = NowNs();
+    for (int i = 0; i < BENCH_LOOPS; i++) {
+        const TEXT_LAYOUT *pLayout = &layouts[i % MSG_COUNT];
+        for (int l = 0; l < pLayout->nLines; l++)
+            sink += pLayout->Lines[l].X;
+    }
+    double cached_us = (NowNs() - t0) / 1e3 / BENCH_LOOPS;
+    printf("\n%-26s %10.3fus\n%-26s %10.3fus\n", "layout per message", layout_us, "stored layout", cached_us);
+
+    if (pFont != &font_16x16)
+        FONT_Unload(pFont);
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
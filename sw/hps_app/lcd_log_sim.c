@@ -0,0 +1,154 @@
+// Host check of the logger (log.c).
+// Build: make lcd_log_sim
+//
+// Logs to a file the way the app does with --log, in three phases:
+// what one LOG_Write costs the caller against the synchronous fprintf it
+// replaces, two threads flooding the queue faster than it drains and
+// still logging when LOG_Stop shuts it down (every message must be either
+// in the file, in order per thread, or counted as dropped), and a call
+// site repeating faster than its rate limit.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "host_tool.h"
+
+#define LOG_PATH        "lcd_log_sim.log"
+#define TIMED           2000
+#define BURST           16
+#define FLOOD           20000
+#define PRODUCERS       2
+#define REPEATS         1000
+
+static _Atomic uint32_t gProduced;
+
+static void *Producer(void *pArg) {
+    int id = (int)(intptr_t)pArg;
+
+    for (uint32_t i = 0; i < FLOOD; i++) {
+        LOG_Info("p%d %u HW FSM: MSG(3), msg_idx=%u, secs_left=9, timeout=0", id, i, i % 18);
+        // Let main in to stop the queue halfway, even on one CPU
+        if (atomic_fetch_add(&gProduced, 1) % 64 == 63) sched_yield();
+    }
+    return NULL;
+}
+
+static void Repeat(void) {
+    LOG_Limited(LOG_LEVEL_WARN, "LCD SPI timeout draining burst (SR=0x%08X)", 0x00000007u);
+}
+
+int main(void) {
+    LOG_STATS s0, s1, s2;
+    pthread_t threads[PRODUCERS];
+    uint32_t next[PRODUCERS] = { 0 };
+    uint64_t t0, sync_ns, queued_ns, seen = 0;
+    unsigned long suppressed = 0;
+    int limited = 0, order_errors = 0;
+    char line[256];
+    FILE *fp;
+    bool ok;
+
+    unlink(LOG_PATH);
+
+    // Phase 1: the old path, fprintf + fflush on the caller's thread
+    fp = fopen(LOG_PATH, "a");
+    if (!fp) {
+        perror(LOG_PATH);
+        return 1;
+    }
+    t0 = NowNs();
+    for (uint32_t i = 0; i < TIMED; i++) {
+        fprintf(fp, "HW FSM: MSG(3), msg_idx=%u, secs_left=9, timeout=0\n", i % 18);
+        fflush(fp);
+    }
+    sync_ns = NowNs() - t0;
+    fclose(fp);
+    unlink(LOG_PATH);
+
+    if (!LOG_Open(LOG_TO_FILE, LOG_PATH) || !LOG_Start())
+        return 1;
+    // In bursts the writer keeps up with, as on the board
+    queued_ns = 0;
+    for (uint32_t i = 0; i < TIMED; i += BURST) {
+        t0 = NowNs();
+        for (uint32_t j = i; j < i + BURST; j++)
+            LOG_Info("HW FSM: MSG(3), msg_idx=%u, secs_left=9, timeout=0", j % 18);
+        queued_ns += NowNs() - t0;
+        usleep(2 * LOG_BATCH_US);
+    }
+    LOG_Stop();
+    LOG_GetStats(&s0);
+
+    // Phase 2: flood, stopping the queue under the producers; the rest
+    // of their messages are written directly
+    LOG_Start();
+    for (int t = 0; t < PRODUCERS; t++)
+        pthread_create(&threads[t], NULL, Producer, (void *)(intptr_t)t);
+    while (atomic_load(&gProduced) < FLOOD)
+        sched_yield();
+    LOG_Stop();
+    for (int t = 0; t < PRODUCERS; t++)
+        pthread_join(threads[t], NULL);
+    LOG_GetStats(&s1);
+
+    // Phase 3: rate limit, then the summary a second later
+    LOG_Start();
+    for (int i = 0; i < REPEATS; i++)
+        Repeat();
+    usleep(1100000);
+    Repeat();
+    LOG_GetStats(&s2);
+    LOG_Close();
+
+    fp = fopen(LOG_PATH, "r");
+    if (!fp) {
+        perror(LOG_PATH);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        const char *pText = strstr(line, "INFO  p");
+        const char *pSupp = strstr(line, "suppressed");
+        int id;
+        unsigned seq;
+
+        if (pText && sscanf(pText + 6, "p%d %u", &id, &seq) == 2 && id >= 0 && id < PRODUCERS) {
+            if (seq < next[id]) order_errors++;
+            next[id] = seq + 1;
+            seen++;
+        } else if (pSupp) {
+            sscanf(strchr(line, '(') + 1, "%lu", &suppressed);
+        } else if (strstr(line, "LCD SPI timeout")) {
+            limited++;
+        }
+    }
+    fclose(fp);
+    unlink(LOG_PATH);
+
+    printf("LOG_Write (queued)   %7.0f ns per message\n", (double)queued_ns / TIMED);
+    printf("fprintf + fflush     %7.0f ns per message\n", (double)sync_ns / TIMED);
+    printf("flood: %d threads x %d, %llu written, %llu dropped, max %u of %d waiting\n", PRODUCERS, FLOOD,
+           (unsigned long long)(s1.Written - s0.Written), (unsigned long long)(s1.Dropped - s0.Dropped),
+           s1.MaxDepth, LOG_QUEUE_SIZE);
+    printf("rate limit: %d repeats, %d written, %lu reported suppressed (%llu counted)\n", REPEATS + 1, limited,
+           suppressed, (unsigned long long)(s2.Suppressed - s1.Suppressed));
+
+    ok = s0.Dropped == 0 &&
+         seen == s1.Written - s0.Written &&
+         seen + (s1.Dropped - s0.Dropped) == PRODUCERS * FLOOD &&
+         order_errors == 0 &&
+         limited == LOG_LIMIT_BURST + 1 &&
+         suppressed == REPEATS - LOG_LIMIT_BURST &&
+         s2.Suppressed - s1.Suppressed == suppressed;
+    if (order_errors) printf("%d messages out of order\n", order_errors);
+    printf("%s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
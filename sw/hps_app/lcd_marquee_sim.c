@@ -0,0 +1,151 @@
+// Host check for the marquees.
+// Build: make lcd_marquee_sim
+//
+// Runs a row marquee (a message line wider than the panel over its cached
+// screen) and line marquees (all of MSG_LIST scrolling up, and one
+// panel-high screen rotating) against the emulator, in PIO and DMA mode.
+// After every step the picture the emulated panel shows (start line
+// applied) must equal the expected window of the content. Reports the SPI
+// bytes and bus time per step and the step rate the bus allows.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Lib.h"
+#include "hps_emu.h"
+#include "lcd_graphic.h"
+#include "marquee.h"
+#include "messages.h"
+#include "host_tool.h"
+
+#define FRAME_BYTES     (128 * 8)
+#define STEPS           600
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+
+// What the panel should show: the base with the band (row marquee) or the
+// whole panel (line marquee) taken from the strip at Pos, wrapping
+static void Expected(const MARQUEE *pMarquee, const uint8_t *pBase, uint8_t *pFrame) {
+    const LCD_CANVAS *pStrip = &pMarquee->Strip;
+
+    memcpy(pFrame, pBase, FRAME_BYTES);
+    for (int y = 0; y < 64; y++) {
+        for (int x = 0; x < 128; x++) {
+            int sx = x, sy = y, Bit;
+
+            if (pMarquee->bVertical) {
+                sy = (y + pMarquee->Pos) % pStrip->Height;
+            } else {
+                if (y < pMarquee->Y || y >= pMarquee->Y + pStrip->Height) continue;
+                sx = (x + pMarquee->Pos) % pStrip->Width;
+                sy = y - pMarquee->Y;
+            }
+            Bit = 1 << (y & 7);
+            if (GetPixel(pStrip, sx, sy))
+                pFrame[(y >> 3) * 128 + x] |= Bit;
+            else
+                pFrame[(y >> 3) * 128 + x] &= ~Bit;
+        }
+    }
+}
+
+static int Run(const char *pName, MARQUEE *pMarquee, const uint8_t *pBase) {
+    uint8_t want[FRAME_BYTES], got[FRAME_BYTES];
+    uint64_t bytes = 0, cmd = 0, ns = 0, max_ns = 0;
+    int errors = 0;
+
+    for (int i = 0; i < STEPS; i++) {
+        EMU_STATS stats;
+        uint64_t t0;
+
+        EMU_ClearStats();
+        t0 = EMU_NowNs();
+        MARQUEE_Step(pMarquee, 1);
+        LCD_FrameSync();
+        t0 = EMU_NowNs() - t0;
+        EMU_GetStats(&stats);
+        // The first step replaces whatever the panel showed before
+        if (i > 0) {
+            bytes += stats.TxBytes;
+            cmd += stats.CmdBytes;
+            ns += t0;
+            if (t0 > max_ns) max_ns = t0;
+        }
+        Expected(pMarquee, pBase, want);
+        EMU_GetPanel(got);
+        if (memcmp(want, got, FRAME_BYTES) != 0 && errors++ < 3)
+            printf("  %s: panel differs from the window at step %d\n", pName, i);
+    }
+    printf("%-26s %8.1f %8.1f %9.1f %9.1f %9.0f  %s\n", pName, (double)bytes / (STEPS - 1),
+           (double)cmd / (STEPS - 1), ns / 1e3 / (STEPS - 1), max_ns / 1e3,
+           1e9 / ((double)ns / (STEPS - 1)), errors ? "FAIL" : "ok");
+    return errors;
+}
+
+static int RunAll(bool bDma) {
+    static const char *const long_line = " If You Need Help - press the red button ";
+    static const char *all_lines[MSG_COUNT * 4];
+    uint8_t base[FRAME_BYTES], blank[FRAME_BYTES] = { 0 };
+    LCD_CANVAS c = { 128, 64, FRAME_BYTES, base };
+    MARQUEE m;
+    int errors = 0;
+
+    for (int i = 0; i < MSG_COUNT; i++)
+        for (int l = 0; l < 4; l++)
+            all_lines[i * 4 + l] = MSG_LIST[i][l];
+
+    printf("\n%s\n%-26s %8s %8s %9s %9s %9s\n", bDma ? "DMA" : "PIO", "", "bytes", "cmd", "avg us",
+           "max us", "steps/s");
+
+    memset(base, 0, sizeof(base));
+    for (int l = 0; l < 4; l++)
+        DRAW_PrintString(&c, 0, l * 16, (char *)MSG_LIST[10][l], 1, &font_16x16);
+    if (MARQUEE_InitRow(&m, base, 48, long_line, &font_16x16)) {
+        errors += Run("row, 40 chars", &m, base);
+        MARQUEE_Free(&m);
+    }
+    if (MARQUEE_InitLines(&m, all_lines, MSG_COUNT * 4, &font_16x16)) {
+        errors += Run("lines, all 18 messages", &m, blank);
+        MARQUEE_Free(&m);
+    }
+    if (MARQUEE_InitLines(&m, MSG_LIST[3], 4, &font_16x16)) {
+        errors += Run("lines, one screen rotating", &m, blank);
+        MARQUEE_Free(&m);
+    }
+
+    // A plain frame afterwards has to come out unrotated again
+    LCD_FrameCopy(base);
+    LCD_FrameSync();
+    EMU_GetPanel(blank);
+    if (memcmp(base, blank, FRAME_BYTES) != 0 || LCD_GetStartLine() != 0) {
+        printf("  plain frame after scrolling is not shown as drawn\n");
+        errors++;
+    }
+    return errors;
+}
+
+int main(void) {
+    int errors;
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+
+    errors = RunAll(false);
+    if (!LCD_SetDmaMode(true)) {
+        printf("DMA mode unavailable\n");
+        errors++;
+    } else {
+        errors += RunAll(true);
+        LCD_SetDmaMode(false);
+    }
+
+    LCDHW_Close();
+    HPSREG_Close();
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,221 @@
+// Offline asset packer: renders every screen lcd_msg_app shows into an
+// asset pack (pack.h) that the app maps with --pack instead of drawing
+// them at startup.
+// Build: make lcd_pack
+// Run:   ./lcd_pack [--font FILE.fnt] [--image NAME=FILE.pbm[@X,Y]]... OUT.pak
+//
+// The screens are drawn by the screen cache on the hps_emu.c backend,
+// with the same content and font the app would use, so the pack holds
+// exactly the frames the compiled-in path produces. Entries:
+//   idle, home, sleep, msg/NN   128x64 frames
+//   marquee/NN                  the row of message NN that scrolls, at its Y
+//   font                        the font (.fnt), used for the status strip
+//   NAME                        each --image, centered unless @X,Y is given
+//                               ("logo" is shown on the IDLE screen)
+// The pack is read back and compared against the sources before exiting.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "hps_regs.h"
+#include "LCD_Hw.h"
+#include "LCD_Lib.h"
+#include "lcd_graphic.h"
+#include "font.h"
+#include "font_file.h"
+#include "screen_cache.h"
+#include "text_layout.h"
+#include "image.h"
+#include "pack.h"
+#include "messages.h"
+
+#define MSG_COUNT       ((int)(sizeof(MSG_LIST) / sizeof(MSG_LIST[0])))
+#define MAX_IMAGES      16
+
+typedef struct {
+    char        Name[PACK_NAME_LEN];
+    LCD_CANVAS  Canvas;
+    int         X, Y;
+} IMAGE_ARG;
+
+static char msg_text[MSG_COUNT][MSG_TEXT_SIZE];
+static int idle_screen, home_screen, sleep_screen, msg_screens[MSG_COUNT];
+static IMAGE_ARG images[MAX_IMAGES];
+static int nImages;
+
+// NAME=FILE.pbm[@X,Y]
+static bool ParseImage(char *pArg) {
+    IMAGE_ARG *pImage = &images[nImages];
+    char *pFile = strchr(pArg, '='), *pAt;
+
+    if (!pFile || nImages == MAX_IMAGES || pFile - pArg >= PACK_NAME_LEN) return false;
+    *pFile++ = '\0';
+    pAt = strrchr(pFile, '@');
+    if (pAt) *pAt++ = '\0';
+    if (!IMAGE_LoadPbm(pFile, &pImage->Canvas)) return false;
+    if (!pAt) {
+        pImage->X = (128 - pImage->Canvas.Width) / 2;
+        pImage->Y = (64 - pImage->Canvas.Height) / 2;
+    } else if (sscanf(pAt, "%d,%d", &pImage->X, &pImage->Y) != 2) {
+        return false;
+    }
+    snprintf(pImage->Name, sizeof(pImage->Name), "%s", pArg);
+    nImages++;
+    return true;
+}
+
+// As lcd_msg_app builds its cache
+static void BuildScreens(void) {
+    idle_screen  = SCACHE_Add(IDLE_LINES);
+    home_screen  = SCACHE_Add(HOME_LINES);
+    sleep_screen = SCACHE_Add(NULL);
+    for (int i = 0; i < MSG_COUNT; i++) {
+        MSG_Text(msg_text[i], i);
+        msg_screens[i] = SCACHE_AddText(msg_text[i], MSG_TEXT_FLAGS);
+    }
+    SCACHE_Build();
+}
+
+static bool AddFrame(PACK_WRITER *pW, const char *pName, int Screen) {
+    const uint8_t *pFrame = SCACHE_Frame(Screen);
+    return pFrame && PACK_AddData(pW, pName, PACK_FRAME, pFrame, 128 * 8, 128, 64, 0, 0);
+}
+
+// The first laid-out row wider than the panel, as the app's marquee picks it
+static bool AddMarquee(PACK_WRITER *pW, int Msg) {
+    const TEXT_LAYOUT *pLayout = SCACHE_Layout(msg_screens[Msg]);
+    char name[PACK_NAME_LEN], row[MSG_TEXT_SIZE];
+
+    for (int l = 0; pLayout && l < pLayout->nLines; l++) {
+        const TEXT_LINE *pLine = &pLayout->Lines[l];
+
+        if (pLine->Width <= 128) continue;
+        snprintf(name, sizeof(name), "marquee/%02d", Msg);
+        snprintf(row, sizeof(row), "%.*s", pLine->Len, msg_text[Msg] + pLine->Start);
+        return PACK_AddData(pW, name, PACK_TEXT, row, strlen(row) + 1, 0, 0, 0, pLine->Y);
+    }
+    return true;
+}
+
+static bool Write(const char *pPath) {
+    PACK_WRITER w;
+    char name[PACK_NAME_LEN];
+    FILE *fp;
+    bool bOk;
+
+    if (!PACK_Create(&w, pPath)) return false;
+    bOk = AddFrame(&w, "idle", idle_screen) && AddFrame(&w, "home", home_screen) &&
+          AddFrame(&w, "sleep", sleep_screen);
+    for (int i = 0; bOk && i < MSG_COUNT; i++) {
+        snprintf(name, sizeof(name), "msg/%02d", i);
+        bOk = AddFrame(&w, name, msg_screens[i]) && AddMarquee(&w, i);
+    }
+    for (int i = 0; bOk && i < nImages; i++) {
+        const LCD_CANVAS *pCanvas = &images[i].Canvas;
+        bOk = PACK_AddData(&w, images[i].Name, PACK_IMAGE, pCanvas->pFrame, pCanvas->FrameSize,
+                           pCanvas->Width, pCanvas->Height, images[i].X, images[i].Y);
+    }
+    if (bOk && (fp = PACK_BeginEntry(&w, "font", PACK_FONT)) != NULL) {
+        bOk = FONT_Write(LCD_GetFont(), fp, false);
+        PACK_EndEntry(&w, 0, 0, 0, 0);
+    }
+    return PACK_Finish(&w) && bOk;
+}
+
+static int Verify(const char *pPath) {
+    PACK *pPack = PACK_Open(pPath);
+    const FONT_TABLE *pSrc = LCD_GetFont();
+    FONT_TABLE *pFont;
+    LCD_CANVAS c;
+    char name[PACK_NAME_LEN];
+    int errors = 0;
+
+    if (!pPack) return 1;
+    errors += !PACK_Canvas(pPack, "idle", PACK_FRAME, &c) || memcmp(c.pFrame, SCACHE_Frame(idle_screen), 1024);
+    errors += !PACK_Canvas(pPack, "home", PACK_FRAME, &c) || memcmp(c.pFrame, SCACHE_Frame(home_screen), 1024);
+    errors += !PACK_Canvas(pPack, "sleep", PACK_FRAME, &c) || memcmp(c.pFrame, SCACHE_Frame(sleep_screen), 1024);
+    for (int i = 0; i < MSG_COUNT; i++) {
+        snprintf(name, sizeof(name), "msg/%02d", i);
+        errors += !PACK_Canvas(pPack, name, PACK_FRAME, &c) ||
+                  memcmp(c.pFrame, SCACHE_Frame(msg_screens[i]), 1024);
+    }
+    for (int i = 0; i < nImages; i++) {
+        errors += !PACK_Canvas(pPack, images[i].Name, PACK_IMAGE, &c) ||
+                  memcmp(c.pFrame, images[i].Canvas.pFrame, c.FrameSize);
+    }
+    pFont = PACK_Font(pPack, "font");
+    if (!pFont) {
+        errors++;
+    } else {
+        for (int ch = 0; ch < 256; ch++) {
+            const unsigned char *a = FONT_Glyph(pSrc, ch), *b = FONT_Glyph(pFont, ch);
+
+            // Column by column over the source cell: the packed one may be narrower
+            for (int x = 0; x < pSrc->CellWidth; x++) {
+                for (int page = 0; page < 2; page++) {
+                    int va = a ? a[page * pSrc->CellWidth + x] : 0;
+                    int vb = b && x < pFont->CellWidth ? b[page * pFont->CellWidth + x] : 0;
+                    errors += va != vb;
+                }
+            }
+            errors += FONT_Advance(pSrc, ch) != FONT_Advance(pFont, ch);
+        }
+        FONT_Unload(pFont);
+    }
+    PACK_Close(pPack);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    const char *font_path = NULL, *out_path = NULL;
+    FONT_TABLE *font = NULL;
+    int errors;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            font_path = argv[++i];
+        } else if (strcmp(argv[i], "--image") == 0 && i + 1 < argc) {
+            if (!ParseImage(argv[++i])) {
+                fprintf(stderr, "Bad --image %s\n", argv[i]);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && !out_path) {
+            out_path = argv[i];
+        } else {
+            out_path = NULL;
+            break;
+        }
+    }
+    if (!out_path) {
+        fprintf(stderr, "Usage: %s [--font FILE.fnt] [--image NAME=FILE.pbm[@X,Y]]... OUT.pak\n", argv[0]);
+        return 1;
+    }
+
+    HPSREG_Open(&HPSREG_Emu);
+    LCDHW_Init();
+    LCD_Init();
+    if (font_path) {
+        font = FONT_Load(font_path);
+        if (!font) return 1;
+        LCD_SetFont(font);
+    }
+
+    BuildScreens();
+    errors = !Write(out_path);
+    if (!errors)
+        errors = Verify(out_path);
+    printf("%s: %d screens, %d images, %s\n", out_path, 3 + MSG_COUNT, nImages,
+           errors ? "FAILED" : "verified");
+
+    for (int i = 0; i < nImages; i++)
+        IMAGE_Free(&images[i].Canvas);
+    SCACHE_Free();
+    LCD_SetFont(NULL);
+    FONT_Unload(font);
+    LCDHW_Close();
+    HPSREG_Close();
+    return errors ? 1 : 0;
+}
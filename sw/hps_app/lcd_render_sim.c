@@ -0,0 +1,89 @@
+// Host check for the render thread mailbox.
+// Build: make lcd_render_sim
+//
+// A stand-in renderer takes FRAME_US per target, like a full frame push.
+// The poller fires bursts of targets much faster than that (rapid
+// KEY1/KEY2 presses) and must never block; after each burst the last
+// target rendered has to be the last one posted, and it has to land no
+// later than two frame times after the post (the frame in flight plus
+// the final one).
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "render_thread.h"
+
+#define FRAME_US        3000
+#define POST_GAP_US     200
+#define BURSTS          20
+#define BURST_LEN       12
+
+static _Atomic int gLastState = -1, gLastIndex = -1;
+static _Atomic uint64_t gLastDoneUs;
+
+static uint64_t NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void FakeRender(int State, int MsgIndex, void *pContext) {
+    (void)pContext;
+    usleep(FRAME_US);
+    atomic_store(&gLastState, State);
+    atomic_store(&gLastIndex, MsgIndex);
+    atomic_store(&gLastDoneUs, NowUs());
+}
+
+int main(void) {
+    RENDER_STATS stats;
+    uint64_t worst_post_us = 0, worst_latency_us = 0;
+    int errors = 0;
+
+    if (!RENDER_Start(FakeRender, NULL, 1, true)) {
+        printf("FAIL: render thread did not start\n");
+        return 1;
+    }
+
+    for (int b = 0; b < BURSTS; b++) {
+        uint64_t t_last = 0;
+        int idx = 0;
+
+        for (int i = 0; i < BURST_LEN; i++) {
+            idx = (b * BURST_LEN + i) % 18;
+            uint64_t t0 = NowUs();
+            RENDER_Post(3, idx);
+            t_last = NowUs();
+            if (t_last - t0 > worst_post_us) worst_post_us = t_last - t0;
+            usleep(POST_GAP_US);
+        }
+        usleep(3 * FRAME_US);
+
+        if (atomic_load(&gLastState) != 3 || atomic_load(&gLastIndex) != idx) {
+            printf("  burst %d: final target %d not rendered (last %d)\n",
+                   b, idx, atomic_load(&gLastIndex));
+            errors++;
+        }
+        uint64_t latency = atomic_load(&gLastDoneUs) - t_last;
+        if (latency > worst_latency_us) worst_latency_us = latency;
+    }
+
+    RENDER_Stop();
+    RENDER_GetStats(&stats);
+    printf("%llu posted, %llu rendered, %llu coalesced\n",
+           (unsigned long long)stats.Posted, (unsigned long long)stats.Rendered,
+           (unsigned long long)(stats.Posted - stats.Rendered));
+    printf("worst post %llu us, worst last-post-to-final-frame %llu us (frame %d us)\n",
+           (unsigned long long)worst_post_us, (unsigned long long)worst_latency_us, FRAME_US);
+    if (worst_latency_us > 2 * FRAME_US + 2000) {
+        printf("  final frame later than one frame after the one in flight\n");
+        errors++;
+    }
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,86 @@
+// Host check for the spidev backend.
+// Build: make lcd_spidev_sim
+//
+// Points LCDHW_InitSpidev at a FIFO instead of /dev/spidevB.C, pushes
+// LCD_Init and one frame through it and compares the captured bytes with
+// what the panel should receive. Also reports how many transfers (system
+// calls) the frame took.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "LCD_Hw.h"
+#include "LCD_HwSpidev.h"
+#include "LCD_Lib.h"
+
+#define FRAME_BYTES    (128 * 8)
+
+int main(void) {
+    static uint8_t frame[FRAME_BYTES];
+    static uint8_t expect[64 + FRAME_BYTES * 2], got[sizeof(expect) + 64];
+    static const uint8_t init_cmds[] = { 0xC8, 0x2F, 0x40, 0xB0, 0x00, 0x10, 0xAF };
+    char fifo_path[64];
+    LCDSPI_STATS stats;
+    int n = 0, len = 0, rd_fd, errors = 0;
+
+    snprintf(fifo_path, sizeof(fifo_path), "/tmp/lcd_spidev_sim.%d", (int)getpid());
+    if (mkfifo(fifo_path, 0600) < 0) {
+        perror("mkfifo");
+        return 1;
+    }
+    // Reader end first so the backend's O_WRONLY open does not block
+    rd_fd = open(fifo_path, O_RDONLY | O_NONBLOCK);
+    if (rd_fd < 0 || !LCDHW_InitSpidev(fifo_path, NULL)) {
+        unlink(fifo_path);
+        return 1;
+    }
+
+    for (int i = 0; i < FRAME_BYTES; i++)
+        frame[i] = (uint8_t)(i ^ (i >> 3));
+
+    LCD_Init();
+    memcpy(expect, init_cmds, sizeof(init_cmds));
+    n = sizeof(init_cmds);
+    for (int Page = 0; Page < 8; Page++) {
+        expect[n++] = 0xB0 | Page;
+        expect[n++] = 0x00;
+        expect[n++] = 0x10;
+        memcpy(&expect[n], &frame[Page * 128], 128);
+        n += 128;
+    }
+
+    LCDSPI_GetStats(&stats);
+    uint64_t init_transfers = stats.Transfers;
+    LCD_FrameCopy(frame);
+    LCDSPI_GetStats(&stats);
+
+    for (;;) {
+        ssize_t r = read(rd_fd, got + len, sizeof(got) - len);
+        if (r <= 0) break;
+        len += (int)r;
+    }
+    LCDHW_Close();
+    close(rd_fd);
+    unlink(fifo_path);
+
+    if (len != n || memcmp(got, expect, n) != 0) {
+        printf("byte stream mismatch: got %d bytes, want %d\n", len, n);
+        errors++;
+    }
+    printf("frame: %llu transfers, %llu bytes captured in total, %llu D/C toggles\n",
+           (unsigned long long)(stats.Transfers - init_transfers),
+           (unsigned long long)stats.Bytes, (unsigned long long)stats.DcToggles);
+    if (stats.Transfers - init_transfers != 16) {
+        printf("expected one transfer per D/C run (16 per frame)\n");
+        errors++;
+    }
+
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
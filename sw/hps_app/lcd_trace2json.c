@@ -0,0 +1,163 @@
+// Trace ring decoder: turns a dump from lcd_msg_app --trace (trace.h)
+// into Chrome trace JSON, to open in chrome://tracing or ui.perfetto.dev.
+// Build: make lcd_trace2json
+// Run:   ./lcd_trace2json DUMP [OUT.json]      (stdout without OUT)
+//
+// Each recording thread is a track. Begin/end pairs (render, marquee
+// tick, status strip, SPI page, clear) become spans; DMA transfers get a
+// track of their own, since completion is noticed by whichever thread
+// polls next. Register samples are a counter (state, index, seconds
+// left), the rest are instant events with their arguments. Times are
+// microseconds from the oldest event in the dump.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "trace.h"
+
+#define DMA_TRACK       TRACE_MAX_THREADS
+
+static const char *const gStates[8] = { "INIT", "IDLE", "HOME", "MSG", "SLEEP", "5", "6", "7" };
+static const char *const gTimeoutAt[] = { "tx", "tx_ready", "busy", "dc", "fifo", "drain", "dma" };
+
+// Span names by their begin event
+static const char *SpanName(int Type) {
+    switch (Type) {
+    case TRACE_RENDER_BEGIN:   return "render";
+    case TRACE_STATUS_BEGIN:   return "status strip";
+    case TRACE_SPI_PAGE_BEGIN: return "spi page";
+    case TRACE_TICK_BEGIN:     return "marquee tick";
+    default:                   return "clear";
+    }
+}
+
+// Ph: B/E span, i instant (on its thread's track), C counter, M metadata
+static void Event(FILE *fp, bool *pFirst, const char *pName, char Ph, int Tid, double Us, const char *pArgs) {
+    fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",%s\"pid\":1,\"tid\":%d,\"ts\":%.3f%s%s%s}",
+            *pFirst ? "" : ",", pName, Ph, Ph == 'i' ? "\"s\":\"t\"," : "", Tid, Us,
+            pArgs ? ",\"args\":{" : "", pArgs ? pArgs : "", pArgs ? "}" : "");
+    *pFirst = false;
+}
+
+int main(int argc, char **argv) {
+    TRACE_HEADER header;
+    TRACE_EVENT *pEvents;
+    FILE *in, *out = stdout;
+    bool first = true;
+    char args[160];
+    uint64_t t0;
+
+    if (argc < 2 || argc > 3) {
+        fprintf(stderr, "Usage: %s DUMP [OUT.json]\n", argv[0]);
+        return 1;
+    }
+    in = fopen(argv[1], "rb");
+    if (!in) {
+        perror(argv[1]);
+        return 1;
+    }
+    if (fread(&header, sizeof(header), 1, in) != 1 || header.Magic != TRACE_MAGIC ||
+        header.Version != TRACE_VERSION || header.EventSize != sizeof(TRACE_EVENT)) {
+        fprintf(stderr, "%s: not a trace dump (version %d)\n", argv[1], TRACE_VERSION);
+        fclose(in);
+        return 1;
+    }
+    pEvents = malloc((header.Count ? header.Count : 1) * sizeof(TRACE_EVENT));
+    if (!pEvents || fread(pEvents, sizeof(TRACE_EVENT), header.Count, in) != header.Count) {
+        fprintf(stderr, "%s: truncated\n", argv[1]);
+        free(pEvents);
+        fclose(in);
+        return 1;
+    }
+    fclose(in);
+    if (argc == 3) {
+        out = fopen(argv[2], "w");
+        if (!out) {
+            perror(argv[2]);
+            free(pEvents);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (int t = 0; t < TRACE_MAX_THREADS; t++) {
+        if (!header.Threads[t][0]) continue;
+        snprintf(args, sizeof(args), "\"name\":\"%.16s\"", header.Threads[t]);
+        Event(out, &first, "thread_name", 'M', t, 0, args);
+    }
+    Event(out, &first, "thread_name", 'M', DMA_TRACK, 0, "\"name\":\"spi dma\"");
+
+    t0 = header.Count ? pEvents[0].Ns : 0;
+    for (uint32_t i = 0; i < header.Count; i++) {
+        const TRACE_EVENT *e = &pEvents[i];
+        double us = e->Ns >= t0 ? (e->Ns - t0) / 1e3 : 0;
+        int tid = e->Thread < TRACE_MAX_THREADS ? e->Thread : 0;
+
+        switch (e->Type) {
+        case TRACE_REG_SAMPLE:
+            snprintf(args, sizeof(args), "\"state\":%d,\"index\":%d,\"secs_left\":%u", (e->A >> 5) & 7,
+                     e->A & 0x1F, (e->B >> 1) & 0x0F);
+            Event(out, &first, "status", 'C', tid, us, args);
+            break;
+        case TRACE_TRANSITION:
+            if (e->B == 0xFFFFFFFFu)
+                snprintf(args, sizeof(args), "\"to\":\"%s %d\"", gStates[(e->A >> 5) & 7], e->A & 0x1F);
+            else
+                snprintf(args, sizeof(args), "\"from\":\"%s %u\",\"to\":\"%s %d\"", gStates[(e->B >> 5) & 7],
+                         e->B & 0x1F, gStates[(e->A >> 5) & 7], e->A & 0x1F);
+            Event(out, &first, "transition", 'i', tid, us, args);
+            break;
+        case TRACE_RENDER_BEGIN:
+            snprintf(args, sizeof(args), "\"state\":\"%s\",\"msg_index\":%u", gStates[e->A & 7], e->B);
+            Event(out, &first, SpanName(e->Type), 'B', tid, us, args);
+            break;
+        case TRACE_STATUS_BEGIN:
+            snprintf(args, sizeof(args), "\"secs_left\":%d", e->A);
+            Event(out, &first, SpanName(e->Type), 'B', tid, us, args);
+            break;
+        case TRACE_SPI_PAGE_BEGIN:
+            snprintf(args, sizeof(args), "\"page\":%d,\"col\":%u,\"len\":%u", e->A, e->B >> 16, e->B & 0xFFFF);
+            Event(out, &first, SpanName(e->Type), 'B', tid, us, args);
+            break;
+        case TRACE_TICK_BEGIN:
+        case TRACE_CLEAR_BEGIN:
+            Event(out, &first, SpanName(e->Type), 'B', tid, us, NULL);
+            break;
+        case TRACE_RENDER_END:
+        case TRACE_STATUS_END:
+        case TRACE_SPI_PAGE_END:
+        case TRACE_TICK_END:
+        case TRACE_CLEAR_END:
+            Event(out, &first, SpanName(e->Type - 1), 'E', tid, us, NULL);
+            break;
+        case TRACE_DMA_SUBMIT:
+            snprintf(args, sizeof(args), "\"descriptors\":%d,\"bytes\":%u", e->A, e->B);
+            Event(out, &first, "dma", 'B', DMA_TRACK, us, args);
+            break;
+        case TRACE_DMA_DONE:
+            Event(out, &first, "dma", 'E', DMA_TRACK, us, NULL);
+            break;
+        case TRACE_SPI_TIMEOUT:
+            snprintf(args, sizeof(args), "\"at\":\"%s\",\"sr\":\"0x%08X\"",
+                     e->A < sizeof(gTimeoutAt) / sizeof(gTimeoutAt[0]) ? gTimeoutAt[e->A] : "?", e->B);
+            Event(out, &first, "spi timeout", 'i', tid, us, args);
+            break;
+        case TRACE_MARK:
+            snprintf(args, sizeof(args), "\"a\":%d,\"b\":%u", e->A, e->B);
+            Event(out, &first, "mark", 'i', tid, us, args);
+            break;
+        default:
+            break;                  // never written, or torn by a live dump
+        }
+    }
+    fprintf(out, "\n]}\n");
+    if (out != stdout) fclose(out);
+    fprintf(stderr, "%u events (%llu recorded, %llu overwritten), %.3f ms\n", header.Count,
+            (unsigned long long)header.Recorded, (unsigned long long)(header.Recorded - header.Count),
+            header.Count ? (pEvents[header.Count - 1].Ns - t0) / 1e6 : 0.0);
+    free(pEvents);
+    return 0;
+}
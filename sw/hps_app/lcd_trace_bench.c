@@ -0,0 +1,52 @@
+// Cost of one trace event (trace.c).
+// Build: make lcd_trace_bench
+//
+// Times TRACE_Record in a loop from one thread, then from two at once
+// (main and render both record on the board), against the clock read it
+// is built around. The ring wraps many times, as it does in a long run.
+
+#include <stdio.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "trace.h"
+#include "host_tool.h"
+
+#define EVENTS          2000000
+
+static void *Recorder(void *pArg) {
+    TRACE_SetThread((int)(intptr_t)pArg, "bench");
+    for (uint32_t i = 0; i < EVENTS; i++)
+        TRACE_Record(TRACE_MARK, (uint16_t)i, i);
+    return NULL;
+}
+
+int main(void) {
+    volatile uint64_t sink = 0;
+    pthread_t threads[2];
+    uint64_t t0, clock_ns, one_ns, two_ns;
+
+    t0 = NowNs();
+    for (uint32_t i = 0; i < EVENTS; i++)
+        sink += NowNs();
+    clock_ns = NowNs() - t0;
+
+    t0 = NowNs();
+    Recorder((void *)0);
+    one_ns = NowNs() - t0;
+
+    t0 = NowNs();
+    for (int t = 0; t < 2; t++)
+        pthread_create(&threads[t], NULL, Recorder, (void *)(intptr_t)(t + 1));
+    for (int t = 0; t < 2; t++)
+        pthread_join(threads[t], NULL);
+    two_ns = NowNs() - t0;
+
+    (void)sink;
+    printf("clock_gettime        %6.1f ns\n", (double)clock_ns / EVENTS);
+    printf("TRACE_Record         %6.1f ns per event, one thread\n", (double)one_ns / EVENTS);
+    printf("TRACE_Record         %6.1f ns per event per thread, two threads\n", (double)two_ns / EVENTS);
+    printf("ring: %d events, %zu KB\n", TRACE_SIZE, TRACE_SIZE * sizeof(TRACE_EVENT) / 1024);
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Host comparison of the status wait sources (status_wait.c).
+// Build: make lcd_wait_sim
+//
+// A thread stands in for the FPGA: it changes a status word at random
+// intervals (key presses, countdown seconds), then goes quiet as in
+// SLEEP. For the interrupt source it signals the eventfd after each
+// change, the way the PIO edge capture raises its IRQ. The main thread
+// runs the app's loop shape against each source: wait, read the status,
+// react if it changed. Reports the reaction latency (change to the loop
+// seeing it) and the wakeups per second while active and while idle.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "status_wait.h"
+#include "host_tool.h"
+
+#define CHANGES         150
+#define MIN_GAP_US      5000
+#define MAX_GAP_US      25000
+#define IDLE_US         1000000
+
+static _Atomic uint32_t gStatus;
+static _Atomic uint64_t gChangedNs;
+static atomic_bool gIdle, gDone;
+
+static void *Fpga(void *pArg) {
+    (void)pArg;
+    srand(1);
+    for (int i = 0; i < CHANGES; i++) {
+        usleep(MIN_GAP_US + rand() % (MAX_GAP_US - MIN_GAP_US));
+        atomic_store(&gChangedNs, NowNs());
+        atomic_fetch_add(&gStatus, 1);
+        STATWAIT_Notify();
+    }
+    atomic_store(&gIdle, true);
+    usleep(IDLE_US);
+    atomic_store(&gDone, true);
+    STATWAIT_Notify();
+    return NULL;
+}
+
+static int CompareU64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int Run(const STATUS_WAIT_OPS *pOps) {
+    static uint64_t latency[CHANGES];
+    uint64_t t0, active_ns = 0, idle_t0 = 0, sum = 0;
+    uint32_t last = 0;
+    int seen = 0, active_wakeups = 0, idle_wakeups = 0;
+    pthread_t thread;
+
+    atomic_store(&gStatus, 0);
+    atomic_store(&gIdle, false);
+    atomic_store(&gDone, false);
+    if (!STATWAIT_Open(pOps, NULL)) return 1;
+    t0 = NowNs();
+    pthread_create(&thread, NULL, Fpga, NULL);
+
+    while (!atomic_load(&gDone)) {
+        uint32_t status = atomic_load(&gStatus);
+
+        if (status != last) {
+            uint64_t now = NowNs();
+            if (seen < CHANGES) latency[seen++] = now - atomic_load(&gChangedNs);
+            last = status;
+        }
+        if (STATWAIT_Wait(-1) <= 0 || atomic_load(&gDone)) continue;
+        if (!atomic_load(&gIdle)) {
+            active_wakeups++;
+        } else {
+            if (!idle_t0) {
+                idle_t0 = NowNs();
+                active_ns = idle_t0 - t0;
+                continue;                   // the wakeup for the last change
+            }
+            idle_wakeups++;
+        }
+    }
+    pthread_join(thread, NULL);
+    STATWAIT_Close();
+
+    qsort(latency, seen, sizeof(latency[0]), CompareU64);
+    for (int i = 0; i < seen; i++)
+        sum += latency[i];
+    printf("%-8s %4d/%d  %8.1f %8.1f %8.1f %8.1f   %8.1f %8.1f\n", pOps->pName, seen, CHANGES,
+           sum / 1e3 / (seen ? seen : 1), latency[seen / 2] / 1e3, latency[seen * 99 / 100] / 1e3,
+           latency[seen - 1] / 1e3, active_wakeups / (active_ns / 1e9),
+           idle_wakeups / ((NowNs() - idle_t0) / 1e9));
+    // Some changes can be merged (two before one read), none may be missed
+    return seen < CHANGES * 9 / 10;
+}
+
+int main(void) {
+    int errors = 0;
+
+    printf("%-8s %9s  %8s %8s %8s %8s   %8s %8s\n", "source", "seen", "mean us", "p50 us", "p99 us",
+           "max us", "active/s", "idle/s");
+    errors += Run(&STATWAIT_Poll);
+    errors += Run(&STATWAIT_EventFd);
+    printf("%s\n", errors ? "FAIL" : "PASS");
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <syslog.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+
+#include "log.h"
+
+// Bounded multi-producer queue after Vyukov: a slot is free for the
+// producer whose position equals its Seq, and holds a message for the
+// consumer when Seq is one past that. Producers claim a position with a
+// compare-and-swap and never wait for each other or for the writer.
+typedef struct {
+    _Atomic uint64_t Seq;
+    uint64_t Ns;
+    int      Level;
+    char     Text[LOG_MSG_SIZE];
+} LOG_SLOT;
+
+static LOG_SLOT gQueue[LOG_QUEUE_SIZE];
+static _Atomic uint64_t gEnqueue;
+static _Atomic uint64_t gDequeue;
+static _Atomic bool gQueued;            // LOG_Start .. LOG_Stop
+static _Atomic bool gStop;
+static _Atomic bool gSleeping;          // the writer waits on gWake
+static _Atomic int gInFlight;           // LOG_Write calls that may be enqueueing
+static pthread_mutex_t gDirectLock = PTHREAD_MUTEX_INITIALIZER;
+static sem_t gWake;
+static pthread_t gWriter;
+
+static _Atomic int gLevel = LOG_LEVEL_INFO;
+static LOG_SINK gSink = LOG_TO_STDOUT;
+static FILE *gpFile;
+
+static _Atomic uint64_t gWritten;
+static _Atomic uint64_t gDropped;
+static _Atomic uint64_t gSuppressed;
+static _Atomic uint32_t gMaxDepth;
+
+static const char *const gLevelNames[] = { "ERROR", "WARN", "INFO", "DEBUG" };
+
+static uint64_t NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// The console gets the text as the printf it replaces would have printed
+// it, warnings and errors tagged and on stderr. A file gets the time
+// (CLOCK_MONOTONIC, as in trace dumps) and the level on every line.
+static void Emit(int Level, uint64_t Ns, const char *pText) {
+    switch (gSink) {
+    case LOG_TO_FILE:
+        fprintf(gpFile, "[%5llu.%06llu] %-5s %s\n", (unsigned long long)(Ns / 1000000000ull),
+                (unsigned long long)(Ns % 1000000000ull / 1000), gLevelNames[Level], pText);
+        break;
+    case LOG_TO_SYSLOG:
+        syslog(Level == LOG_LEVEL_ERROR ? LOG_ERR : Level == LOG_LEVEL_WARN ? LOG_WARNING :
+               Level == LOG_LEVEL_INFO ? LOG_INFO : LOG_DEBUG, "%s", pText);
+        break;
+    default:
+        if (Level <= LOG_LEVEL_WARN)
+            fprintf(stderr, "[%s] %s\n", gLevelNames[Level], pText);
+        else
+            fprintf(stdout, "%s\n", pText);
+        break;
+    }
+    atomic_fetch_add_explicit(&gWritten, 1, memory_order_relaxed);
+}
+
+static void Flush(void) {
+    if (gSink == LOG_TO_FILE) fflush(gpFile);
+    else if (gSink == LOG_TO_STDOUT) fflush(stdout);     // stderr is unbuffered
+}
+
+// Writer side; only one thread at a time (the writer, or LOG_Stop after it)
+static bool Dequeue(void) {
+    uint64_t pos = atomic_load_explicit(&gDequeue, memory_order_relaxed);
+    LOG_SLOT *pSlot = &gQueue[pos & (LOG_QUEUE_SIZE - 1)];
+
+    if (atomic_load_explicit(&pSlot->Seq, memory_order_acquire) != pos + 1) return false;
+    Emit(pSlot->Level, pSlot->Ns, pSlot->Text);
+    atomic_store_explicit(&pSlot->Seq, pos + LOG_QUEUE_SIZE, memory_order_release);
+    atomic_store_explicit(&gDequeue, pos + 1, memory_order_relaxed);
+    return true;
+}
+
+static void *Writer(void *pArg) {
+    struct sched_param param = { 0 };
+
+    (void)pArg;
+    // Behind everything else that wants the CPU; nice 19 where SCHED_IDLE is refused
+    if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0)
+        setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), 19);
+
+    while (!atomic_load(&gStop)) {
+        if (Dequeue()) {
+            while (Dequeue())
+                ;
+            Flush();
+            // Messages come in bursts (a transition logs three or four):
+            // nap instead of sleeping on gWake, so the rest of the burst
+            // is queued without a wakeup system call each
+            usleep(LOG_BATCH_US);
+            continue;
+        }
+        // Announce the sleep before the last look, so a producer that
+        // enqueues after that look is sure to see it and post
+        atomic_store(&gSleeping, true);
+        if (atomic_load(&gEnqueue) != atomic_load(&gDequeue) || atomic_load(&gStop)) {
+            atomic_store(&gSleeping, false);
+            continue;
+        }
+        while (sem_wait(&gWake) != 0)
+            ;
+    }
+    return NULL;
+}
+
+static void Enqueue(int Level, const char *pFormat, va_list Args) {
+    uint64_t pos = atomic_load_explicit(&gEnqueue, memory_order_relaxed);
+    uint64_t depth;
+    uint32_t max;
+    LOG_SLOT *pSlot;
+
+    for (;;) {
+        pSlot = &gQueue[pos & (LOG_QUEUE_SIZE - 1)];
+        int64_t diff = (int64_t)(atomic_load_explicit(&pSlot->Seq, memory_order_acquire) - pos);
+
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&gEnqueue, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            atomic_fetch_add_explicit(&gDropped, 1, memory_order_relaxed);
+            return;
+        } else {
+            pos = atomic_load_explicit(&gEnqueue, memory_order_relaxed);
+        }
+    }
+
+    pSlot->Ns = NowNs();
+    pSlot->Level = Level;
+    vsnprintf(pSlot->Text, sizeof(pSlot->Text), pFormat, Args);
+    atomic_store_explicit(&pSlot->Seq, pos + 1, memory_order_release);
+
+    depth = pos + 1 - atomic_load_explicit(&gDequeue, memory_order_relaxed);
+    max = atomic_load_explicit(&gMaxDepth, memory_order_relaxed);
+    while (depth > max && !atomic_compare_exchange_weak_explicit(&gMaxDepth, &max, (uint32_t)depth,
+                                                                 memory_order_relaxed, memory_order_relaxed))
+        ;
+    if (atomic_exchange(&gSleeping, false)) sem_post(&gWake);
+}
+
+void LOG_Write(int Level, const char *pFormat, ...) {
+    va_list args;
+
+    if (Level > atomic_load_explicit(&gLevel, memory_order_relaxed)) return;
+    va_start(args, pFormat);
+    // Counted before gQueued is read, so LOG_Stop can wait out a call
+    // that saw the queue open and is still publishing into it
+    atomic_fetch_add(&gInFlight, 1);
+    if (atomic_load(&gQueued)) {
+        Enqueue(Level, pFormat, args);
+        atomic_fetch_sub(&gInFlight, 1);
+    } else {
+        char text[LOG_MSG_SIZE];
+
+        atomic_fetch_sub(&gInFlight, 1);
+        vsnprintf(text, sizeof(text), pFormat, args);
+        // Held by LOG_Stop until the queue is drained, so a direct write
+        // never overtakes a message queued before it
+        pthread_mutex_lock(&gDirectLock);
+        Emit(Level, NowNs(), text);
+        Flush();
+        pthread_mutex_unlock(&gDirectLock);
+    }
+    va_end(args);
+}
+
+bool LOG_Allow(LOG_LIMIT *pLimit, int Level) {
+    uint64_t now;
+
+    if (Level > atomic_load_explicit(&gLevel, memory_order_relaxed)) return false;
+    now = NowNs();
+    if (now - pLimit->WindowNs >= 1000000000ull) {
+        if (pLimit->Suppressed)
+            LOG_Write(Level, "(%u similar messages suppressed)", pLimit->Suppressed);
+        pLimit->WindowNs = now;
+        pLimit->Count = 0;
+        pLimit->Suppressed = 0;
+    }
+    if (pLimit->Count < LOG_LIMIT_BURST) {
+        pLimit->Count++;
+        return true;
+    }
+    pLimit->Suppressed++;
+    atomic_fetch_add_explicit(&gSuppressed, 1, memory_order_relaxed);
+    return false;
+}
+
+bool LOG_Open(LOG_SINK Sink, const char *pPath) {
+    if (Sink == LOG_TO_FILE) {
+        gpFile = fopen(pPath, "a");
+        if (!gpFile) {
+            perror("LOG: cannot open log file");
+            return false;
+        }
+    } else if (Sink == LOG_TO_SYSLOG) {
+        openlog("lcd_msg_app", LOG_PID, LOG_USER);
+    }
+    gSink = Sink;
+    return true;
+}
+
+void LOG_Close(void) {
+    LOG_Stop();
+    if (gSink == LOG_TO_FILE) fclose(gpFile);
+    else if (gSink == LOG_TO_SYSLOG) closelog();
+    gpFile = NULL;
+    gSink = LOG_TO_STDOUT;
+}
+
+bool LOG_Start(void) {
+    int err;
+
+    if (atomic_load(&gQueued)) return true;
+    atomic_store(&gDequeue, atomic_load(&gEnqueue));
+    for (uint64_t i = 0, pos = atomic_load(&gEnqueue); i < LOG_QUEUE_SIZE; i++, pos++)
+        atomic_store(&gQueue[pos & (LOG_QUEUE_SIZE - 1)].Seq, pos);
+    if (sem_init(&gWake, 0, 0) != 0) {
+        perror("LOG: sem_init");
+        return false;
+    }
+    atomic_store(&gStop, false);
+    atomic_store(&gSleeping, false);
+    err = pthread_create(&gWriter, NULL, Writer, NULL);
+    if (err != 0) {
+        fprintf(stderr, "LOG: pthread_create: %s, logging directly\n", strerror(err));
+        sem_destroy(&gWake);
+        return false;
+    }
+    atomic_store_explicit(&gQueued, true, memory_order_release);
+    return true;
+}
+
+void LOG_Stop(void) {
+    if (!atomic_load(&gQueued)) return;
+    pthread_mutex_lock(&gDirectLock);
+    atomic_store(&gQueued, false);
+    // Calls from here on write directly. The ones already enqueueing
+    // finish first: their messages are in the final drain, and none of
+    // them posts gWake after it is destroyed.
+    while (atomic_load(&gInFlight) != 0)
+        sched_yield();
+    atomic_store(&gStop, true);
+    sem_post(&gWake);
+    pthread_join(gWriter, NULL);
+    sem_destroy(&gWake);
+    // Whatever came in while the writer was stopping
+    while (Dequeue())
+        ;
+    Flush();
+    pthread_mutex_unlock(&gDirectLock);
+}
+
+void LOG_SetLevel(int Level) {
+    atomic_store(&gLevel, Level);
+}
+
+void LOG_GetStats(LOG_STATS *pStats) {
+    pStats->Written = atomic_load(&gWritten);
+    pStats->Dropped = atomic_load(&gDropped);
+    pStats->Suppressed = atomic_load(&gSuppressed);
+    pStats->MaxDepth = atomic_load(&gMaxDepth);
+}
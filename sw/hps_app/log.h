@@ -0,0 +1,79 @@
+#ifndef _LOG_H_
+#define _LOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Leveled logging that keeps console I/O off the hot paths. A message is
+// formatted on the caller's thread into a slot of a fixed lock-free queue
+// and written out by a background thread at SCHED_IDLE, so a slow serial
+// console delays the log, not the frame. When the queue is full the
+// message is dropped and counted instead of blocking.
+//
+// Until LOG_Start (and again after LOG_Stop) messages are written
+// directly, so startup, shutdown and the host tools print in order.
+//
+// Levels above LOG_LEVEL_MAX compile to nothing (-DLOG_LEVEL_MAX=...);
+// LOG_SetLevel filters at run time below that.
+
+#define LOG_LEVEL_ERROR     0
+#define LOG_LEVEL_WARN      1
+#define LOG_LEVEL_INFO      2
+#define LOG_LEVEL_DEBUG     3
+
+#ifndef LOG_LEVEL_MAX
+#define LOG_LEVEL_MAX       LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_QUEUE_SIZE      256         // messages, a power of two
+#define LOG_MSG_SIZE        120         // longer ones are cut
+#define LOG_BATCH_US        2000        // writer: gather for this long after a message
+#define LOG_LIMIT_BURST     5           // LOG_Limited: per call site and second
+
+typedef enum {
+    LOG_TO_STDOUT,
+    LOG_TO_FILE,            // appended, each line with time and level
+    LOG_TO_SYSLOG
+} LOG_SINK;
+
+typedef struct {
+    uint64_t Written;
+    uint64_t Dropped;       // queue full
+    uint64_t Suppressed;    // over a LOG_Limited rate
+    uint32_t MaxDepth;      // most messages waiting at once
+} LOG_STATS;
+
+// Rate limit state of one call site
+typedef struct {
+    uint64_t WindowNs;
+    uint32_t Count;
+    uint32_t Suppressed;
+} LOG_LIMIT;
+
+#define LOG_At(Level, ...) \
+    do { if ((Level) <= LOG_LEVEL_MAX) LOG_Write((Level), __VA_ARGS__); } while (0)
+#define LOG_Error(...)      LOG_At(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_Warn(...)       LOG_At(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_Info(...)       LOG_At(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_Debug(...)      LOG_At(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// For messages that can repeat at a high rate (a stuck SPI, a dead
+// interrupt): at most LOG_LIMIT_BURST per second from this call site,
+// the next one let through says how many were left out
+#define LOG_Limited(Level, ...) \
+    do { \
+        static LOG_LIMIT _limit; \
+        if ((Level) <= LOG_LEVEL_MAX && LOG_Allow(&_limit, (Level))) LOG_Write((Level), __VA_ARGS__); \
+    } while (0)
+
+// pPath: the file for LOG_TO_FILE, else unused
+bool LOG_Open(LOG_SINK Sink, const char *pPath);
+void LOG_Close(void);
+bool LOG_Start(void);           // queue from here on
+void LOG_Stop(void);            // writes what is queued, then directly again
+void LOG_SetLevel(int Level);
+void LOG_Write(int Level, const char *pFormat, ...) __attribute__((format(printf, 2, 3)));
+bool LOG_Allow(LOG_LIMIT *pLimit, int Level);
+void LOG_GetStats(LOG_STATS *pStats);
+
+#endif // _LOG_H_
@@ -1,27 +1,35 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdatomic.h>
 #include <string.h>
 #include <signal.h>     // NEW: graceful shutdown
 #include <time.h>
+#include <sys/resource.h>
 
+#include "hps_regs.h"
+#include "hps_emu.h"
 #include "LCD_Hw.h"
 #include "LCD_Lib.h"
 #include "lcd_graphic.h"
 #include "font.h"
+#include "font_file.h"
 #include "messages.h"
+#include "render_thread.h"
+#include "screen_cache.h"
+#include "marquee.h"
+#include "layers.h"
+#include "image.h"
+#include "pack.h"
+#include "status_wait.h"
+#include "event_loop.h"
+#include "latency_hist.h"
+#include "trace.h"
+#include "log.h"
+#include "rt.h"
 
-#define HW_REGS_BASE          0xFC000000
-#define HW_REGS_SPAN          0x04000000
-#define HW_REGS_MASK          (HW_REGS_SPAN - 1)
-#define ALT_LWFPGASLVS_OFST   0xFF200000
-#define BUTTON_PIO_BASE       0x5000
-#define FSM_STATUS_PIO_BASE   0x6000
-#define TIMER_STATUS_PIO_BASE 0x7000
 #define BUTTON_MASK           0x0F
 #define TIMEOUT_SECONDS       15
 
@@ -33,6 +41,13 @@
 #define FSM_INDEX_FROM_REG(v)  ((v) & FSM_STATUS_INDEX_MASK)
 #define MSG_COUNT              18
 
+#define POLL_PERIOD_US         5000
+#define LOOP_CPU               0        // --rt pins the event loop here
+#define RENDER_CPU             1        // second A9 core; the event loop stays on CPU0
+#define EMU_KEY_PERIOD_NS      1000000000ull   // --keys: one script step per virtual second
+#define MARQUEE_PERIOD_US      25000    // 40 steps/s, one pixel each
+#define PROBE_PERIOD_US        1000000  // bridge watchdog
+
 typedef enum {
     HW_FSM_INIT  = 0,
     HW_FSM_IDLE  = 1,
@@ -42,14 +57,81 @@ typedef enum {
 } HwFsmState;
 
 // === Globals ===
-static void *virtual_base = MAP_FAILED;
-static volatile uint32_t *button_addr       = NULL;
-static volatile uint32_t *fsm_status_addr   = NULL;
-static volatile uint32_t *timer_status_addr = NULL;
-static int  fd = -1;
+static const uint32_t fsm_status_offset   = LWFPGA_OFFSET(FSM_STATUS_PIO_BASE);
+static const uint32_t timer_status_offset = LWFPGA_OFFSET(TIMER_STATUS_PIO_BASE);
+
+// Host run (--emu): key script and panel dumps
+static bool        use_emu        = false;
+static const char *emu_keys       = NULL;
+static uint64_t    emu_next_key_ns = EMU_KEY_PERIOD_NS;
+static const char *pbm_prefix     = NULL;
+static int         pbm_count      = 0;
+
+// Fixed screens and MSG_LIST are rasterized once into the screen cache,
+// or come pre-rendered from an asset pack (--pack, lcd_pack)
+static int idle_screen, home_screen, sleep_screen;
+static int msg_screens[MSG_COUNT];
+static char msg_text[MSG_COUNT][MSG_TEXT_SIZE];
+static PACK *pack = NULL;
+static const uint8_t *pack_frames[3 + MSG_COUNT];  // by screen id
+static LCDDRV_DLIST screen_lists[3 + MSG_COUNT];   // by screen id, replayed on a state change
+static bool backlight_on = true;        // render thread only
+static FONT_TABLE *font = NULL;         // --font, NULL = built-in
+static LCD_CANVAS logo;                 // --logo, pFrame NULL = text idle screen
+static bool logo_in_pack = false;       // logo.pFrame points into the pack
+static int logo_x, logo_y;
+static uint64_t start_us;               // for the time to the first frame
+static bool render_threaded = false;
+static uint64_t loop_start_us;          // for the wakeup rate
+static const char *trace_path = NULL;   // --trace: ring dump on SIGUSR2 and at exit
+static bool use_rt = false;             // --rt: locked memory, SCHED_FIFO, pinned threads
+static int loop_cpu = LOOP_CPU, render_cpu = RENDER_CPU;
+static uint64_t loop_faults;            // --rt: page faults when the loop started
+
+// Message lines wider than the panel scroll. Their strips are drawn at
+// startup with the screens, so showing one allocates nothing; the
+// current one is the render thread's.
+static MARQUEE marquees[MSG_COUNT];
+static bool marquee_built[MSG_COUNT];
+static MARQUEE *marquee = NULL;
+static uint64_t marquee_steps, marquee_tx_bytes;
+
+// The picture is a content layer (cached screen, marquee band) under a
+// transparent status strip with the idle countdown; render thread only
+static int content_layer, status_layer;
+static int shown_state = -1, shown_msg;
+static int status_secs;
+static char status_text[17];            // what the strip shows, per cell
+static uint64_t status_ticks, status_tx_bytes;
+
+// Main loop: what the status PIOs last showed
+static int  last_hw_state     = -1;
+static int  last_hw_msg_index = -1;
+static int  last_warn_code    = 0;
+static int  last_secs_left    = -1;
+static bool bridge_lost       = false;
+
+// Press to pixel: each FSM transition the loop observes is stamped on
+// CLOCK_MONOTONIC_RAW; the render thread stamps the moment the last byte
+// of the frame it produced has left the SPI FIFO and records the
+// difference by transition type. The pending stamp carries its target,
+// so a transition rendered over (coalesced) is not charged to another
+// frame: type + 1 in bits 63:56, the status byte in 55:48, time in 47:0.
+typedef enum {
+    LAT_IDLE_HOME, LAT_HOME_IDLE, LAT_HOME_MSG, LAT_MSG_HOME, LAT_MSG_NEXT, LAT_MSG_PREV,
+    LAT_SLEEP_IDLE, LAT_TIMEOUT, LAT_OTHER, LAT_TYPES
+} LatencyType;
+
+static const char *const latency_names[LAT_TYPES] = {
+    "IDLE->HOME", "HOME->IDLE", "HOME->MSG", "MSG->HOME", "MSG next", "MSG prev",
+    "SLEEP->IDLE", "->SLEEP", "other"
+};
 
-// NEW: graceful shutdown flag (signal-safe)
-static volatile sig_atomic_t g_shutdown = 0;
+#define LAT_TIME_MASK          ((1ull << 48) - 1)
+#define LAT_TARGET(s, i)       ((((uint64_t)(s) & 7) << 5) | ((uint64_t)(i) & FSM_STATUS_INDEX_MASK))
+
+static LATHIST latency[LAT_TYPES];      // render thread records, others LATHIST_Snapshot
+static _Atomic uint64_t latency_pending;
 
 static const char* hw_fsm_state_name(int state) {
     switch (state) {
@@ -62,63 +144,696 @@ static const char* hw_fsm_state_name(int state) {
     }
 }
 
-// NEW: signal handler for Ctrl+C, kill, etc.
-static void signal_handler(int signum) {
-    (void)signum;
-    g_shutdown = 1;
+static uint64_t raw_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static LatencyType latency_type(int from, int from_msg, int to, int to_msg) {
+    if (to == HW_FSM_SLEEP) return LAT_TIMEOUT;
+    if (from == HW_FSM_IDLE && to == HW_FSM_HOME) return LAT_IDLE_HOME;
+    if (from == HW_FSM_HOME && to == HW_FSM_IDLE) return LAT_HOME_IDLE;
+    if (from == HW_FSM_HOME && to == HW_FSM_MSG) return LAT_HOME_MSG;
+    if (from == HW_FSM_MSG && to == HW_FSM_HOME) return LAT_MSG_HOME;
+    if (from == HW_FSM_SLEEP && to == HW_FSM_IDLE) return LAT_SLEEP_IDLE;
+    if (from == HW_FSM_MSG && to == HW_FSM_MSG) {
+        if (to_msg == (from_msg + 1) % MSG_COUNT) return LAT_MSG_NEXT;
+        if (from_msg == (to_msg + 1) % MSG_COUNT) return LAT_MSG_PREV;
+    }
+    return LAT_OTHER;
+}
+
+// Render thread, once the frame for (state, msg_index) is composed
+static void latency_done(int state, int msg_index) {
+    uint64_t pending = atomic_load(&latency_pending);
+
+    if (!pending || ((pending >> 48) & 0xFF) != LAT_TARGET(state, msg_index)) return;
+    if (!atomic_compare_exchange_strong(&latency_pending, &pending, 0)) return;
+    LCD_FrameSync();            // DMA: until the channel has clocked out the last byte
+    LATHIST_Record(&latency[(pending >> 56) - 1], (raw_ns() - pending) & LAT_TIME_MASK);
+}
+
+// Event loop thread: prints consistent copies while the render thread records
+static void print_latency(void) {
+    static LATHIST copy[LAT_TYPES];
+    char line[LOG_MSG_SIZE];
+    bool any = false;
+
+    for (int t = 0; t < LAT_TYPES; t++) {
+        LATHIST_Snapshot(&latency[t], &copy[t]);
+        any |= copy[t].Count != 0;
+    }
+    if (!any) return;
+    LOG_Info("Press to pixel (FSM change seen -> last SPI byte out):");
+    for (int t = 0; t < LAT_TYPES; t++)
+        if (LATHIST_Format(&copy[t], line, sizeof(line)))
+            LOG_Info("%s", line);
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void build_screen_cache(void) {
+    idle_screen  = SCACHE_Add(IDLE_LINES);
+    home_screen  = SCACHE_Add(HOME_LINES);
+    sleep_screen = SCACHE_Add(NULL);
+    // Messages are laid out from their text: each row centered, the
+    // hand-typed padding dropped
+    for (int i = 0; i < MSG_COUNT; i++) {
+        MSG_Text(msg_text[i], i);
+        msg_screens[i] = SCACHE_AddText(msg_text[i], MSG_TEXT_FLAGS);
+    }
+    SCACHE_Build();
+}
+
+// The same screens from the pack: frames are used where they are mapped,
+// the font and logo too unless --font or --logo was given
+static bool load_pack(const char *path) {
+    static const char *const fixed[3] = { "idle", "home", "sleep" };
+    char name[PACK_NAME_LEN];
+    LCD_CANVAS c;
+
+    pack = PACK_Open(path);
+    if (!pack) return false;
+    idle_screen = 0;
+    home_screen = 1;
+    sleep_screen = 2;
+    for (int id = 0; id < 3 + MSG_COUNT; id++) {
+        if (id < 3) {
+            snprintf(name, sizeof(name), "%s", fixed[id]);
+        } else {
+            msg_screens[id - 3] = id;
+            snprintf(name, sizeof(name), "msg/%02d", id - 3);
+        }
+        if (!PACK_Canvas(pack, name, PACK_FRAME, &c) || c.Width != 128 || c.Height != 64) {
+            printf("PACK: %s has no 128x64 frame %s\n", path, name);
+            return false;
+        }
+        pack_frames[id] = c.pFrame;
+    }
+    if (!font && (font = PACK_Font(pack, "font")) != NULL)
+        LCD_SetFont(font);
+    const PACK_ENTRY *pLogo = PACK_Find(pack, "logo", PACK_IMAGE);
+    if (!logo.pFrame && pLogo && PACK_Canvas(pack, "logo", PACK_IMAGE, &logo)) {
+        logo_in_pack = true;
+        logo_x = pLogo->X;
+        logo_y = pLogo->Y;
+    }
+    return true;
+}
+
+static const uint8_t *screen_frame(int id) {
+    return pack ? pack_frames[id] : SCACHE_Frame(id);
+}
+
+// Each screen is also recorded as the SPI stream that draws it, so
+// showing it is a burst per run (or one DMA program) with no diff.
+// Main thread, before the renderer starts: recording is global.
+static void build_screen_lists(void) {
+    uint8_t frame[128 * 64 / 8];
+
+    for (int id = 0; id < 3 + MSG_COUNT; id++) {
+        memcpy(frame, screen_frame(id), sizeof(frame));
+        LCD_RecordBegin(&screen_lists[id]);
+        LCD_FrameCopy(frame);
+        LCD_RecordEnd();
+    }
+}
+
+static void free_screen_lists(void) {
+    for (int id = 0; id < 3 + MSG_COUNT; id++)
+        LCDDrv_DListFree(&screen_lists[id]);
+}
+
+// VmRSS and the anonymous part of it, in KB. Opens and reads procfs, so
+// main thread only: never from the (SCHED_FIFO) render thread.
+static void resident_kb(long *rss, long *anon) {
+    FILE *fp = fopen("/proc/self/status", "r");
+    char line[128];
+
+    *rss = *anon = -1;
+    if (!fp) return;
+    while (fgets(line, sizeof(line), fp)) {
+        sscanf(line, "VmRSS: %ld", rss);
+        sscanf(line, "RssAnon: %ld", anon);
+    }
+    fclose(fp);
+}
+
+static bool setup_layers(void) {
+    content_layer = LAYER_Add(0, 0, 128, 64, DRAW_ROP_COPY);
+    status_layer  = LAYER_Add(0, 16, 128, 16, DRAW_ROP_OR);
+    return content_layer >= 0 && status_layer >= 0;
+}
+
+// Redraws the status strip from the first character that changed: a
+// countdown tick touches only the last digit and the 's'. Message
+// screens have the strip on their blank second row; the home screen has
+// it on the last row, right of the key hint.
+static void draw_status(void) {
+    LCD_CANVAS *pStrip = LAYER_Canvas(status_layer);
+    FONT_TABLE *pFont = LCD_GetFont();
+    int first = 0, x;
+    char text[32];
+
+    if (shown_state == HW_FSM_MSG)
+        snprintf(text, sizeof(text), " Msg %2d/%-2d   %2ds", shown_msg + 1, MSG_COUNT, status_secs);
+    else
+        snprintf(text, sizeof(text), "%15ds", status_secs);
+    while (first < 16 && text[first] == status_text[first]) first++;
+    if (first == 16) return;
+    memcpy(status_text, text, 16);
+    text[first] = '\0';
+    x = DRAW_TextWidth(text, pFont);
+    text[first] = status_text[first];
+    // A glyph cell can be wider than its advance, so everything right of
+    // the change is drawn again
+    DRAW_FillRect(pStrip, x, 0, pStrip->Width - 1, pStrip->Height - 1, 0);
+    DRAW_PrintString(pStrip, x, 0, text + first, 1, pFont);
+    LAYER_Dirty(status_layer, x, 0, pStrip->Width - 1, pStrip->Height - 1);
+}
+
+// Places (or hides) the strip for the screen being shown and redraws it
+static void place_status(void) {
+    LCD_CANVAS *pStrip = LAYER_Canvas(status_layer);
+    bool show = shown_state == HW_FSM_HOME || shown_state == HW_FSM_MSG;
+
+    LAYER_Show(status_layer, show);
+    if (!show) return;
+    LAYER_Move(status_layer, 0, shown_state == HW_FSM_MSG ? 16 : 48);
+    memset(pStrip->pFrame, 0, pStrip->FrameSize);
+    memset(status_text, 0, sizeof(status_text));
+    LAYER_DirtyAll(status_layer);
+    draw_status();
+}
+
+// Render thread: a new countdown value only recomposes the changed cells
+static void render_status(int secs_left, void *ctx) {
+    uint64_t tx_start = LCDHW_TxBytes();
+
+    (void)ctx;
+    status_secs = secs_left;
+    if (shown_state != HW_FSM_HOME && shown_state != HW_FSM_MSG) return;
+    draw_status();
+    LAYER_Compose();
+    status_ticks++;
+    status_tx_bytes += LCDHW_TxBytes() - tx_start;
+}
+
+// A row marquee on the first laid-out row of a message that does not fit
+static bool build_marquee(int msg_index) {
+    const TEXT_LAYOUT *pLayout;
+    char row[sizeof(msg_text[0])];
+
+    if (pack) {
+        const char *text;
+        int y;
+
+        snprintf(row, sizeof(row), "marquee/%02d", msg_index);
+        text = PACK_Text(pack, row, NULL, &y);
+        return text && MARQUEE_InitRow(&marquees[msg_index], NULL, y, text, LCD_GetFont());
+    }
+    pLayout = SCACHE_Layout(msg_screens[msg_index]);
+    if (!pLayout || !pLayout->bOverflow) return false;
+    for (int l = 0; l < pLayout->nLines; l++) {
+        const TEXT_LINE *pLine = &pLayout->Lines[l];
+
+        if (pLine->Width <= 128) continue;
+        snprintf(row, sizeof(row), "%.*s", pLine->Len, msg_text[msg_index] + pLine->Start);
+        return MARQUEE_InitRow(&marquees[msg_index], NULL, pLine->Y, row, LCD_GetFont());
+    }
+    return false;
+}
+
+static void build_marquees(void) {
+    for (int i = 0; i < MSG_COUNT; i++)
+        marquee_built[i] = build_marquee(i);
+}
+
+static void free_marquees(void) {
+    marquee = NULL;
+    for (int i = 0; i < MSG_COUNT; i++) {
+        if (marquee_built[i])
+            MARQUEE_Free(&marquees[i]);
+        marquee_built[i] = false;
+    }
+}
+
+// Every visit scrolls from the start
+static void start_marquee(int msg_index) {
+    if (!marquee_built[msg_index]) return;
+    marquee = &marquees[msg_index];
+    marquee->Pos = 0;
+    marquee->Scrolled = 0;
+}
+
+static void stop_marquee(void) {
+    marquee = NULL;
+}
+
+// Render thread tick: one marquee step while the screen has one
+static bool tick_marquee(void *ctx) {
+    uint64_t tx_start = LCDHW_TxBytes();
+
+    (void)ctx;
+    if (!marquee) return false;
+    MARQUEE_Draw(marquee, 1, LAYER_Canvas(content_layer));
+    LAYER_Dirty(content_layer, 0, marquee->Y, 127, marquee->Y + marquee->Strip.Height - 1);
+    LAYER_Compose();
+    marquee_steps++;
+    marquee_tx_bytes += LCDHW_TxBytes() - tx_start;
+    return true;
+}
+
+static void show_content(const uint8_t *pFrame) {
+    memcpy(LAYER_Canvas(content_layer)->pFrame, pFrame, LAYER_Canvas(content_layer)->FrameSize);
+    LAYER_DirtyAll(content_layer);
+}
+
+// Replays the screen's list, which leaves the shadow holding the screen,
+// so the compose after it sends only the overlay. A list that no longer
+// matches the screen (a cache entry rebuilt for a new font) is skipped
+// and the compose sends the diff instead.
+static void show_screen(int id) {
+    const uint8_t *pFrame = screen_frame(id);
+    const LCDDRV_DLIST *pList = &screen_lists[id];
+
+    if (pList->pFrame && memcmp(pList->pFrame, pFrame, LAYER_Canvas(content_layer)->FrameSize) == 0)
+        LCD_Replay(pList);
+    show_content(pFrame);
+}
+
+// Runs on the render thread: everything that touches the panel lives here
+static void render_screen(int state, int msg_index, void *ctx) {
+    static const char *const error_lines[4] = { NULL, "  FSM ERROR STATE ", NULL, NULL };
+    uint64_t tx_start = LCDHW_TxBytes();
+    LCD_CANVAS *pContent = LAYER_Canvas(content_layer);
+
+    (void)ctx;
+    stop_marquee();
+    if (state != HW_FSM_SLEEP && !backlight_on) {
+        LCDHW_BackLight(true);
+        backlight_on = true;
+    }
+
+    switch (state) {
+        case HW_FSM_INIT:
+        case HW_FSM_IDLE:
+            if (logo.pFrame) {
+                memset(pContent->pFrame, 0, pContent->FrameSize);
+                DRAW_BitBlt(pContent, logo_x, logo_y, &logo, 0, 0, logo.Width, logo.Height, DRAW_ROP_COPY);
+                LAYER_DirtyAll(content_layer);
+            } else {
+                show_screen(idle_screen);
+            }
+            break;
+
+        case HW_FSM_HOME:
+            show_screen(home_screen);
+            break;
+
+        case HW_FSM_MSG:
+            if (msg_index >= MSG_COUNT) msg_index = 0;
+            show_screen(msg_screens[msg_index]);
+            start_marquee(msg_index);
+            break;
+
+        case HW_FSM_SLEEP:
+            show_screen(sleep_screen);
+            if (backlight_on) { LCDHW_BackLight(false); backlight_on = false; }
+            break;
+
+        default:
+            memset(pContent->pFrame, 0, pContent->FrameSize);
+            for (int l = 0; l < 4; l++)
+                if (error_lines[l])
+                    DRAW_PrintString(pContent, 0, l * 16, (char *)error_lines[l], 1, LCD_GetFont());
+            LAYER_DirtyAll(content_layer);
+            break;
+    }
+    shown_state = state;
+    shown_msg = msg_index;
+    place_status();
+    LAYER_Compose();
+    latency_done(state, msg_index);
+    LOG_Info("  screen %s: %llu SPI bytes", hw_fsm_state_name(state),
+             (unsigned long long)(LCDHW_TxBytes() - tx_start));
+    if (start_us) {
+        LOG_Info("  first frame %.2f ms after start (%s)", (now_us() - start_us) / 1e3,
+                 pack ? "asset pack" : "compiled in");
+        start_us = 0;
+    }
+}
+
+// Wakeups, timer jitter and CPU time of the event loop since it started
+static void print_loop_stats(void) {
+    EVLOOP_TIMER_STATS timers[EVLOOP_MAX_SOURCES];
+    STATWAIT_STATS waits;
+    struct rusage usage;
+    double secs = (now_us() - loop_start_us) / 1e6, cpu;
+    int n;
+
+    STATWAIT_GetStats(&waits);
+    if (waits.Wakeups)
+        LOG_Info("Status wait (%s): %llu wakeups in %.1f s (%.1f/s)", STATWAIT_Name(),
+                 (unsigned long long)waits.Wakeups, secs, waits.Wakeups / secs);
+    getrusage(RUSAGE_SELF, &usage);
+    cpu = usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+    LOG_Info("Event loop: %llu wakeups in %.1f s (%.1f/s), CPU %.2f s (%.1f%%)",
+             (unsigned long long)EVLOOP_Wakeups(), secs, EVLOOP_Wakeups() / secs, cpu, 100.0 * cpu / secs);
+    n = EVLOOP_GetTimerStats(timers, EVLOOP_MAX_SOURCES);
+    for (int i = 0; i < n; i++)
+        if (timers[i].Fired)
+            LOG_Info("  timer %-12s %6u us: %llu fired, %llu missed, late mean %.1f us, max %.1f us",
+                     timers[i].pName, timers[i].PeriodUs, (unsigned long long)timers[i].Fired,
+                     (unsigned long long)timers[i].Missed, timers[i].LateSumNs / 1e3 / timers[i].Fired,
+                     timers[i].LateMaxNs / 1e3);
 }
 
 // NEW: centralized cleanup so every exit path releases resources
 static void cleanup(void) {
+    RENDER_STATS stats;
+    SCACHE_STATS cache;
+    LOG_STATS log;
+
+    uint64_t faults = RT_PageFaults() - loop_faults;
+
+    RENDER_Stop();              // finishes the frame in progress
+    LOG_Stop();                 // what the loop logged, then the rest in order
+    if (use_rt && loop_start_us)
+        LOG_Info("RT: %llu page faults while running", (unsigned long long)faults);
+    if (loop_start_us && !use_emu)   // virtual time on the emulator
+        print_loop_stats();
+    print_latency();
+    if (trace_path && TRACE_Dump(trace_path))
+        LOG_Info("Trace -> %s", trace_path);
+    EVLOOP_Close();
+    STATWAIT_Close();
+    RENDER_GetStats(&stats);
+    if (stats.Posted)
+        LOG_Info("Render: %llu targets, %llu rendered, %llu coalesced, max %llu us",
+                 (unsigned long long)stats.Posted, (unsigned long long)stats.Rendered,
+                 (unsigned long long)(stats.Posted - stats.Rendered),
+                 (unsigned long long)stats.MaxRenderUs);
+    if (marquee_steps)
+        LOG_Info("Marquee: %llu steps, %.1f SPI bytes per step", (unsigned long long)marquee_steps,
+                 (double)marquee_tx_bytes / marquee_steps);
+    if (status_ticks)
+        LOG_Info("Status: %llu countdown updates, %.1f SPI bytes per update", (unsigned long long)status_ticks,
+                 (double)status_tx_bytes / status_ticks);
+    free_marquees();
+    SCACHE_GetStats(&cache);
+    if (cache.Screens)
+        LOG_Info("Screen cache: %llu hits, %llu misses, %llu rebuilds (built in %.2f ms)",
+                 (unsigned long long)cache.Hits, (unsigned long long)cache.Misses,
+                 (unsigned long long)cache.Rebuilds, cache.BuildMs);
     // Try to leave LCD in a sane state
-    if (virtual_base != MAP_FAILED) {
+    if (HPSREG_IsOpen()) {
         LCDHW_BackLight(false);
         LCD_GraphicClear();
-        munmap(virtual_base, HW_REGS_SPAN);
-        virtual_base = MAP_FAILED;
-    }
-    if (fd >= 0) {
-        close(fd);
-        fd = -1;
+        LCD_SetDmaMode(false);    // waits for a queued frame, restores SPIM0
+        LCDHW_Close();
+        HPSREG_Close();
     }
+    SCACHE_Free();
+    free_screen_lists();
+    LAYER_Free();
+    LCD_SetFont(NULL);
+    FONT_Unload(font);
+    font = NULL;
+    if (!logo_in_pack)
+        IMAGE_Free(&logo);
+    PACK_Close(pack);
+    pack = NULL;
+    LOG_GetStats(&log);
+    if (log.MaxDepth)
+        LOG_Info("Log: %llu lines, %llu dropped on a full queue (at most %u of %d waiting), %llu rate limited",
+                 (unsigned long long)log.Written, (unsigned long long)log.Dropped, log.MaxDepth,
+                 LOG_QUEUE_SIZE, (unsigned long long)log.Suppressed);
+    LOG_Close();
     printf("\nClean shutdown complete.\n");
 }
 
-int main(void) {
-    // NEW: install signal handlers BEFORE opening hardware
-    signal(SIGINT,  signal_handler);
-    signal(SIGTERM, signal_handler);
+// Save what the emulated panel shows as PREFIX_NNN.pbm
+static void dump_panel(void) {
+    char path[256];
 
-    printf("Opening /dev/mem...\n");
-    fd = open("/dev/mem", O_RDWR | O_SYNC);
-    if (fd < 0) {
-        perror("ERROR: Cannot open /dev/mem");
-        return 1;
+    if (!use_emu || !pbm_prefix) return;
+    LCD_FrameSync();
+    snprintf(path, sizeof(path), "%s_%03d.pbm", pbm_prefix, pbm_count++);
+    if (EMU_DumpPbm(path))
+        LOG_Info("  panel -> %s", path);
+}
+
+// Reads both status PIOs and posts what changed to the renderer: the body
+// of the old poll loop, now run on every status wakeup
+static void on_status(void) {
+    uint32_t fsm_status   = HPSREG_Read32(fsm_status_offset);
+    uint32_t timer_status = HPSREG_Read32(timer_status_offset);
+
+    TRACE_Record(TRACE_REG_SAMPLE, (uint16_t)fsm_status, timer_status);
+
+    int  hw_fsm_state = FSM_STATE_FROM_REG(fsm_status);
+    int  hw_msg_index = FSM_INDEX_FROM_REG(fsm_status);
+    bool timeout      = timer_status & 1;
+    int  secs_left    = (timer_status >> 1) & 0x0F;
+
+    // FIXED: only warn on persistent inconsistency (not on transitions).
+    // We require the inconsistency to coincide with a state change,
+    // so single-cycle transients during button-wake are ignored.
+    bool state_changed = (hw_fsm_state != last_hw_state);
+
+    if (state_changed && hw_fsm_state == HW_FSM_MSG &&
+        hw_msg_index >= MSG_COUNT) {
+        if (last_warn_code != 2) {
+            LOG_Warn("FSM=MSG with out-of-range msg_index=%d", hw_msg_index);
+            last_warn_code = 2;
+        }
+    } else if (!state_changed) {
+        last_warn_code = 0;
+    }
+    // REMOVED: the "FSM=SLEEP but timeout=0" warning — it fires
+    // legitimately during the SLEEP→IDLE wake transition.
+
+    if (state_changed ||
+        (hw_fsm_state == HW_FSM_MSG && hw_msg_index != last_hw_msg_index)) {
+
+        LOG_Info("HW FSM: %s(%d), msg_idx=%d, secs_left=%d, timeout=%d",
+                 hw_fsm_state_name(hw_fsm_state), hw_fsm_state,
+                 hw_msg_index, secs_left, timeout ? 1 : 0);
+
+        // FIXED: latch the error so it doesn't print every loop
+        if (hw_fsm_state > HW_FSM_SLEEP && last_warn_code != 3) {
+            LOG_Warn("Unknown FSM state value=%d", hw_fsm_state);
+            last_warn_code = 3;
+        }
+
+        TRACE_Record(TRACE_TRANSITION, (uint16_t)LAT_TARGET(hw_fsm_state, hw_msg_index),
+                     last_hw_state < 0 ? 0xFFFFFFFFu : (uint32_t)LAT_TARGET(last_hw_state, last_hw_msg_index));
+        if (last_hw_state >= 0)
+            atomic_store(&latency_pending,
+                         (uint64_t)(latency_type(last_hw_state, last_hw_msg_index, hw_fsm_state, hw_msg_index) + 1) << 56 |
+                         LAT_TARGET(hw_fsm_state, hw_msg_index) << 48 | (raw_ns() & LAT_TIME_MASK));
+        RENDER_Post(hw_fsm_state, hw_msg_index);
+
+        last_hw_state     = hw_fsm_state;
+        last_hw_msg_index = hw_msg_index;
+        dump_panel();
+    }
+
+    // The countdown strip follows the timer, after any screen posted above
+    if (secs_left != last_secs_left) {
+        RENDER_PostStatus(secs_left);
+        last_secs_left = secs_left;
+    }
+}
+
+// Emulator: the loop's idle handler. Reads the status like an interrupt
+// would, then advances the virtual clock one poll period and plays the
+// --keys script: '0'-'3' press that KEY, any other character just lets a
+// second pass. The app exits a second after the last step so its screen
+// gets drawn.
+static void emu_step(void *ctx) {
+    (void)ctx;
+    on_status();
+    RENDER_Pump(EMU_NowNs() / 1000u);
+    EMU_AdvanceNs(POLL_PERIOD_US * 1000ull);
+    if (emu_keys && EMU_NowNs() >= emu_next_key_ns) {
+        char key = *emu_keys++;
+        if (key == '\0') {
+            EVLOOP_Stop();
+            return;
+        }
+        if (key >= '0' && key <= '3')
+            EMU_PressKey(key - '0');
+        emu_next_key_ns += EMU_KEY_PERIOD_NS;
+    }
+}
+
+// A status PIO interrupt (--irq): acknowledge it, then read what changed
+static void on_status_irq(int fd, uint32_t events, void *ctx) {
+    (void)events;
+    (void)ctx;
+    if (STATWAIT_Ack(fd))
+        on_status();
+}
+
+static void on_status_poll(void *ctx) {
+    (void)ctx;
+    on_status();
+}
+
+// Inline rendering (no render thread): marquee steps come from this timer
+static void on_render_pump(void *ctx) {
+    (void)ctx;
+    RENDER_Pump(now_us());
+}
+
+// NEW: the bridge check at startup, repeated while running: a bridge
+// that went away reads all ones
+static void on_bridge_probe(void *ctx) {
+    bool lost = HPSREG_Read32(fsm_status_offset) == 0xFFFFFFFFu;
+
+    (void)ctx;
+    if (lost && !bridge_lost)
+        LOG_Warn("FPGA bridge returned 0xFFFFFFFF; status is not being updated");
+    bridge_lost = lost;
+}
+
+static void on_signal(int signo, void *ctx) {
+    (void)ctx;
+    if (signo == SIGUSR1) {
+        print_loop_stats();
+        print_latency();
+    } else if (signo == SIGUSR2) {
+        if (TRACE_Dump(trace_path))
+            LOG_Info("Trace -> %s", trace_path);
     }
+    else
+        EVLOOP_Stop();
+}
 
-    printf("Memory mapping...\n");
-    virtual_base = mmap(NULL, HW_REGS_SPAN, PROT_READ | PROT_WRITE,
-                       MAP_SHARED, fd, HW_REGS_BASE);
-    if (virtual_base == MAP_FAILED) {
-        perror("ERROR: mmap failed");
-        close(fd);
+int main(int argc, char **argv) {
+    bool use_dma = false;
+    const char *spidev_path = NULL;
+    const char *gpiochip_path = NULL;
+    const char *font_path = NULL;
+    const char *logo_path = NULL;
+    const char *pack_path = NULL;
+    const char *irq_path = NULL;
+    const char *log_dest = NULL;
+    int rt_test_secs = 0;
+
+    start_us = now_us();
+    for (int t = 0; t < LAT_TYPES; t++)
+        LATHIST_Init(&latency[t], latency_names[t]);
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dma") == 0) {
+            use_dma = true;
+        } else if (strcmp(argv[i], "--spidev") == 0 && i + 1 < argc) {
+            spidev_path = argv[++i];
+        } else if (strcmp(argv[i], "--gpiochip") == 0 && i + 1 < argc) {
+            gpiochip_path = argv[++i];
+        } else if (strcmp(argv[i], "--emu") == 0) {
+            use_emu = true;
+        } else if (strcmp(argv[i], "--keys") == 0 && i + 1 < argc) {
+            emu_keys = argv[++i];
+        } else if (strcmp(argv[i], "--pbm") == 0 && i + 1 < argc) {
+            pbm_prefix = argv[++i];
+        } else if (strcmp(argv[i], "--font") == 0 && i + 1 < argc) {
+            font_path = argv[++i];
+        } else if (strcmp(argv[i], "--logo") == 0 && i + 1 < argc) {
+            logo_path = argv[++i];
+        } else if (strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            pack_path = argv[++i];
+        } else if (strcmp(argv[i], "--irq") == 0 && i + 1 < argc) {
+            irq_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--log") == 0 && i + 1 < argc) {
+            log_dest = argv[++i];
+        } else if (strcmp(argv[i], "--quiet") == 0) {
+            LOG_SetLevel(LOG_LEVEL_WARN);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            LOG_SetLevel(LOG_LEVEL_DEBUG);
+        } else if (strcmp(argv[i], "--rt") == 0) {
+            use_rt = true;
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc &&
+                   sscanf(argv[i + 1], "%d,%d", &loop_cpu, &render_cpu) == 2) {
+            i++;
+        } else if (strcmp(argv[i], "--rt-test") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0) {
+            rt_test_secs = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--dma | --spidev /dev/spidevB.C [--gpiochip /dev/gpiochipN]] [--irq /dev/uioF,/dev/uioT]\n"
+                            "           [--font FILE.fnt] [--logo FILE.pbm] [--pack FILE.pak] [--trace FILE]\n"
+                            "           [--log FILE|syslog] [--quiet | --verbose] [--rt] [--cpus LOOP,RENDER]\n"
+                            "       %s --emu [--dma] [--keys SCRIPT] [--pbm PREFIX] [--font FILE.fnt] [--logo FILE.pbm] [--pack FILE.pak]\n"
+                            "           [--trace FILE] [--log FILE|syslog] [--quiet | --verbose] [--rt]\n"
+                            "       %s --rt-test SECONDS [--cpus LOOP,RENDER]\n",
+                    argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if ((emu_keys || pbm_prefix) && !use_emu) {
+        fprintf(stderr, "--keys and --pbm need --emu\n");
+        return 1;
+    }
+    if (use_emu && (spidev_path || irq_path)) {
+        fprintf(stderr, "--emu cannot be combined with --spidev or --irq\n");
         return 1;
     }
-    printf("  virtual_base = %p\n", virtual_base);
+    if (log_dest && !LOG_Open(strcmp(log_dest, "syslog") == 0 ? LOG_TO_SYSLOG : LOG_TO_FILE, log_dest))
+        return 1;
+    if (rt_test_secs)
+        return RT_SelfTest(rt_test_secs, loop_cpu) ? 0 : 1;
+
+    // Real-time mode: lock everything before the first thread or mapping,
+    // so all of it is resident and stays so
+    if (use_rt && !RT_LockMemory())
+        printf("RT: running with unlocked memory\n");
+
+    // External font: mapped read-only, pages come in as glyphs are drawn
+    if (font_path) {
+        font = FONT_Load(font_path);
+        if (!font)
+            return 1;
+        LCD_SetFont(font);
+    }
+
+    // Idle logo: converted to page format once, blitted on every IDLE entry
+    if (logo_path) {
+        if (!IMAGE_LoadPbm(logo_path, &logo)) {
+            FONT_Unload(font);
+            return 1;
+        }
+        printf("Logo %s: %dx%d, imported with the %s kernel\n", logo_path, logo.Width, logo.Height,
+               IMAGE_KernelName(IMAGE_GetKernel()));
+        logo_x = (128 - logo.Width) / 2;
+        logo_y = (64 - logo.Height) / 2;
+    }
 
-    // Map register pointers
-    button_addr       = (uint32_t *)((char*)virtual_base +
-        ((ALT_LWFPGASLVS_OFST + BUTTON_PIO_BASE)       & HW_REGS_MASK));
-    fsm_status_addr   = (uint32_t *)((char*)virtual_base +
-        ((ALT_LWFPGASLVS_OFST + FSM_STATUS_PIO_BASE)   & HW_REGS_MASK));
-    timer_status_addr = (uint32_t *)((char*)virtual_base +
-        ((ALT_LWFPGASLVS_OFST + TIMER_STATUS_PIO_BASE) & HW_REGS_MASK));
-    printf("  button_addr       = %p\n", (void*)button_addr);
-    printf("  fsm_status_addr   = %p\n", (void*)fsm_status_addr);
-    printf("  timer_status_addr = %p\n", (void*)timer_status_addr);
+    // NEW: take over signals BEFORE opening hardware. They are blocked from
+    // here on (and in the render thread) and arrive through the loop:
+    // SIGINT/SIGTERM stop it, SIGUSR1 prints its statistics, SIGUSR2 dumps
+    // the trace ring (--trace).
+    if (!EVLOOP_Init())
+        return 1;
+    EVLOOP_AddSignal(SIGINT,  on_signal, NULL);
+    EVLOOP_AddSignal(SIGTERM, on_signal, NULL);
+    EVLOOP_AddSignal(SIGUSR1, on_signal, NULL);
+    if (trace_path)
+        EVLOOP_AddSignal(SIGUSR2, on_signal, NULL);
+
+    if (!HPSREG_Open(use_emu ? &HPSREG_Emu : &HPSREG_DevMem))
+        return 1;
 
     // NEW: bridge sanity check — if all 0xFFFFFFFF, the FPGA is not responding
-    uint32_t probe = *fsm_status_addr;
+    uint32_t probe = HPSREG_Read32(fsm_status_offset);
     if (probe == 0xFFFFFFFFu) {
         fprintf(stderr, "ERROR: FPGA bridge returned 0xFFFFFFFF. "
                         "Is the .rbf programmed and Qsys addresses correct?\n");
@@ -127,109 +842,98 @@ int main(void) {
     }
 
     printf("Initializing LCD...\n");
-    LCDHW_Init(virtual_base);
+    if (spidev_path) {
+        // Kernel SPI driver moves the bytes; the mapping is still used for the PIOs
+        if (!LCDHW_InitSpidev(spidev_path, gpiochip_path)) {
+            cleanup();
+            return 3;
+        }
+    } else {
+        LCDHW_Init();
+    }
     LCD_Init();
+    // DMA mode: frames stream out while this loop keeps sampling the PIOs
+    if (use_dma && !LCD_SetDmaMode(true))
+        printf("DMA unavailable, using PIO frame transfers.\n");
+    uint64_t screens_us = now_us();
+    if (pack_path) {
+        if (!load_pack(pack_path)) {
+            cleanup();
+            return 4;
+        }
+    } else {
+        build_screen_cache();
+    }
+    build_screen_lists();
+    build_marquees();
+    printf("Screens ready in %.3f ms (%s)\n", (now_us() - screens_us) / 1e3, pack ? "asset pack" : "compiled in");
+    if (!setup_layers()) {
+        cleanup();
+        return 4;
+    }
     LCD_GraphicClear();
     LCDHW_BackLight(true);
     printf("LCD Ready.\n");
 
-    int  last_hw_state     = -1;
-    int  last_hw_msg_index = -1;
-    bool backlight_on      = true;
-    int  last_warn_code    = 0;
+    // The emulator is single-threaded, so there the renderer runs inline
+    RENDER_SetTick(tick_marquee, MARQUEE_PERIOD_US);
+    RENDER_SetStatus(render_status);
+    if (RENDER_Start(render_screen, NULL, render_cpu, !use_emu))
+        render_threaded = !use_emu;
+    else
+        RENDER_Start(render_screen, NULL, -1, false);
+
+    // Status changes: edge-capture interrupts through UIO, or the 5 ms poll
+    if (!use_emu && !STATWAIT_Open(irq_path ? &STATWAIT_Uio : &STATWAIT_Poll, irq_path)) {
+        cleanup();
+        return 5;
+    }
+
+    // Status changes: the PIO interrupts' descriptors, or the 5 ms poll as
+    // a timer. The emulator has no descriptors and steps its virtual clock
+    // whenever nothing else is ready.
+    if (use_emu) {
+        EVLOOP_SetIdle(emu_step, NULL);
+    } else {
+        int fds[STATWAIT_MAX_FDS];
+        int n = STATWAIT_Fds(fds);
+
+        for (int i = 0; i < n; i++)
+            EVLOOP_AddFd(fds[i], EPOLLIN, on_status_irq, NULL);
+        if (n == 0)
+            EVLOOP_AddTimer("status-poll", POLL_PERIOD_US, on_status_poll, NULL);
+        if (!render_threaded)
+            EVLOOP_AddTimer("render-pump", MARQUEE_PERIOD_US, on_render_pump, NULL);
+        EVLOOP_AddTimer("bridge-probe", PROBE_PERIOD_US, on_bridge_probe, NULL);
+    }
 
     printf("\n=== LCD MESSAGE SYSTEM STARTED ===\n");
     printf("Using FPGA hardware debouncing + idle timer.\n");
     printf("Press Ctrl+C to exit cleanly.\n\n");
 
     // === MAIN LOOP ===
-    while (!g_shutdown) {                          // CHANGED: was while(1)
-        uint32_t fsm_status   = *fsm_status_addr;
-        uint32_t timer_status = *timer_status_addr;
-
-        int  hw_fsm_state = FSM_STATE_FROM_REG(fsm_status);
-        int  hw_msg_index = FSM_INDEX_FROM_REG(fsm_status);
-        bool timeout      = timer_status & 1;
-        int  secs_left    = (timer_status >> 1) & 0x0F;
-
-        // FIXED: only warn on persistent inconsistency (not on transitions).
-        // We require the inconsistency to coincide with a state change,
-        // so single-cycle transients during button-wake are ignored.
-        bool state_changed = (hw_fsm_state != last_hw_state);
-
-        if (state_changed && hw_fsm_state == HW_FSM_MSG &&
-            hw_msg_index >= MSG_COUNT) {
-            if (last_warn_code != 2) {
-                printf("[WARN] FSM=MSG with out-of-range msg_index=%d\n", hw_msg_index);
-                last_warn_code = 2;
-            }
-        } else if (!state_changed) {
-            last_warn_code = 0;
-        }
-        // REMOVED: the "FSM=SLEEP but timeout=0" warning — it fires
-        // legitimately during the SLEEP→IDLE wake transition.
-
-        if (state_changed ||
-            (hw_fsm_state == HW_FSM_MSG && hw_msg_index != last_hw_msg_index)) {
-
-            printf("HW FSM: %s(%d), msg_idx=%d, secs_left=%d, timeout=%d\n",
-                   hw_fsm_state_name(hw_fsm_state), hw_fsm_state,
-                   hw_msg_index, secs_left, timeout ? 1 : 0);
-
-            switch (hw_fsm_state) {
-                case HW_FSM_INIT:
-                case HW_FSM_IDLE:
-                    if (!backlight_on) { LCDHW_BackLight(true); backlight_on = true; }
-                    LCD_GraphicClear();
-                    LCD_TextOut(0, 0,  "==================");
-                    LCD_TextOut(0, 16, "  DE10-Standard   ");
-                    LCD_TextOut(0, 32, "   LCD Message    ");
-                    LCD_TextOut(0, 48, "  Press Any Key   ");
-                    break;
-
-                case HW_FSM_HOME:
-                    if (!backlight_on) { LCDHW_BackLight(true); backlight_on = true; }
-                    LCD_GraphicClear();
-                    LCD_TextOut(0, 0,  "==================");
-                    LCD_TextOut(0, 16, "  Welcome User!   ");
-                    LCD_TextOut(0, 32, " KEY1/KEY2: Msgs  ");
-                    LCD_TextOut(0, 48, " KEY0: Back       ");
-                    break;
-
-                case HW_FSM_MSG: {
-                    int safe_idx = (hw_msg_index < MSG_COUNT) ? hw_msg_index : 0;
-                    if (!backlight_on) { LCDHW_BackLight(true); backlight_on = true; }
-                    LCD_GraphicClear();
-                    LCD_TextOut(0, 0,  (char*)MSG_LIST[safe_idx][0]);
-                    LCD_TextOut(0, 16, (char*)MSG_LIST[safe_idx][1]);
-                    LCD_TextOut(0, 32, (char*)MSG_LIST[safe_idx][2]);
-                    LCD_TextOut(0, 48, (char*)MSG_LIST[safe_idx][3]);
-                    break;
-                }
-
-                case HW_FSM_SLEEP:
-                    LCD_GraphicClear();
-                    if (backlight_on) { LCDHW_BackLight(false); backlight_on = false; }
-                    break;
-
-                default:
-                    if (!backlight_on) { LCDHW_BackLight(true); backlight_on = true; }
-                    LCD_GraphicClear();
-                    LCD_TextOut(0, 16, "  FSM ERROR STATE ");
-                    // FIXED: latch the error so it doesn't redraw every loop
-                    if (last_warn_code != 3) {
-                        printf("[WARN] Unknown FSM state value=%d\n", hw_fsm_state);
-                        last_warn_code = 3;
-                    }
-                    break;
-            }
-
-            last_hw_state     = hw_fsm_state;
-            last_hw_msg_index = hw_msg_index;
-        }
-
-        usleep(5000);  // 5ms poll — meets latency budget after FPGA debounce reduction
+    // From here on log lines are queued and written by a thread of their
+    // own, so a slow console never holds up the loop or the renderer
+    LOG_Start();
+    // The emulator loop never sleeps, so there --rt only locks memory
+    if (use_rt && !use_emu) {
+        if (render_threaded)
+            RENDER_SetPriority(RT_RENDER_PRIO);
+        if (RT_SetThread(pthread_self(), RT_LOOP_PRIO, loop_cpu))
+            LOG_Info("RT: event loop at SCHED_FIFO %d on CPU%d", RT_LOOP_PRIO, loop_cpu);
     }
+    if (!use_emu)
+        on_status();        // the state before the first change
+    // Resident memory once the first frame is posted (board) or the
+    // screens are ready (emulator). Sampled here, before the fault count
+    // starts, so the procfs read is in neither the render thread nor the
+    // "while running" figure
+    long rss, anon;
+    resident_kb(&rss, &anon);
+    LOG_Info("Resident %ld KB, %ld KB anonymous (%s)", rss, anon, pack ? "asset pack" : "compiled in");
+    loop_faults = RT_PageFaults();
+    loop_start_us = now_us();
+    EVLOOP_Run();
 
     cleanup();         // NEW: always release resources
     return 0;
@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "marquee.h"
+#include "LCD_Lib.h"
+#include "log.h"
+
+#define PANEL_WIDTH     128
+#define PANEL_HEIGHT    64
+#define FRAME_BYTES     (PANEL_WIDTH * PANEL_HEIGHT / 8)
+
+static bool StripAlloc(LCD_CANVAS *pStrip, int Width, int Height) {
+    pStrip->Width = Width;
+    pStrip->Height = Height;
+    pStrip->FrameSize = Width * ((Height + 7) / 8);
+    pStrip->pFrame = calloc(1, pStrip->FrameSize);
+    if (!pStrip->pFrame) {
+        LOG_Error("MARQUEE: no memory for a %dx%d strip", Width, Height);
+        return false;
+    }
+    return true;
+}
+
+bool MARQUEE_InitRow(MARQUEE *pMarquee, const uint8_t *pBase, int Y, const char *pText, FONT_TABLE *pFont) {
+    int Width = DRAW_TextWidth(pText, pFont);
+
+    memset(pMarquee, 0, sizeof(*pMarquee));
+    if (Width < pFont->CellWidth) Width = pFont->CellWidth;
+    if (!StripAlloc(&pMarquee->Strip, Width + MARQUEE_GAP, pFont->CellHeight))
+        return false;
+    DRAW_PrintString(&pMarquee->Strip, 0, 0, (char *)pText, 1, pFont);
+    // The last glyph's cell may run into the gap; the gap stays blank
+    DRAW_FillRect(&pMarquee->Strip, Width, 0, pMarquee->Strip.Width - 1, pMarquee->Strip.Height - 1, 0);
+    if (pBase)
+        memcpy(pMarquee->Frame, pBase, FRAME_BYTES);
+    pMarquee->Y = Y;
+    return true;
+}
+
+bool MARQUEE_InitLines(MARQUEE *pMarquee, const char *const *pLines, int nLines, FONT_TABLE *pFont) {
+    int Height = nLines * pFont->CellHeight;
+
+    memset(pMarquee, 0, sizeof(*pMarquee));
+    // Content shorter than the panel still scrolls through a full window
+    Height = Height > PANEL_HEIGHT ? Height + MARQUEE_GAP : PANEL_HEIGHT;
+    if (!StripAlloc(&pMarquee->Strip, PANEL_WIDTH, Height))
+        return false;
+    for (int i = 0; i < nLines; i++) {
+        if (pLines[i])
+            DRAW_PrintString(&pMarquee->Strip, 0, i * pFont->CellHeight, (char *)pLines[i], 1, pFont);
+    }
+    pMarquee->bVertical = true;
+    return true;
+}
+
+// Copies the strip window starting at Pos into the panel-sized canvas,
+// wrapping around the end of the strip
+static void Window(const MARQUEE *pMarquee, LCD_CANVAS *pFrame) {
+    const LCD_CANVAS *pStrip = &pMarquee->Strip;
+    int n;
+
+    if (pMarquee->bVertical) {
+        for (int y = 0, Src = pMarquee->Pos; y < PANEL_HEIGHT; y += n, Src = 0) {
+            n = pStrip->Height - Src;
+            DRAW_BitBlt(pFrame, 0, y, pStrip, 0, Src, PANEL_WIDTH, n, DRAW_ROP_COPY);
+        }
+    } else {
+        for (int x = 0, Src = pMarquee->Pos; x < PANEL_WIDTH; x += n, Src = 0) {
+            n = pStrip->Width - Src;
+            DRAW_BitBlt(pFrame, x, pMarquee->Y, pStrip, Src, 0, n, pStrip->Height, DRAW_ROP_COPY);
+        }
+    }
+}
+
+void MARQUEE_Draw(MARQUEE *pMarquee, int Pixels, LCD_CANVAS *pFrame) {
+    int Length = pMarquee->bVertical ? pMarquee->Strip.Height : pMarquee->Strip.Width;
+
+    if (!pMarquee->Strip.pFrame) return;
+    pMarquee->Pos = (pMarquee->Pos + Pixels) % Length;
+    pMarquee->Scrolled += Pixels;
+    Window(pMarquee, pFrame);
+}
+
+// The start line follows the total distance, not Pos, so it keeps moving
+// one line per pixel when the strip wraps
+void MARQUEE_Step(MARQUEE *pMarquee, int Pixels) {
+    LCD_CANVAS Frame = { PANEL_WIDTH, PANEL_HEIGHT, FRAME_BYTES, pMarquee->Frame };
+
+    if (!pMarquee->Strip.pFrame) return;
+    MARQUEE_Draw(pMarquee, Pixels, &Frame);
+    if (pMarquee->bVertical)
+        LCD_FrameCopyScrolled(pMarquee->Frame, pMarquee->Scrolled & 63);
+    else
+        LCD_FrameCopy(pMarquee->Frame);
+}
+
+void MARQUEE_Free(MARQUEE *pMarquee) {
+    free(pMarquee->Strip.pFrame);
+    pMarquee->Strip.pFrame = NULL;
+}
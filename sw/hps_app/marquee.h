@@ -0,0 +1,42 @@
+#ifndef _MARQUEE_H_
+#define _MARQUEE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lcd_graphic.h"
+
+// Scrolling text for content that does not fit the panel. The content is
+// rasterized once into a strip canvas (with a blank gap so it wraps
+// around seamlessly); a step only blits the visible window out of it.
+//
+// Row marquee: one text line wider than the panel scrolls left inside
+// its band of an otherwise fixed screen (pBase). The ST7565 has no
+// horizontal scroll, so each step sends the band's pages through the
+// frame diff: at most two pages, never the whole frame.
+//
+// Line marquee: text lines taller than the panel scroll up through the
+// start-line register (LCD_FrameCopyScrolled). A one-pixel step is one
+// command byte plus the single RAM line that wrapped around; content
+// exactly one panel high just rotates, command byte only.
+
+#define MARQUEE_GAP     32      // blank columns/rows before the content repeats
+
+typedef struct {
+    bool        bVertical;
+    int         Y;              // row marquee: top of the band
+    int         Pos;            // pixels scrolled, wraps at the strip length
+    uint32_t    Scrolled;       // pixels scrolled in total
+    LCD_CANVAS  Strip;
+    uint8_t     Frame[128 * 8];
+} MARQUEE;
+
+bool MARQUEE_InitRow(MARQUEE *pMarquee, const uint8_t *pBase, int Y, const char *pText, FONT_TABLE *pFont);
+bool MARQUEE_InitLines(MARQUEE *pMarquee, const char *const *pLines, int nLines, FONT_TABLE *pFont);
+void MARQUEE_Step(MARQUEE *pMarquee, int Pixels);
+
+// Advances and draws the window into a panel-sized canvas (the band only
+// for a row marquee) without sending anything, for use under a layer stack
+void MARQUEE_Draw(MARQUEE *pMarquee, int Pixels, LCD_CANVAS *pFrame);
+void MARQUEE_Free(MARQUEE *pMarquee);
+
+#endif // _MARQUEE_H_
@@ -1,6 +1,8 @@
 #ifndef MESSAGES_H
 #define MESSAGES_H
 
+#include <stdio.h>
+
 // 18 Messages for Rehabilitation/Treatment Room Display
 // Navigate with: KEY1 (Next), KEY2 (Previous), KEY0 (Back)
 static const char* MSG_LIST[18][4] = {
@@ -105,4 +107,22 @@ static const char* MSG_LIST[18][4] = {
      " To Begin       "}
 };
 
+// Fixed screens, drawn line by line
+static const char *const IDLE_LINES[4] = {
+    "==================", "  DE10-Standard   ", "   LCD Message    ", "  Press Any Key   "
+};
+static const char *const HOME_LINES[4] = {
+    "==================", "  Welcome User!   ", " KEY1/KEY2: Msgs  ", " KEY0: Back       "
+};
+
+// A message as one string for the layout engine: its rows joined with
+// '\n'. lcd_msg_app and lcd_pack must build message screens alike.
+#define MSG_TEXT_SIZE   (4 * 32)
+#define MSG_TEXT_FLAGS  TEXT_CENTER
+
+static inline void MSG_Text(char *pText, int Msg) {
+    snprintf(pText, MSG_TEXT_SIZE, "%s\n%s\n%s\n%s", MSG_LIST[Msg][0], MSG_LIST[Msg][1],
+             MSG_LIST[Msg][2], MSG_LIST[Msg][3]);
+}
+
 #endif // MESSAGES_H
\ No newline at end of file
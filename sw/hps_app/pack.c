@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pack.h"
+#include "font_file.h"
+#include "log.h"
+
+struct PACK {
+    const uint8_t     *pMap;
+    size_t             MapSize;
+    const PACK_ENTRY  *pIndex;
+    int                Count;
+};
+
+PACK *PACK_Open(const char *pPath) {
+    const PACK_HEADER *pHdr;
+    PACK *pPack;
+    struct stat st;
+    uint8_t *pMap;
+    size_t size;
+    int fd;
+
+    fd = open(pPath, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("PACK: cannot open asset pack");
+        return NULL;
+    }
+    if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(PACK_HEADER)) {
+        LOG_Error("PACK: %s is too short", pPath);
+        close(fd);
+        return NULL;
+    }
+    size = (size_t)st.st_size;
+    pMap = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (pMap == MAP_FAILED) {
+        perror("PACK: mmap failed");
+        return NULL;
+    }
+
+    // Offsets and sizes come from the file: every bounds check below is
+    // written so that it cannot wrap around in a 32-bit size_t
+    pHdr = (const PACK_HEADER *)pMap;
+    if (memcmp(pHdr->Magic, PACK_MAGIC, 4) != 0 || pHdr->Version != PACK_VERSION ||
+        pHdr->Size != (uint64_t)st.st_size || pHdr->IndexOffset % sizeof(uint32_t) != 0 ||
+        pHdr->IndexOffset > size || pHdr->Count > (size - pHdr->IndexOffset) / sizeof(PACK_ENTRY)) {
+        LOG_Error("PACK: %s is not a valid asset pack", pPath);
+        munmap(pMap, st.st_size);
+        return NULL;
+    }
+
+    const PACK_ENTRY *pIndex = (const PACK_ENTRY *)(pMap + pHdr->IndexOffset);
+    for (int i = 0; i < pHdr->Count; i++) {
+        const PACK_ENTRY *pEntry = &pIndex[i];
+        bool bBad = memchr(pEntry->Name, '\0', PACK_NAME_LEN) == NULL ||
+                    pEntry->Offset % PACK_ALIGN != 0 ||
+                    pEntry->Offset > size || pEntry->Size > size - pEntry->Offset ||
+                    (i > 0 && strcmp(pIndex[i - 1].Name, pEntry->Name) >= 0);
+
+        if (pEntry->Type == PACK_FRAME || pEntry->Type == PACK_IMAGE)
+            bBad |= pEntry->Size != (uint32_t)pEntry->Width * ((pEntry->Height + 7) / 8);
+        if (pEntry->Type == PACK_TEXT && !bBad)
+            bBad = pEntry->Size == 0 || pMap[pEntry->Offset + pEntry->Size - 1] != '\0';
+        if (bBad) {
+            LOG_Error("PACK: %s: bad entry %d", pPath, i);
+            munmap(pMap, st.st_size);
+            return NULL;
+        }
+    }
+
+    pPack = calloc(1, sizeof(*pPack));
+    if (!pPack) {
+        munmap(pMap, st.st_size);
+        return NULL;
+    }
+    pPack->pMap = pMap;
+    pPack->MapSize = st.st_size;
+    pPack->pIndex = pIndex;
+    pPack->Count = pHdr->Count;
+    LOG_Info("PACK: %s, %d entries, %zu bytes", pPath, pPack->Count, pPack->MapSize);
+    return pPack;
+}
+
+void PACK_Close(PACK *pPack) {
+    if (!pPack) return;
+    munmap((void *)pPack->pMap, pPack->MapSize);
+    free(pPack);
+}
+
+size_t PACK_Size(const PACK *pPack) {
+    return pPack->MapSize;
+}
+
+const PACK_ENTRY *PACK_Find(const PACK *pPack, const char *pName, int Type) {
+    int lo = 0, hi = pPack->Count - 1;
+
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        int c = strcmp(pName, pPack->pIndex[mid].Name);
+
+        if (c == 0)
+            return pPack->pIndex[mid].Type == Type ? &pPack->pIndex[mid] : NULL;
+        if (c < 0) hi = mid - 1;
+        else       lo = mid + 1;
+    }
+    return NULL;
+}
+
+const void *PACK_Data(const PACK *pPack, const PACK_ENTRY *pEntry) {
+    return pPack->pMap + pEntry->Offset;
+}
+
+bool PACK_Canvas(const PACK *pPack, const char *pName, int Type, LCD_CANVAS *pCanvas) {
+    const PACK_ENTRY *pEntry = PACK_Find(pPack, pName, Type);
+
+    if (!pEntry) return false;
+    pCanvas->Width = pEntry->Width;
+    pCanvas->Height = pEntry->Height;
+    pCanvas->FrameSize = pEntry->Size;
+    pCanvas->pFrame = (uint8_t *)PACK_Data(pPack, pEntry);
+    return true;
+}
+
+FONT_TABLE *PACK_Font(const PACK *pPack, const char *pName) {
+    const PACK_ENTRY *pEntry = PACK_Find(pPack, pName, PACK_FONT);
+
+    if (!pEntry) return NULL;
+    return FONT_Map(PACK_Data(pPack, pEntry), pEntry->Size, pName);
+}
+
+const char *PACK_Text(const PACK *pPack, const char *pName, int *pX, int *pY) {
+    const PACK_ENTRY *pEntry = PACK_Find(pPack, pName, PACK_TEXT);
+
+    if (!pEntry) return NULL;
+    if (pX) *pX = pEntry->X;
+    if (pY) *pY = pEntry->Y;
+    return PACK_Data(pPack, pEntry);
+}
+
+static bool Pad(FILE *fp) {
+    long Pos = ftell(fp);
+
+    if (Pos < 0) return false;
+    for (; Pos % PACK_ALIGN; Pos++)
+        fputc(0, fp);
+    return true;
+}
+
+bool PACK_Create(PACK_WRITER *pW, const char *pPath) {
+    PACK_HEADER hdr;
+
+    memset(pW, 0, sizeof(*pW));
+    pW->fp = fopen(pPath, "wb");
+    if (!pW->fp) {
+        perror("PACK: cannot create asset pack");
+        return false;
+    }
+    memset(&hdr, 0, sizeof(hdr));          // written for real by PACK_Finish
+    fwrite(&hdr, sizeof(hdr), 1, pW->fp);
+    return true;
+}
+
+FILE *PACK_BeginEntry(PACK_WRITER *pW, const char *pName, int Type) {
+    PACK_ENTRY *pEntry;
+
+    if (pW->bOpen || pW->Count == (int)(sizeof(pW->Entries) / sizeof(pW->Entries[0])) ||
+        strlen(pName) >= PACK_NAME_LEN) {
+        LOG_Error("PACK: cannot add %s", pName);
+        return NULL;
+    }
+    for (int i = 0; i < pW->Count; i++) {
+        if (strcmp(pW->Entries[i].Name, pName) == 0) {
+            LOG_Error("PACK: %s added twice", pName);
+            return NULL;
+        }
+    }
+    if (!Pad(pW->fp)) return NULL;
+    pEntry = &pW->Entries[pW->Count];
+    memset(pEntry, 0, sizeof(*pEntry));
+    strcpy(pEntry->Name, pName);
+    pEntry->Type = Type;
+    pEntry->Offset = ftell(pW->fp);
+    pW->bOpen = true;
+    return pW->fp;
+}
+
+void PACK_EndEntry(PACK_WRITER *pW, int Width, int Height, int X, int Y) {
+    PACK_ENTRY *pEntry = &pW->Entries[pW->Count++];
+
+    pEntry->Size = ftell(pW->fp) - pEntry->Offset;
+    pEntry->Width = Width;
+    pEntry->Height = Height;
+    pEntry->X = X;
+    pEntry->Y = Y;
+    pW->bOpen = false;
+}
+
+bool PACK_AddData(PACK_WRITER *pW, const char *pName, int Type, const void *pData, size_t Size,
+                  int Width, int Height, int X, int Y) {
+    FILE *fp = PACK_BeginEntry(pW, pName, Type);
+
+    if (!fp) return false;
+    fwrite(pData, 1, Size, fp);
+    PACK_EndEntry(pW, Width, Height, X, Y);
+    return true;
+}
+
+static int CompareEntries(const void *a, const void *b) {
+    return strcmp(((const PACK_ENTRY *)a)->Name, ((const PACK_ENTRY *)b)->Name);
+}
+
+bool PACK_Finish(PACK_WRITER *pW) {
+    PACK_HEADER hdr;
+    bool bOk;
+
+    qsort(pW->Entries, pW->Count, sizeof(PACK_ENTRY), CompareEntries);
+    Pad(pW->fp);
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.Magic, PACK_MAGIC, 4);
+    hdr.Version = PACK_VERSION;
+    hdr.Count = pW->Count;
+    hdr.IndexOffset = ftell(pW->fp);
+    fwrite(pW->Entries, sizeof(PACK_ENTRY), pW->Count, pW->fp);
+    hdr.Size = ftell(pW->fp);
+    fseek(pW->fp, 0, SEEK_SET);
+    fwrite(&hdr, sizeof(hdr), 1, pW->fp);
+    bOk = !pW->bOpen && !ferror(pW->fp);
+    if (fclose(pW->fp) != 0 || !bOk) {
+        perror("PACK: write failed");
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,84 @@
+#ifndef _PACK_H_
+#define _PACK_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "lcd_graphic.h"
+#include "font.h"
+
+// Asset pack (.pak): everything the app shows, built offline by lcd_pack
+// into one file that is mapped read-only at startup. Entries are used in
+// place: frames and icons are already in the panel's page format, fonts
+// are .fnt contents (font_file.h), texts are NUL terminated. Opening a
+// pack checks the header and the index, nothing else is read until it is
+// used.
+//
+// Layout, little endian:
+//   PACK_HEADER
+//   entry data           each at a multiple of PACK_ALIGN
+//   PACK_ENTRY[Count]    at IndexOffset, sorted by Name
+
+#define PACK_MAGIC          "LPAK"
+#define PACK_VERSION        1
+#define PACK_ALIGN          64          // entries start on a cache line
+#define PACK_NAME_LEN       20          // including the NUL
+
+#define PACK_FRAME          1           // Width x Height page-format canvas (128x64 screens)
+#define PACK_IMAGE          2           // same, any size, drawn at X, Y
+#define PACK_FONT           3           // .fnt file contents
+#define PACK_TEXT           4           // string, X, Y where it goes on the panel
+
+typedef struct {
+    char     Magic[4];
+    uint16_t Version;
+    uint16_t Count;
+    uint32_t IndexOffset;
+    uint32_t Size;                      // whole file, to catch truncation
+} PACK_HEADER;
+
+typedef struct {
+    char     Name[PACK_NAME_LEN];
+    uint16_t Type;
+    uint16_t Reserved;
+    uint32_t Offset;
+    uint32_t Size;
+    uint16_t Width, Height;             // FRAME, IMAGE
+    int16_t  X, Y;                      // IMAGE, TEXT
+} PACK_ENTRY;
+
+typedef struct PACK PACK;
+
+PACK *PACK_Open(const char *pPath);
+void  PACK_Close(PACK *pPack);
+size_t PACK_Size(const PACK *pPack);
+
+// NULL if there is no entry of that name and type
+const PACK_ENTRY *PACK_Find(const PACK *pPack, const char *pName, int Type);
+const void *PACK_Data(const PACK *pPack, const PACK_ENTRY *pEntry);
+// A FRAME or IMAGE as a canvas over the mapping: read only, never draw
+// into it
+bool PACK_Canvas(const PACK *pPack, const char *pName, int Type, LCD_CANVAS *pCanvas);
+// A FONT entry as a table (FONT_Unload when done, before PACK_Close)
+FONT_TABLE *PACK_Font(const PACK *pPack, const char *pName);
+const char *PACK_Text(const PACK *pPack, const char *pName, int *pX, int *pY);
+
+// Writing (lcd_pack): entries are streamed, the index goes last
+typedef struct {
+    FILE      *fp;
+    PACK_ENTRY Entries[256];
+    int        Count;
+    bool       bOpen;                   // between PACK_BeginEntry and PACK_EndEntry
+} PACK_WRITER;
+
+bool  PACK_Create(PACK_WRITER *pW, const char *pPath);
+// Returns the file to write the entry's data to, NULL on a bad name or a
+// full index
+FILE *PACK_BeginEntry(PACK_WRITER *pW, const char *pName, int Type);
+void  PACK_EndEntry(PACK_WRITER *pW, int Width, int Height, int X, int Y);
+bool  PACK_AddData(PACK_WRITER *pW, const char *pName, int Type, const void *pData, size_t Size,
+                   int Width, int Height, int X, int Y);
+bool  PACK_Finish(PACK_WRITER *pW);
+
+#endif // _PACK_H_
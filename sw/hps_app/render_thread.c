@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <sched.h>
+#include <time.h>
+#include "render_thread.h"
+#include "trace.h"
+#include "log.h"
+
+// Mailbox word: valid flag, state in bits [15:8], msg_index in bits [7:0]
+#define MBOX_EMPTY       0u
+#define MBOX_VALID       0x80000000u
+#define MBOX_PACK(s, i)  (MBOX_VALID | (((uint32_t)(s) & 0xFF) << 8) | ((uint32_t)(i) & 0xFF))
+#define MBOX_STATE(v)    ((int)(((v) >> 8) & 0xFF))
+#define MBOX_INDEX(v)    ((int)((v) & 0xFF))
+
+static RENDER_FN gpfnRender;
+static void *gRenderContext;
+static atomic_bool gRunning;        // read by the render thread from its first frame
+static pthread_t gThread;
+static sem_t gWake;
+static RENDER_STATUS_FN gpfnStatus;
+static RENDER_TICK_FN gpfnTick;
+static uint32_t gTickPeriodUs;
+static bool gTicking;               // render thread only
+static uint64_t gNextTickUs;        // 0: schedule from the next pump
+
+static _Atomic uint32_t gMailbox = MBOX_EMPTY;
+static _Atomic uint32_t gStatusBox = MBOX_EMPTY;     // MBOX_VALID | value
+static atomic_bool gStop;
+static _Atomic uint64_t gPosted, gRendered, gMaxRenderUs, gTicks;
+
+// sem_clockwait arrived in glibc 2.30; older C libraries wait on
+// CLOCK_REALTIME (see WaitUntil)
+#ifdef __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 30)
+#define HAVE_SEM_CLOCKWAIT  1
+#endif
+#endif
+
+static uint64_t NowUs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void Render(uint32_t Target) {
+    uint64_t t0 = NowUs(), us;
+
+    TRACE_Record(TRACE_RENDER_BEGIN, (uint16_t)MBOX_STATE(Target), (uint32_t)MBOX_INDEX(Target));
+    gpfnRender(MBOX_STATE(Target), MBOX_INDEX(Target), gRenderContext);
+    us = NowUs() - t0;
+    TRACE_Record(TRACE_RENDER_END, (uint16_t)MBOX_STATE(Target), (uint32_t)us);
+    if (us > atomic_load_explicit(&gMaxRenderUs, memory_order_relaxed))
+        atomic_store_explicit(&gMaxRenderUs, us, memory_order_relaxed);
+    atomic_fetch_add_explicit(&gRendered, 1, memory_order_relaxed);
+    gTicking = gpfnTick != NULL;
+    gNextTickUs = atomic_load(&gRunning) ? NowUs() + gTickPeriodUs : 0;
+}
+
+static void Tick(void) {
+    TRACE_Record(TRACE_TICK_BEGIN, 0, 0);
+    gTicking = gpfnTick(gRenderContext);
+    TRACE_Record(TRACE_TICK_END, 0, 0);
+    atomic_fetch_add_explicit(&gTicks, 1, memory_order_relaxed);
+    gNextTickUs += gTickPeriodUs;
+}
+
+// The tick schedule is on CLOCK_MONOTONIC and so is the wait, so setting
+// the wall clock neither stalls nor rushes a tick. Without sem_clockwait
+// the deadline is converted to CLOCK_REALTIME at the start of the wait;
+// only a clock step during that one wait can then move the tick.
+static int WaitUntil(uint64_t DeadlineUs) {
+#ifdef HAVE_SEM_CLOCKWAIT
+    struct timespec ts = {
+        .tv_sec  = DeadlineUs / 1000000u,
+        .tv_nsec = (long)(DeadlineUs % 1000000u) * 1000,
+    };
+
+    return sem_clockwait(&gWake, CLOCK_MONOTONIC, &ts);
+#else
+    uint64_t Now = NowUs(), LeftUs = DeadlineUs > Now ? DeadlineUs - Now : 0;
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += LeftUs / 1000000u;
+    ts.tv_nsec += (long)(LeftUs % 1000000u) * 1000;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return sem_timedwait(&gWake, &ts);
+#endif
+}
+
+static void RunStatus(int Value) {
+    TRACE_Record(TRACE_STATUS_BEGIN, (uint16_t)Value, 0);
+    gpfnStatus(Value, gRenderContext);
+    TRACE_Record(TRACE_STATUS_END, (uint16_t)Value, 0);
+}
+
+static void *RenderThread(void *pArg) {
+    (void)pArg;
+    TRACE_SetThread(1, "render");
+    for (;;) {
+        if (gTicking) {
+            if (WaitUntil(gNextTickUs) < 0) {
+                if (errno == ETIMEDOUT) {
+                    Tick();
+                    // Fell behind (long render): skip, do not burst
+                    if (gNextTickUs < NowUs()) gNextTickUs = NowUs() + gTickPeriodUs;
+                }
+                continue;
+            }
+        } else {
+            while (sem_wait(&gWake) < 0 && errno == EINTR)
+                ;
+        }
+        if (atomic_load(&gStop)) break;
+        // Several posts may have landed since the last wake; the swap takes
+        // the newest and later wakes find the mailbox empty.
+        uint32_t Target = atomic_exchange_explicit(&gMailbox, MBOX_EMPTY, memory_order_acquire);
+        if (Target != MBOX_EMPTY) Render(Target);
+        uint32_t Status = atomic_exchange_explicit(&gStatusBox, MBOX_EMPTY, memory_order_acquire);
+        if (Status != MBOX_EMPTY) RunStatus((int)(Status & ~MBOX_VALID));
+    }
+    return NULL;
+}
+
+bool RENDER_Start(RENDER_FN pfnRender, void *pContext, int Cpu, bool bThreaded) {
+    int err;
+
+    gpfnRender = pfnRender;
+    gRenderContext = pContext;
+    atomic_store(&gMailbox, MBOX_EMPTY);
+    atomic_store(&gStatusBox, MBOX_EMPTY);
+    atomic_store(&gStop, false);
+    if (!bThreaded) return true;
+
+    if (sem_init(&gWake, 0, 0) < 0) {
+        perror("RENDER: sem_init");
+        return false;
+    }
+    // The thread inherits the caller's signal mask, which already blocks
+    // whatever the event loop takes through its signalfd (EVLOOP_AddSignal).
+    // It may render before pthread_create returns, so it is marked
+    // running first.
+    atomic_store(&gRunning, true);
+    err = pthread_create(&gThread, NULL, RenderThread, NULL);
+    if (err) {
+        atomic_store(&gRunning, false);
+        fprintf(stderr, "RENDER: pthread_create: %s\n", strerror(err));
+        sem_destroy(&gWake);
+        return false;
+    }
+
+    if (Cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(Cpu, &set);
+        err = pthread_setaffinity_np(gThread, sizeof(set), &set);
+        if (err)
+            LOG_Warn("RENDER: cannot pin to CPU%d (%s), running unpinned", Cpu, strerror(err));
+        else
+            LOG_Info("RENDER: render thread pinned to CPU%d", Cpu);
+    }
+    return true;
+}
+
+bool RENDER_SetPriority(int Priority) {
+    struct sched_param param = { .sched_priority = Priority };
+    int err;
+
+    if (!atomic_load(&gRunning)) return false;
+    err = pthread_setschedparam(gThread, SCHED_FIFO, &param);
+    if (err) {
+        LOG_Warn("RENDER: cannot run at SCHED_FIFO %d (%s)", Priority, strerror(err));
+        return false;
+    }
+    LOG_Info("RENDER: render thread at SCHED_FIFO %d", Priority);
+    return true;
+}
+
+void RENDER_Stop(void) {
+    if (!atomic_load(&gRunning)) return;
+    atomic_store(&gStop, true);
+    sem_post(&gWake);
+    pthread_join(gThread, NULL);
+    sem_destroy(&gWake);
+    atomic_store(&gRunning, false);
+}
+
+void RENDER_Post(int State, int MsgIndex) {
+    uint32_t Target = MBOX_PACK(State, MsgIndex);
+
+    atomic_fetch_add_explicit(&gPosted, 1, memory_order_relaxed);
+    if (!atomic_load(&gRunning)) {
+        Render(Target);
+        return;
+    }
+    atomic_store_explicit(&gMailbox, Target, memory_order_release);
+    sem_post(&gWake);
+}
+
+void RENDER_SetTick(RENDER_TICK_FN pfnTick, uint32_t PeriodUs) {
+    gpfnTick = pfnTick;
+    gTickPeriodUs = PeriodUs;
+    gTicking = false;
+}
+
+void RENDER_Pump(uint64_t NowUs) {
+    if (atomic_load(&gRunning) || !gTicking) return;
+    if (gNextTickUs == 0) gNextTickUs = NowUs + gTickPeriodUs;
+    if (NowUs >= gNextTickUs) Tick();
+}
+
+void RENDER_SetStatus(RENDER_STATUS_FN pfnStatus) {
+    gpfnStatus = pfnStatus;
+}
+
+void RENDER_PostStatus(int Value) {
+    if (!gpfnStatus) return;
+    if (!atomic_load(&gRunning)) {
+        RunStatus(Value);
+        return;
+    }
+    atomic_store_explicit(&gStatusBox, MBOX_VALID | ((uint32_t)Value & ~MBOX_VALID), memory_order_release);
+    sem_post(&gWake);
+}
+
+void RENDER_GetStats(RENDER_STATS *pStats) {
+    pStats->Posted = atomic_load(&gPosted);
+    pStats->Rendered = atomic_load(&gRendered);
+    pStats->MaxRenderUs = atomic_load(&gMaxRenderUs);
+    pStats->Ticks = atomic_load(&gTicks);
+}
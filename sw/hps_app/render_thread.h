@@ -0,0 +1,55 @@
+#ifndef _RENDER_THREAD_H_
+#define _RENDER_THREAD_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Renders FSM targets (state, msg_index) off the poll loop. The mailbox
+// between the two is a single word: RENDER_Post overwrites it and never
+// blocks, the render thread swaps it out, so a target the renderer has
+// not picked up yet is simply replaced by the newer one. After a press
+// the panel shows the final screen at most one frame transfer after the
+// frame already in flight.
+//
+// Only the render thread may touch the LCD stack once RENDER_Start has
+// returned (backlight included: it shares GPIO1 DR with D/C).
+
+typedef void (*RENDER_FN)(int State, int MsgIndex, void *pContext);
+
+// Optional periodic work on the render thread (animation). After each
+// render the tick runs every PeriodUs until it returns false, i.e. until
+// the screen has nothing left to animate.
+typedef bool (*RENDER_TICK_FN)(void *pContext);
+
+// Optional status updates (e.g. the idle countdown) through a second
+// latest-wins mailbox, handled after any pending screen render
+typedef void (*RENDER_STATUS_FN)(int Value, void *pContext);
+
+typedef struct {
+    uint64_t Posted;
+    uint64_t Rendered;      // Posted - Rendered targets were coalesced away
+    uint64_t MaxRenderUs;
+    uint64_t Ticks;
+} RENDER_STATS;
+
+// Cpu < 0 leaves the thread unpinned. With bThreaded false RENDER_Post
+// renders on the caller's thread (used with the single-threaded emulator).
+// Call after EVLOOP_AddSignal, so the thread starts with those signals
+// blocked.
+bool RENDER_Start(RENDER_FN pfnRender, void *pContext, int Cpu, bool bThreaded);
+void RENDER_Stop(void);
+void RENDER_Post(int State, int MsgIndex);
+
+// Set before RENDER_Start. Without the thread, ticks run from RENDER_Pump,
+// which the poll loop calls with its own clock.
+void RENDER_SetTick(RENDER_TICK_FN pfnTick, uint32_t PeriodUs);
+void RENDER_Pump(uint64_t NowUs);
+void RENDER_SetStatus(RENDER_STATUS_FN pfnStatus);
+void RENDER_PostStatus(int Value);
+void RENDER_GetStats(RENDER_STATS *pStats);
+
+// SCHED_FIFO at Priority for the render thread (real-time mode); false
+// without the thread or without the privilege
+bool RENDER_SetPriority(int Priority);
+
+#endif // _RENDER_THREAD_H_
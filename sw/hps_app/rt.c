@@ -0,0 +1,200 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+
+#include "rt.h"
+#include "event_loop.h"
+#include "log.h"
+
+#define PAGE_SIZE           4096
+#define TEST_PERIOD_US      1000
+#define STRESS_BYTES        (8 * 1024 * 1024)
+#define STRESS_MAX_THREADS  64
+
+// Touches the stack RT_STACK_PREFAULT deep, so calls that go that deep
+// later find it mapped (and, under mlockall, locked)
+static void __attribute__((noinline)) PrefaultStack(void) {
+    volatile uint8_t stack[RT_STACK_PREFAULT];
+
+    for (int i = 0; i < RT_STACK_PREFAULT; i += PAGE_SIZE)
+        stack[i] = 0;
+    (void)stack[0];
+}
+
+bool RT_LockMemory(void) {
+    pthread_attr_t attr;
+    void *pReserve;
+
+    // Every thread stack is locked in full, so keep them small
+    if (pthread_attr_init(&attr) == 0) {
+        pthread_attr_setstacksize(&attr, RT_THREAD_STACK);
+        pthread_setattr_default_np(&attr);
+        pthread_attr_destroy(&attr);
+    }
+    // One heap for all threads, never trimmed, big blocks taken from it
+    // rather than from new mappings: once the reserve below has been
+    // touched, malloc/free reuse resident memory
+    mallopt(M_ARENA_MAX, 1);
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        LOG_Error("RT: mlockall: %s", strerror(errno));
+        return false;
+    }
+    PrefaultStack();
+    pReserve = malloc(RT_HEAP_RESERVE);
+    if (pReserve) {
+        memset(pReserve, 0, RT_HEAP_RESERVE);
+        free(pReserve);
+    }
+    LOG_Info("RT: memory locked, %d KB heap reserve, %d KB thread stacks", RT_HEAP_RESERVE / 1024,
+             RT_THREAD_STACK / 1024);
+    return true;
+}
+
+bool RT_SetThread(pthread_t Thread, int Priority, int Cpu) {
+    int err;
+
+    if (Cpu >= 0) {
+        cpu_set_t set;
+
+        CPU_ZERO(&set);
+        CPU_SET(Cpu, &set);
+        err = pthread_setaffinity_np(Thread, sizeof(set), &set);
+        if (err) {
+            LOG_Warn("RT: cannot pin to CPU%d (%s)", Cpu, strerror(err));
+            return false;
+        }
+    }
+    if (Priority > 0) {
+        struct sched_param param = { .sched_priority = Priority };
+
+        err = pthread_setschedparam(Thread, SCHED_FIFO, &param);
+        if (err) {
+            LOG_Warn("RT: cannot run at SCHED_FIFO %d (%s)", Priority, strerror(err));
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t RT_PageFaults(void) {
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)usage.ru_minflt + (uint64_t)usage.ru_majflt;
+}
+
+// ---- Self-test ----
+
+static _Atomic bool gStress;
+
+// Maps, fills and unmaps 8 MB over and over: a CPU hog that also keeps
+// the page allocator, the TLBs and the caches busy
+static void *Stressor(void *pArg) {
+    uint8_t fill = 0;
+
+    (void)pArg;
+    while (atomic_load_explicit(&gStress, memory_order_relaxed)) {
+        uint8_t *p = mmap(NULL, STRESS_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+        if (p == MAP_FAILED) continue;
+        memset(p, fill++, STRESS_BYTES);
+        munmap(p, STRESS_BYTES);
+    }
+    return NULL;
+}
+
+// Normal threads whatever policy the caller runs at; they inherit its
+// CPUs, so start them before pinning it
+static int StartStress(pthread_t *pThreads, int Max) {
+    pthread_attr_t attr;
+    struct sched_param param = { 0 };
+    int n = 0;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_OTHER);
+    pthread_attr_setschedparam(&attr, &param);
+    atomic_store(&gStress, true);
+    for (; n < Max; n++)
+        if (pthread_create(&pThreads[n], &attr, Stressor, NULL) != 0)
+            break;
+    pthread_attr_destroy(&attr);
+    return n;
+}
+
+static void StopStress(pthread_t *pThreads, int n) {
+    atomic_store(&gStress, false);
+    for (int i = 0; i < n; i++)
+        pthread_join(pThreads[i], NULL);
+}
+
+static void OnTick(void *pContext) {
+    (void)pContext;
+}
+
+static void OnEnd(void *pContext) {
+    (void)pContext;
+    EVLOOP_Stop();
+}
+
+// One run of the loop timer; prints its lateness and the loop thread's
+// own page faults
+static void Measure(const char *pMode, int Seconds) {
+    EVLOOP_TIMER_STATS timers[2];
+    struct rusage r0, r1;
+    int n;
+
+    if (!EVLOOP_Init()) return;
+    EVLOOP_AddTimer("rt-test", TEST_PERIOD_US, OnTick, NULL);
+    EVLOOP_AddDeadline("rt-test-end", (uint32_t)Seconds * 1000000u, OnEnd, NULL);
+    getrusage(RUSAGE_THREAD, &r0);
+    EVLOOP_Run();
+    getrusage(RUSAGE_THREAD, &r1);
+    n = EVLOOP_GetTimerStats(timers, 2);
+    EVLOOP_Close();
+    for (int i = 0; i < n; i++) {
+        if (strcmp(timers[i].pName, "rt-test") != 0 || !timers[i].Fired) continue;
+        printf("  %-9s %6llu ticks, %llu missed, late mean %7.1f us, max %8.1f us, %ld page faults\n", pMode,
+               (unsigned long long)timers[i].Fired, (unsigned long long)timers[i].Missed,
+               timers[i].LateSumNs / 1e3 / timers[i].Fired, timers[i].LateMaxNs / 1e3,
+               (r1.ru_minflt - r0.ru_minflt) + (r1.ru_majflt - r0.ru_majflt));
+    }
+}
+
+bool RT_SelfTest(int Seconds, int Cpu) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    pthread_t threads[STRESS_MAX_THREADS];
+    bool ok;
+    int n;
+
+    if (cpus < 1) cpus = 1;
+    if (cpus > STRESS_MAX_THREADS) cpus = STRESS_MAX_THREADS;
+    printf("RT self-test: %d us timer for %d s per mode, %ld stressor threads (%d MB map/fill/unmap)\n",
+           TEST_PERIOD_US, Seconds, cpus, STRESS_BYTES / (1024 * 1024));
+
+    n = StartStress(threads, (int)cpus);
+    Measure("normal", Seconds);
+    StopStress(threads, n);
+
+    ok = RT_LockMemory();
+    n = StartStress(threads, (int)cpus);
+    ok = RT_SetThread(pthread_self(), RT_LOOP_PRIO, Cpu) && ok;
+    PrefaultStack();
+    Measure(ok ? "real-time" : "partly RT", Seconds);
+    StopStress(threads, n);
+    if (!ok) printf("Real-time mode was refused (needs root); the second run is not a real-time one\n");
+    return ok;
+}
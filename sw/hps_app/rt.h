@@ -0,0 +1,41 @@
+#ifndef _RT_H_
+#define _RT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+// Real-time mode (--rt). By default the app is an ordinary CFS process,
+// and anything else on the board can hold the loop or a frame off the
+// CPU for tens of milliseconds. In this mode:
+//
+//  - all memory is locked and prefaulted (mlockall, the main stack
+//    touched ahead, a heap reserve that is never given back), so once
+//    the app is up neither the loop nor the renderer takes a page fault
+//  - threads get 256 KB stacks instead of 8 MB, all of it locked
+//  - the loop and the render thread run at SCHED_FIFO, each pinned to
+//    its own CPU; the log writer stays at SCHED_IDLE
+//
+// Needs CAP_SYS_NICE and CAP_IPC_LOCK (root), and the kernel's RT
+// throttling (sched_rt_runtime_us) is left on as a safety net.
+
+#define RT_LOOP_PRIO        60          // input: above the renderer
+#define RT_RENDER_PRIO      50
+#define RT_THREAD_STACK     (256 * 1024)
+#define RT_STACK_PREFAULT   (64 * 1024)
+#define RT_HEAP_RESERVE     (1024 * 1024)
+
+// Before any thread is created
+bool RT_LockMemory(void);
+// SCHED_FIFO at Priority (0: leave the policy) and pinned to Cpu (< 0:
+// leave the affinity)
+bool RT_SetThread(pthread_t Thread, int Priority, int Cpu);
+// Minor plus major faults of the whole process so far
+uint64_t RT_PageFaults(void);
+
+// --rt-test: worst-case lateness of a 1 ms loop timer under a CPU and
+// memory stressor on every CPU, first as a normal process, then in
+// real-time mode on Cpu. Returns false if real-time mode was refused.
+bool RT_SelfTest(int Seconds, int Cpu);
+
+#endif // _RT_H_
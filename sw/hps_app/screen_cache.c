@@ -0,0 +1,143 @@
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "screen_cache.h"
+#include "lcd_graphic.h"
+#include "text_layout.h"
+#include "log.h"
+
+#define FRAME_BYTES     (128 * 8)
+
+typedef struct {
+    const char *const *Lines;
+    const char        *pText;       // SCACHE_AddText: laid out, not line by line
+    int                Flags;
+    TEXT_LAYOUT        Layout;
+    uint8_t            Frame[FRAME_BYTES];
+    bool               bValid;
+} SCACHE_ENTRY;
+
+static SCACHE_ENTRY gEntries[SCACHE_MAX_SCREENS];
+static int gCount;
+static SCACHE_STATS gStats;
+static TEXT_METRICS gMetrics;
+static bool gMetricsValid;
+
+// What the cached frames were drawn for: the font (LCD_SetFont) and the
+// set of screens (SCACHE_Add, also under SCACHE_AddText), each a
+// generation counter, so a lookup only compares two words
+static uint32_t gScreenGeneration;
+static uint32_t gBuiltFont;
+static uint32_t gBuiltScreens;
+
+// Text entries are laid out again only here, i.e. when the font or the
+// text changed; showing one reuses the stored layout and frame
+static void DrawText(SCACHE_ENTRY *pEntry, LCD_CANVAS *pCanvas) {
+    if (!gMetricsValid) {
+        TEXT_InitMetrics(&gMetrics, LCD_GetFont());
+        gMetricsValid = true;
+    }
+    TEXT_Layout(&pEntry->Layout, &gMetrics, pEntry->pText, 128, 64, pEntry->Flags);
+    for (int i = 0; i < pEntry->Layout.nLines; i++) {
+        const TEXT_LINE *pLine = &pEntry->Layout.Lines[i];
+        DRAW_PrintText(pCanvas, pLine->X, pLine->Y, pEntry->pText + pLine->Start, pLine->Len, 1,
+                       LCD_GetFont());
+    }
+}
+
+// Straight into the entry's frame; nothing is sent to the panel
+static void Draw(SCACHE_ENTRY *pEntry) {
+    LCD_CANVAS Canvas = { 128, 64, FRAME_BYTES, pEntry->Frame };
+
+    memset(pEntry->Frame, 0x00, FRAME_BYTES);
+    if (pEntry->pText) {
+        DrawText(pEntry, &Canvas);
+    } else if (pEntry->Lines) {
+        for (int i = 0; i < 4; i++)
+            if (pEntry->Lines[i])
+                DRAW_PrintString(&Canvas, 0, i * 16, (char *)pEntry->Lines[i], 1, LCD_GetFont());
+    }
+    pEntry->bValid = true;
+}
+
+int SCACHE_Add(const char *const *Lines) {
+    if (gCount == SCACHE_MAX_SCREENS) return -1;
+    memset(&gEntries[gCount], 0, sizeof(gEntries[gCount]));
+    gEntries[gCount].Lines = Lines;
+    gScreenGeneration++;
+    return gCount++;
+}
+
+int SCACHE_AddText(const char *pText, int Flags) {
+    int Id = SCACHE_Add(NULL);
+
+    if (Id >= 0) {
+        gEntries[Id].pText = pText;
+        gEntries[Id].Flags = Flags;
+    }
+    return Id;
+}
+
+void SCACHE_Build(void) {
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    gMetricsValid = false;
+    for (int i = 0; i < gCount; i++)
+        Draw(&gEntries[i]);
+    gBuiltFont = LCD_FontGeneration();
+    gBuiltScreens = gScreenGeneration;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    gStats.Screens = gCount;
+    gStats.Bytes = gCount * FRAME_BYTES;
+    gStats.BuildMs = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+    LOG_Info("Screen cache: %d screens, %u bytes, built in %.2f ms",
+             gCount, gStats.Bytes, gStats.BuildMs);
+}
+
+void SCACHE_Invalidate(void) {
+    for (int i = 0; i < gCount; i++)
+        gEntries[i].bValid = false;
+    gMetricsValid = false;
+}
+
+static SCACHE_ENTRY *Lookup(int Id) {
+    SCACHE_ENTRY *pEntry;
+
+    if (Id < 0 || Id >= gCount) return NULL;
+    if (LCD_FontGeneration() != gBuiltFont || gScreenGeneration != gBuiltScreens) {
+        LOG_Info("SCACHE: font or screens changed, redrawing on demand");
+        SCACHE_Invalidate();
+        gBuiltFont = LCD_FontGeneration();
+        gBuiltScreens = gScreenGeneration;
+        gStats.Rebuilds++;
+    }
+    pEntry = &gEntries[Id];
+    if (pEntry->bValid) {
+        gStats.Hits++;
+        return pEntry;
+    }
+    gStats.Misses++;
+    Draw(pEntry);
+    return pEntry;
+}
+
+const uint8_t *SCACHE_Frame(int Id) {
+    SCACHE_ENTRY *pEntry = Lookup(Id);
+    return pEntry ? pEntry->Frame : NULL;
+}
+
+const TEXT_LAYOUT *SCACHE_Layout(int Id) {
+    if (Id < 0 || Id >= gCount || !gEntries[Id].pText || !gEntries[Id].bValid) return NULL;
+    return &gEntries[Id].Layout;
+}
+
+void SCACHE_GetStats(SCACHE_STATS *pStats) {
+    *pStats = gStats;
+}
+
+void SCACHE_Free(void) {
+    gCount = 0;
+}
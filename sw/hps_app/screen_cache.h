@@ -0,0 +1,41 @@
+#ifndef _SCREEN_CACHE_H_
+#define _SCREEN_CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "text_layout.h"
+
+// Pre-rasterized text screens. Each screen (four 16-pixel text lines) is
+// drawn once into a page-format frame; the app takes the frame
+// (SCACHE_Frame) and composes it with the status layer. Each lookup
+// checks whether LCD_SetFont or SCACHE_Add was called since the screens
+// were drawn, and if so redraws them on demand. The text itself is not
+// checked: after changing a referenced line in place, call
+// SCACHE_Invalidate.
+
+#define SCACHE_MAX_SCREENS   64
+
+typedef struct {
+    uint64_t Hits;
+    uint64_t Misses;          // entry had to be drawn on demand
+    uint64_t Rebuilds;        // font or screens changed, everything invalidated
+    double   BuildMs;         // last full SCACHE_Build
+    uint32_t Screens;
+    uint32_t Bytes;           // frames
+} SCACHE_STATS;
+
+// Screens are identified by the id SCACHE_Add returns. The lines are
+// referenced, not copied; NULL lines (or Lines == NULL) stay blank.
+int  SCACHE_Add(const char *const *Lines);
+// A screen from one message string, laid out with the TEXT_* flags over
+// the whole panel. SCACHE_Layout returns where its rows went, as of the
+// last SCACHE_Frame of it.
+int  SCACHE_AddText(const char *pText, int Flags);
+const TEXT_LAYOUT *SCACHE_Layout(int Id);
+void SCACHE_Build(void);
+const uint8_t *SCACHE_Frame(int Id);
+void SCACHE_Invalidate(void);
+void SCACHE_GetStats(SCACHE_STATS *pStats);
+void SCACHE_Free(void);
+
+#endif // _SCREEN_CACHE_H_
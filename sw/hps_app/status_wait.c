@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include "status_wait.h"
+#include "log.h"
+
+// altera_avalon_pio registers, in 32-bit words
+#define PIO_IRQ_MASK        2
+#define PIO_EDGE_CAPTURE    3           // any write clears it (bitClearingEdgeCapReg off)
+#define PIO_MAP_SIZE        4096
+
+#define UIO_SOURCES         STATWAIT_MAX_FDS    // fsm_status_pio, timer_status_pio
+
+static const STATUS_WAIT_OPS *gpOps;
+static STATWAIT_STATS gStats;
+
+// ---- Poll ----
+
+static bool PollOpen(const char *pArg) {
+    (void)pArg;
+    return true;
+}
+
+static void PollClose(void) {
+}
+
+static int PollWait(int TimeoutMs) {
+    (void)TimeoutMs;                    // the period is always the shorter
+    usleep(STATWAIT_POLL_US);
+    return 1;
+}
+
+const STATUS_WAIT_OPS STATWAIT_Poll = { "poll", PollOpen, PollClose, PollWait, NULL, NULL };
+
+// Blocks on whatever descriptors the source has, then acknowledges them
+static int WaitFds(int TimeoutMs) {
+    struct pollfd fds[STATWAIT_MAX_FDS];
+    int fd[STATWAIT_MAX_FDS];
+    int nFds = gpOps->pfnFds(fd), n, woken = 0;
+
+    for (int i = 0; i < nFds; i++) {
+        fds[i].fd = fd[i];
+        fds[i].events = POLLIN;
+    }
+    n = poll(fds, nFds, TimeoutMs);
+    if (n <= 0) return n < 0 ? -1 : 0;
+    for (int i = 0; i < nFds; i++)
+        if (fds[i].revents & POLLIN)
+            woken |= gpOps->pfnAck(fd[i]);
+    return woken;
+}
+
+// ---- Uio ----
+
+static int gUioFd[UIO_SOURCES] = { -1, -1 };
+static volatile uint32_t *gpUioRegs[UIO_SOURCES];
+
+// Acknowledge in the PIO before unmasking in the GIC: the IRQ line stays
+// up while an edge is captured
+static void UioRearm(int i) {
+    uint32_t one = 1;
+
+    gpUioRegs[i][PIO_EDGE_CAPTURE] = 0;
+    if (write(gUioFd[i], &one, sizeof(one)) != sizeof(one))
+        LOG_Limited(LOG_LEVEL_ERROR, "STATWAIT: cannot enable UIO interrupt: %s", strerror(errno));
+}
+
+static void UioClose(void) {
+    for (int i = 0; i < UIO_SOURCES; i++) {
+        if (gpUioRegs[i]) {
+            gpUioRegs[i][PIO_IRQ_MASK] = 0;
+            munmap((void *)gpUioRegs[i], PIO_MAP_SIZE);
+            gpUioRegs[i] = NULL;
+        }
+        if (gUioFd[i] >= 0) close(gUioFd[i]);
+        gUioFd[i] = -1;
+    }
+}
+
+static bool UioOpen(const char *pArg) {
+    char paths[128], *pNext;
+
+    if (!pArg || strlen(pArg) >= sizeof(paths) || !strchr(pArg, ',')) {
+        printf("STATWAIT: need /dev/uioF,/dev/uioT for the fsm and timer PIOs\n");
+        return false;
+    }
+    strcpy(paths, pArg);
+    pNext = strchr(paths, ',');
+    *pNext++ = '\0';
+
+    for (int i = 0; i < UIO_SOURCES; i++) {
+        const char *pPath = i == 0 ? paths : pNext;
+        void *pMap;
+
+        gUioFd[i] = open(pPath, O_RDWR | O_CLOEXEC);
+        if (gUioFd[i] < 0) {
+            perror("STATWAIT: cannot open UIO device");
+            UioClose();
+            return false;
+        }
+        pMap = mmap(NULL, PIO_MAP_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, gUioFd[i], 0);
+        if (pMap == MAP_FAILED) {
+            perror("STATWAIT: cannot map PIO registers");
+            UioClose();
+            return false;
+        }
+        gpUioRegs[i] = pMap;
+        gpUioRegs[i][PIO_IRQ_MASK] = 0xFF;      // every bit: state, index, timeout, seconds
+        UioRearm(i);
+    }
+    return true;
+}
+
+static int UioFds(int *pFds) {
+    for (int i = 0; i < UIO_SOURCES; i++)
+        pFds[i] = gUioFd[i];
+    return UIO_SOURCES;
+}
+
+static int UioAck(int Fd) {
+    for (int i = 0; i < UIO_SOURCES; i++) {
+        uint32_t count;
+        int woken;
+
+        if (gUioFd[i] != Fd) continue;
+        woken = read(Fd, &count, sizeof(count)) == sizeof(count);
+        UioRearm(i);
+        return woken;
+    }
+    return 0;
+}
+
+const STATUS_WAIT_OPS STATWAIT_Uio = { "uio", UioOpen, UioClose, WaitFds, UioFds, UioAck };
+
+// ---- EventFd ----
+
+static int gEventFd = -1;
+
+static bool EventOpen(const char *pArg) {
+    (void)pArg;
+    gEventFd = eventfd(0, EFD_CLOEXEC);
+    if (gEventFd < 0) {
+        perror("STATWAIT: eventfd");
+        return false;
+    }
+    return true;
+}
+
+static void EventClose(void) {
+    if (gEventFd >= 0) close(gEventFd);
+    gEventFd = -1;
+}
+
+static int EventFds(int *pFds) {
+    pFds[0] = gEventFd;
+    return 1;
+}
+
+static int EventAck(int Fd) {
+    uint64_t count;
+    return read(Fd, &count, sizeof(count)) == sizeof(count);
+}
+
+const STATUS_WAIT_OPS STATWAIT_EventFd = { "eventfd", EventOpen, EventClose, WaitFds, EventFds, EventAck };
+
+// ---- Common ----
+
+bool STATWAIT_Open(const STATUS_WAIT_OPS *pOps, const char *pArg) {
+    memset(&gStats, 0, sizeof(gStats));
+    if (!pOps->pfnOpen(pArg)) return false;
+    gpOps = pOps;
+    return true;
+}
+
+void STATWAIT_Close(void) {
+    if (!gpOps) return;
+    gpOps->pfnClose();
+    gpOps = NULL;
+}
+
+const char *STATWAIT_Name(void) {
+    return gpOps ? gpOps->pName : "none";
+}
+
+int STATWAIT_Wait(int TimeoutMs) {
+    int r = gpOps->pfnWait(TimeoutMs);
+
+    gStats.Waits++;
+    if (r > 0) gStats.Wakeups++;
+    else if (r == 0) gStats.Timeouts++;
+    else if (errno != EINTR) LOG_Limited(LOG_LEVEL_ERROR, "STATWAIT: wait failed: %s", strerror(errno));
+    return r;
+}
+
+int STATWAIT_Fds(int *pFds) {
+    return gpOps && gpOps->pfnFds ? gpOps->pfnFds(pFds) : 0;
+}
+
+int STATWAIT_Ack(int Fd) {
+    int r = gpOps->pfnAck(Fd);
+
+    if (r > 0) gStats.Wakeups++;
+    return r;
+}
+
+void STATWAIT_Notify(void) {
+    uint64_t one = 1;
+
+    if (gEventFd >= 0 && write(gEventFd, &one, sizeof(one)) != sizeof(one))
+        LOG_Limited(LOG_LEVEL_ERROR, "STATWAIT: eventfd write: %s", strerror(errno));
+}
+
+void STATWAIT_GetStats(STATWAIT_STATS *pStats) {
+    *pStats = gStats;
+}
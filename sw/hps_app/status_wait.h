@@ -0,0 +1,53 @@
+#ifndef _STATUS_WAIT_H_
+#define _STATUS_WAIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// How the main loop waits for fsm_status_pio / timer_status_pio to change.
+// The source is chosen at runtime, like the register backend:
+//   Poll     sleeps STATWAIT_POLL_US and reports a possible change every
+//            time (the original 5 ms loop)
+//   Uio      blocks in poll() on the two PIOs' edge-capture interrupts,
+//            exported by uio_pdrv_genirq (README: status interrupts)
+//   EventFd  host stand-in for the interrupt: blocks on an eventfd that
+//            STATWAIT_Notify() signals from another thread
+// After STATWAIT_Wait returns the caller reads the status registers; a
+// change after the wakeup raises the next one, so none is lost. An event
+// loop can instead watch STATWAIT_Fds and call STATWAIT_Ack when one is
+// readable; Poll has no descriptor and is driven by a 5 ms timer.
+
+#define STATWAIT_POLL_US      5000
+#define STATWAIT_MAX_FDS      2
+
+typedef struct {
+    const char *pName;
+    bool (*pfnOpen)(const char *pArg);
+    void (*pfnClose)(void);
+    int  (*pfnWait)(int TimeoutMs);     // 1 woken, 0 timed out, -1 error or signal
+    int  (*pfnFds)(int *pFds);          // descriptors that become readable, NULL: none
+    int  (*pfnAck)(int Fd);             // consume a readable one: 1 woken, 0 spurious
+} STATUS_WAIT_OPS;
+
+extern const STATUS_WAIT_OPS STATWAIT_Poll;
+extern const STATUS_WAIT_OPS STATWAIT_Uio;      // pArg: "/dev/uioF,/dev/uioT" (fsm, timer)
+extern const STATUS_WAIT_OPS STATWAIT_EventFd;
+
+typedef struct {
+    uint64_t Waits;
+    uint64_t Wakeups;          // returned 1
+    uint64_t Timeouts;
+} STATWAIT_STATS;
+
+bool STATWAIT_Open(const STATUS_WAIT_OPS *pOps, const char *pArg);
+void STATWAIT_Close(void);
+const char *STATWAIT_Name(void);
+// TimeoutMs < 0 waits for a change only
+int  STATWAIT_Wait(int TimeoutMs);
+// Up to STATWAIT_MAX_FDS descriptors; 0 for Poll
+int  STATWAIT_Fds(int *pFds);
+int  STATWAIT_Ack(int Fd);
+void STATWAIT_Notify(void);             // EventFd: the "interrupt"
+void STATWAIT_GetStats(STATWAIT_STATS *pStats);
+
+#endif // _STATUS_WAIT_H_
@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "text_layout.h"
+
+void TEXT_InitMetrics(TEXT_METRICS *pMetrics, const FONT_TABLE *pFont) {
+    pMetrics->pFont = pFont;
+    pMetrics->LineHeight = pFont->CellHeight;
+    for (int c = 0; c < 256; c++) {
+        int Advance = FONT_Advance(pFont, (unsigned char)c);
+        pMetrics->Advance[c] = Advance > 255 ? 255 : Advance;
+    }
+}
+
+// Len < 0 measures up to the terminating NUL
+int TEXT_Width(const TEXT_METRICS *pMetrics, const char *pText, int Len) {
+    int Width = 0;
+
+    for (int i = 0; Len < 0 ? pText[i] != '\0' : i < Len; i++)
+        Width += pMetrics->Advance[(unsigned char)pText[i]];
+    return Width;
+}
+
+// End of the row starting at Start within the paragraph ending at End,
+// with its width in *pWidth
+static int BreakRow(const TEXT_METRICS *pMetrics, const char *pText, int Start, int End, int Width,
+                    int Flags, int *pWidth) {
+    int i = Start, w = 0, Brk = -1, BrkWidth = 0;
+
+    if (Flags & TEXT_WRAP) {
+        for (; i < End; i++) {
+            int Advance = pMetrics->Advance[(unsigned char)pText[i]];
+
+            if (pText[i] == ' ') {
+                if (pText[i - 1] != ' ') {
+                    Brk = i;
+                    BrkWidth = w;
+                }
+            } else if (w + Advance > Width) {
+                break;
+            }
+            w += Advance;
+        }
+        if (i < End) {
+            if (Brk > Start) {
+                *pWidth = BrkWidth;
+                return Brk;
+            }
+            // One word wider than the box: split it, at least one glyph a row
+            if (i == Start) {
+                *pWidth = pMetrics->Advance[(unsigned char)pText[i]];
+                return i + 1;
+            }
+            *pWidth = w;
+            return i;
+        }
+    } else {
+        w = TEXT_Width(pMetrics, pText + Start, End - Start);
+        i = End;
+    }
+    while (i > Start && pText[i - 1] == ' ')
+        w -= pMetrics->Advance[(unsigned char)pText[--i]];
+    *pWidth = w;
+    return i;
+}
+
+void TEXT_Layout(TEXT_LAYOUT *pLayout, const TEXT_METRICS *pMetrics, const char *pText,
+                 int Width, int Height, int Flags) {
+    int Rows = Height / pMetrics->LineHeight;
+    int Pos = 0;
+
+    memset(pLayout, 0, sizeof(*pLayout));
+    if (Rows > TEXT_MAX_LINES) Rows = TEXT_MAX_LINES;
+
+    for (;;) {
+        int End = Pos, Start = Pos;
+        bool bFirst = true;
+
+        while (pText[End] && pText[End] != '\n') End++;
+        for (;;) {
+            TEXT_LINE *pLine;
+            int e, w;
+
+            while (Start < End && pText[Start] == ' ') Start++;
+            if (Start == End && !bFirst) break;
+            if (pLayout->nLines == Rows) {
+                pLayout->bTruncated = true;
+                goto Place;
+            }
+            e = BreakRow(pMetrics, pText, Start, End, Width, Flags, &w);
+            pLine = &pLayout->Lines[pLayout->nLines++];
+            pLine->Start = Start;
+            pLine->Len = e - Start;
+            pLine->Width = w;
+            if (w > Width) pLayout->bOverflow = true;
+            Start = e;
+            bFirst = false;
+        }
+        if (pText[End] != '\n') break;
+        Pos = End + 1;
+    }
+
+Place:
+    for (int i = 0, Top = 0; i < pLayout->nLines; i++) {
+        TEXT_LINE *pLine = &pLayout->Lines[i];
+        int Room = Width - pLine->Width;
+
+        if (i == 0 && (Flags & TEXT_MIDDLE))
+            Top = (Height - pLayout->nLines * pMetrics->LineHeight) / 2;
+        if (Room < 0) Room = 0;         // too wide: starts at the left edge
+        switch (Flags & TEXT_ALIGN_MASK) {
+        case TEXT_CENTER: pLine->X = Room / 2; break;
+        case TEXT_RIGHT:  pLine->X = Room; break;
+        default:          pLine->X = 0; break;
+        }
+        pLine->Y = Top + i * pMetrics->LineHeight;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef _TEXT_LAYOUT_H_
+#define _TEXT_LAYOUT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "font.h"
+
+// Text layout: breaks a whole message into the text rows of a box and
+// places each row left, centered or right-aligned, from the glyph
+// advances of the font (proportional fonts lay out tighter). The advances
+// are copied once per font into a TEXT_METRICS table; a TEXT_LAYOUT is
+// plain data (offsets into the text, positions, widths), so it can be
+// kept with the text and drawn again without measuring anything.
+//
+// '\n' always starts a new row; an empty paragraph is an empty row.
+// Spaces at a break are dropped. With TEXT_WRAP rows break between words
+// (inside a word only when it is wider than the box); without it each
+// paragraph is one row, which may be wider than the box (bOverflow).
+
+#define TEXT_MAX_LINES      8
+
+#define TEXT_LEFT           0x00
+#define TEXT_CENTER         0x01
+#define TEXT_RIGHT          0x02
+#define TEXT_ALIGN_MASK     0x03
+#define TEXT_WRAP           0x04
+#define TEXT_MIDDLE         0x08    // center the rows vertically in the box
+
+typedef struct {
+    const FONT_TABLE *pFont;
+    int      LineHeight;
+    uint8_t  Advance[256];
+} TEXT_METRICS;
+
+typedef struct {
+    uint16_t Start;         // offset into the text
+    uint16_t Len;
+    int16_t  X, Y;          // top left, box coordinates
+    int16_t  Width;
+} TEXT_LINE;
+
+typedef struct {
+    int       nLines;
+    bool      bTruncated;   // rows left over that did not fit the box
+    bool      bOverflow;    // a row is wider than the box
+    TEXT_LINE Lines[TEXT_MAX_LINES];
+} TEXT_LAYOUT;
+
+void TEXT_InitMetrics(TEXT_METRICS *pMetrics, const FONT_TABLE *pFont);
+int  TEXT_Width(const TEXT_METRICS *pMetrics, const char *pText, int Len);
+void TEXT_Layout(TEXT_LAYOUT *pLayout, const TEXT_METRICS *pMetrics, const char *pText,
+                 int Width, int Height, int Flags);
+
+#endif // _TEXT_LAYOUT_H_
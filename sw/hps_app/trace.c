@@ -0,0 +1,65 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "trace.h"
+
+static TRACE_EVENT gRing[TRACE_SIZE];
+static _Atomic uint64_t gHead;
+static char gThreads[TRACE_MAX_THREADS][16] = { "main" };
+static __thread uint8_t gThread;
+
+void TRACE_SetThread(int Id, const char *pName) {
+    if (Id < 0 || Id >= TRACE_MAX_THREADS) return;
+    gThread = (uint8_t)Id;
+    snprintf(gThreads[Id], sizeof(gThreads[Id]), "%s", pName);
+}
+
+void TRACE_Record(TRACE_TYPE Type, uint16_t A, uint32_t B) {
+    uint64_t slot = atomic_fetch_add_explicit(&gHead, 1, memory_order_relaxed);
+    TRACE_EVENT *pEvent = &gRing[slot & (TRACE_SIZE - 1)];
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    pEvent->Ns = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+    pEvent->B = B;
+    pEvent->A = A;
+    pEvent->Thread = gThread;
+    pEvent->Type = (uint8_t)Type;
+}
+
+bool TRACE_Dump(const char *pPath) {
+    TRACE_HEADER header;
+    uint64_t head = atomic_load_explicit(&gHead, memory_order_acquire);
+    uint64_t first = head > TRACE_SIZE ? head - TRACE_SIZE : 0;
+    FILE *fp = fopen(pPath, "wb");
+    bool ok;
+
+    if (!fp) {
+        perror("TRACE: cannot create dump");
+        return false;
+    }
+    memset(&header, 0, sizeof(header));
+    header.Magic = TRACE_MAGIC;
+    header.Version = TRACE_VERSION;
+    header.EventSize = sizeof(TRACE_EVENT);
+    header.Count = (uint32_t)(head - first);
+    header.Recorded = head;
+    memcpy(header.Threads, gThreads, sizeof(header.Threads));
+
+    // Oldest first: the ring from the write position on, then its start
+    ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (uint64_t i = first; ok && i < head; ) {
+        uint64_t at = i & (TRACE_SIZE - 1);
+        uint64_t n = TRACE_SIZE - at < head - i ? TRACE_SIZE - at : head - i;
+
+        ok = fwrite(&gRing[at], sizeof(TRACE_EVENT), n, fp) == n;
+        i += n;
+    }
+    ok = fclose(fp) == 0 && ok;
+    if (!ok) perror("TRACE: cannot write dump");
+    return ok;
+}
@@ -0,0 +1,72 @@
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Flight recorder for the hot paths: a preallocated ring of TRACE_SIZE
+// fixed 16-byte events, written without locks or system calls (a slot
+// is claimed with one atomic add, the time comes from the vDSO clock).
+// It always runs; when something goes wrong the last TRACE_SIZE events
+// are there to dump (TRACE_Dump), and lcd_trace2json turns a dump into
+// Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+//
+// The oldest events are overwritten. A dump taken while other threads
+// record may catch the newest one or two half written; they decode as
+// whatever they held before.
+
+#define TRACE_SIZE          8192        // events, a power of two
+#define TRACE_MAX_THREADS   4
+#define TRACE_MAGIC         0x4352544Cu // "LTRC"
+#define TRACE_VERSION       1
+
+// A and B per event type. "Begin"/"End" pairs become spans in the JSON.
+typedef enum {
+    TRACE_NONE = 0,
+    TRACE_REG_SAMPLE,       // A fsm_status, B timer_status
+    TRACE_TRANSITION,       // A new status byte (state << 5 | index), B previous
+    TRACE_RENDER_BEGIN,     // A state, B msg_index
+    TRACE_RENDER_END,
+    TRACE_TICK_BEGIN,       // marquee step
+    TRACE_TICK_END,
+    TRACE_STATUS_BEGIN,     // A seconds left
+    TRACE_STATUS_END,
+    TRACE_SPI_PAGE_BEGIN,   // A page, B column << 16 | length (PIO transfer)
+    TRACE_SPI_PAGE_END,
+    TRACE_DMA_SUBMIT,       // A descriptors, B bytes
+    TRACE_DMA_DONE,
+    TRACE_SPI_TIMEOUT,      // A where (TRACE_AT_*), B SPIM0 SR
+    TRACE_CLEAR_BEGIN,      // LCD_GraphicClear
+    TRACE_CLEAR_END,
+    TRACE_MARK,             // A, B: free for ad hoc use
+    TRACE_TYPES
+} TRACE_TYPE;
+
+// TRACE_SPI_TIMEOUT: which wait gave up
+enum { TRACE_AT_TX, TRACE_AT_TX_READY, TRACE_AT_BUSY, TRACE_AT_DC, TRACE_AT_FIFO, TRACE_AT_DRAIN, TRACE_AT_DMA };
+
+typedef struct {
+    uint64_t Ns;            // CLOCK_MONOTONIC
+    uint32_t B;
+    uint16_t A;
+    uint8_t  Type;
+    uint8_t  Thread;        // TRACE_SetThread id
+} TRACE_EVENT;
+
+// Dump file: this header, the thread names, then Count events oldest first
+typedef struct {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t EventSize;
+    uint32_t Count;
+    uint32_t Reserved;
+    uint64_t Recorded;      // ever, so Recorded - Count were overwritten
+    char     Threads[TRACE_MAX_THREADS][16];
+} TRACE_HEADER;
+
+// Names the calling thread in dumps; threads default to id 0
+void TRACE_SetThread(int Id, const char *pName);
+void TRACE_Record(TRACE_TYPE Type, uint16_t A, uint32_t B);
+bool TRACE_Dump(const char *pPath);
+
+#endif // _TRACE_H_